@@ -0,0 +1,352 @@
+// itmoscript_bench: runs every workloads/*.is script several times and reports
+// ns/op (one op = one full run of the script), heap allocations per op and
+// peak RSS as JSON. Peak RSS is measured in a child process that runs the
+// script once, so every workload gets its own high-water mark.
+//
+//   itmoscript_bench [--workloads DIR] [--iterations N] [--filter SUBSTR]
+//                    [--label TEXT] [--output FILE]
+//                    [--compare BASELINE.json] [--threshold PERCENT]
+//
+// With --compare the run is checked against an older JSON report; the exit
+// code is 2 if some workload got slower than --threshold percent (10 by default).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "interpreter.h"
+
+// allocation counting: every operator new of the process goes through here
+
+namespace{
+
+std::atomic<size_t> allocation_count{0};
+std::atomic<size_t> allocated_bytes{0};
+
+void* countedAllocate(size_t size){
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	if(void* ptr = std::malloc(size ? size : 1)){
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+}
+
+void* operator new(size_t size){
+	return countedAllocate(size);
+}
+
+void* operator new[](size_t size){
+	return countedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept{
+	std::free(ptr);
+}
+
+namespace{
+
+struct Options{
+	std::filesystem::path workloads = ITMOSCRIPT_BENCH_WORKLOADS;
+	int iterations = 5;
+	std::string filter;
+	std::string label;
+	std::string output;
+	std::string compare;
+	double threshold = 10;
+};
+
+struct Result{
+	std::string name;
+	double ns_per_op = 0;		// median
+	double min_ns = 0;
+	double allocations_per_op = 0;
+	double bytes_per_op = 0;
+	long peak_rss_kb = 0;
+};
+
+bool parseOptions(int argc, char** argv, Options& options){
+	for(int i = 1; i < argc; ++i){
+		std::string arg = argv[i];
+		auto value = [&]() -> std::string{
+			if(i + 1 >= argc){
+				throw std::invalid_argument("missing value for "+arg);
+			}
+			return argv[++i];
+		};
+
+		if(arg == "--workloads") options.workloads = value();
+		else if(arg == "--iterations") options.iterations = std::max(1, std::stoi(value()));
+		else if(arg == "--filter") options.filter = value();
+		else if(arg == "--label") options.label = value();
+		else if(arg == "--output") options.output = value();
+		else if(arg == "--compare") options.compare = value();
+		else if(arg == "--threshold") options.threshold = std::stod(value());
+		else{
+			std::cerr<<"Unknown option \""<<arg<<"\"\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool runScript(const std::string& source){
+	std::istringstream input(source);
+	std::ostringstream output;
+	return interpret(input, output);
+}
+
+std::string readSource(const std::filesystem::path& path){
+	std::ifstream file(path);
+	return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// high-water mark of a child process that runs the script once, in KiB (0 if unsupported).
+// The child starts with the RSS of this process at fork, so all workloads are
+// measured before this process runs any of them.
+bool measurePeakRss(const std::filesystem::path& path, long& peak_rss_kb){
+	peak_rss_kb = 0;
+#if defined(__unix__) || defined(__APPLE__)
+	std::string source = readSource(path);
+
+	pid_t pid = fork();
+	if(pid < 0){
+		std::cerr<<"Cannot fork for workload \""<<path.stem().string()<<"\"\n";
+		return false;
+	}
+	if(pid == 0){
+		_exit(runScript(source) ? 0 : 1);
+	}
+
+	int status = 0;
+	rusage usage{};
+	if(wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+		std::cerr<<"Workload \""<<path.stem().string()<<"\" failed\n";
+		return false;
+	}
+#if defined(__APPLE__)
+	peak_rss_kb = usage.ru_maxrss / 1024;
+#else
+	peak_rss_kb = usage.ru_maxrss;
+#endif
+#endif
+	return true;
+}
+
+bool runWorkload(const std::filesystem::path& path, int iterations, Result& result){
+	std::string source = readSource(path);
+
+	result.name = path.stem().string();
+
+	// warmup (and check that the script works at all)
+	if(!runScript(source)){
+		std::cerr<<"Workload \""<<result.name<<"\" failed\n";
+		return false;
+	}
+
+	std::vector<double> times;
+	size_t allocations_before = allocation_count.load(std::memory_order_relaxed);
+	size_t bytes_before = allocated_bytes.load(std::memory_order_relaxed);
+
+	for(int i = 0; i < iterations; ++i){
+		auto start = std::chrono::steady_clock::now();
+		bool ok = runScript(source);
+		auto finish = std::chrono::steady_clock::now();
+
+		if(!ok){
+			std::cerr<<"Workload \""<<result.name<<"\" failed on iteration "<<i + 1<<"\n";
+			return false;
+		}
+
+		times.push_back(std::chrono::duration<double, std::nano>(finish - start).count());
+	}
+
+	std::sort(times.begin(), times.end());
+	result.ns_per_op = times[times.size() / 2];
+	result.min_ns = times.front();
+	result.allocations_per_op = double(allocation_count.load(std::memory_order_relaxed) - allocations_before) / iterations;
+	result.bytes_per_op = double(allocated_bytes.load(std::memory_order_relaxed) - bytes_before) / iterations;
+
+	return true;
+}
+
+std::string escapeJson(const std::string& str){
+	std::string escaped;
+	for(char c : str){
+		if(c == '"' || c == '\\') escaped += '\\';
+		escaped += c;
+	}
+	return escaped;
+}
+
+void writeJson(std::ostream& out, const Options& options, const std::vector<Result>& results){
+	out<<std::fixed<<std::setprecision(1);
+	out<<"{\n";
+	out<<"  \"label\": \""<<escapeJson(options.label)<<"\",\n";
+	out<<"  \"iterations\": "<<options.iterations<<",\n";
+	out<<"  \"workloads\": [\n";
+
+	for(size_t i = 0; i < results.size(); ++i){
+		const Result& r = results[i];
+		out<<"    {\"name\": \""<<escapeJson(r.name)<<"\""
+			<<", \"ns_per_op\": "<<r.ns_per_op
+			<<", \"min_ns\": "<<r.min_ns
+			<<", \"allocations_per_op\": "<<r.allocations_per_op
+			<<", \"bytes_per_op\": "<<r.bytes_per_op
+			<<", \"peak_rss_kb\": "<<r.peak_rss_kb
+			<<"}"<<(i + 1 < results.size() ? "," : "")<<"\n";
+	}
+
+	out<<"  ]\n";
+	out<<"}\n";
+}
+
+// name -> ns_per_op of a report written by writeJson (one workload per line)
+std::map<std::string, double> readBaseline(const std::string& path){
+	std::map<std::string, double> baseline;
+	std::ifstream file(path);
+	std::string line;
+
+	const std::string name_key = "\"name\": \"";
+	const std::string time_key = "\"ns_per_op\": ";
+
+	while(std::getline(file, line)){
+		size_t name_pos = line.find(name_key);
+		size_t time_pos = line.find(time_key);
+		if(name_pos == std::string::npos || time_pos == std::string::npos){
+			continue;
+		}
+
+		name_pos += name_key.size();
+		std::string name = line.substr(name_pos, line.find('"', name_pos) - name_pos);
+		baseline[name] = std::stod(line.substr(time_pos + time_key.size()));
+	}
+
+	return baseline;
+}
+
+// returns false if something became slower than the threshold
+bool compare(const std::map<std::string, double>& baseline, const std::vector<Result>& results, double threshold){
+	bool ok = true;
+
+	std::cerr<<std::left<<std::setw(20)<<"workload"<<std::right<<std::setw(14)<<"baseline ms"<<std::setw(14)<<"current ms"<<std::setw(10)<<"change"<<"\n";
+	std::cerr<<std::fixed<<std::setprecision(2);
+
+	for(const Result& r : results){
+		auto it = baseline.find(r.name);
+		std::cerr<<std::left<<std::setw(20)<<r.name<<std::right;
+
+		if(it == baseline.end() || it->second <= 0){
+			std::cerr<<std::setw(14)<<"-"<<std::setw(14)<<r.ns_per_op / 1e6<<std::setw(10)<<"new"<<"\n";
+			continue;
+		}
+
+		double change = (r.ns_per_op / it->second - 1) * 100;
+		bool regression = change > threshold;
+		ok = ok && !regression;
+
+		std::cerr<<std::setw(14)<<it->second / 1e6<<std::setw(14)<<r.ns_per_op / 1e6
+			<<std::setw(9)<<std::showpos<<change<<std::noshowpos<<"%"
+			<<(regression ? "  REGRESSION" : "")<<"\n";
+	}
+
+	return ok;
+}
+
+}
+
+int main(int argc, char** argv){
+	Options options;
+	try{
+		if(!parseOptions(argc, argv, options)){
+			return 1;
+		}
+	}
+	catch(const std::exception& e){
+		std::cerr<<e.what()<<"\n";
+		return 1;
+	}
+
+	std::vector<std::filesystem::path> scripts;
+	std::error_code error;
+	for(const auto& entry : std::filesystem::directory_iterator(options.workloads, error)){
+		if(entry.path().extension() == ".is" && entry.path().stem().string().find(options.filter) != std::string::npos){
+			scripts.push_back(entry.path());
+		}
+	}
+	if(error || scripts.empty()){
+		std::cerr<<"No workloads in \""<<options.workloads.string()<<"\"\n";
+		return 1;
+	}
+	std::sort(scripts.begin(), scripts.end());
+
+	std::vector<long> peak_rss(scripts.size());
+	for(size_t i = 0; i < scripts.size(); ++i){
+		if(!measurePeakRss(scripts[i], peak_rss[i])){
+			return 1;
+		}
+	}
+
+	std::vector<Result> results;
+	for(size_t i = 0; i < scripts.size(); ++i){
+		Result result;
+		if(!runWorkload(scripts[i], options.iterations, result)){
+			return 1;
+		}
+		result.peak_rss_kb = peak_rss[i];
+		std::cerr<<result.name<<": "<<std::fixed<<std::setprecision(2)<<result.ns_per_op / 1e6<<" ms/op\n";
+		results.push_back(result);
+	}
+
+	if(options.output.empty()){
+		writeJson(std::cout, options, results);
+	}
+	else{
+		std::ofstream out(options.output);
+		writeJson(out, options, results);
+	}
+
+	if(!options.compare.empty()){
+		auto baseline = readBaseline(options.compare);
+		if(baseline.empty()){
+			std::cerr<<"Cannot read baseline \""<<options.compare<<"\"\n";
+			return 1;
+		}
+		if(!compare(baseline, results, options.threshold)){
+			return 2;
+		}
+	}
+
+	return 0;
+}
@@ -1,20 +1,44 @@
 #include <iostream>
+#include <fstream>
+#include <string_view>
 
-template <auto First, auto... KNum>
-struct MetaMax {
-    static const auto value = Knum < MetaMax<KNum...>::value ? MetaMax<KNum...>::value : Knum;
-};
-
-template <auto Num>
-struct MetaMax {
-    static const auto value = Num;
-};
-
-//только шаблоны, без constexpr
-int main(int argc, char** argv) {
-    //MetaMax<1, 2, 3, 0, -1, 5>::value; макс знач
-    int a = MetaMax<1, 2, 3, 0, -1, 5>::value; 
-    std::cout << a; 
-    return 0;
-}
+#include "interpreter.h"
+
+int main(int argc, char** argv){
+	bool memstats = false;
+	const char* path = nullptr;
+
+	for(int i = 1; i < argc; ++i){
+		if(std::string_view(argv[i]) == "--memstats"){
+			memstats = true;
+		}
+		else if(!path){
+			path = argv[i];
+		}
+		else{
+			path = nullptr;
+			break;
+		}
+	}
+
+	if(!path){
+		std::cerr<<"Usage: "<<argv[0]<<" [--memstats] <file.is>\n";
+		return 1;
+	}
 
+	std::ifstream source(path);
+	if(!source){
+		std::cerr<<"Cannot open \""<<path<<"\"\n";
+		return 1;
+	}
+
+	MemoryStats::trackLines(memstats);
+	bool ok = interpret(source, std::cout);
+
+	if(memstats){
+		std::cout.flush();
+		MemoryStats::report(std::cerr);
+	}
+
+	return ok ? 0 : 1;
+}
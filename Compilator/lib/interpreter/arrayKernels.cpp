@@ -0,0 +1,261 @@
+#include "arrayKernels.h"
+
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace array_kernels{
+
+namespace{
+
+#if defined(__AVX__)
+
+struct Simd{
+	using Reg = __m256d;
+	static constexpr size_t WIDTH = 4;
+
+	static Reg load(const double* p){ return _mm256_loadu_pd(p); }
+	static void store(double* p, Reg v){ _mm256_storeu_pd(p, v); }
+	static Reg broadcast(double s){ return _mm256_set1_pd(s); }
+	static Reg zero(){ return _mm256_setzero_pd(); }
+
+	static Reg add(Reg a, Reg b){ return _mm256_add_pd(a, b); }
+	static Reg sub(Reg a, Reg b){ return _mm256_sub_pd(a, b); }
+	static Reg mul(Reg a, Reg b){ return _mm256_mul_pd(a, b); }
+	static Reg div(Reg a, Reg b){ return _mm256_div_pd(a, b); }
+	static Reg min(Reg a, Reg b){ return _mm256_min_pd(a, b); }
+	static Reg max(Reg a, Reg b){ return _mm256_max_pd(a, b); }
+
+	static bool anyZero(Reg v){
+		return _mm256_movemask_pd(_mm256_cmp_pd(v, zero(), _CMP_EQ_OQ)) != 0;
+	}
+
+	static void spill(Reg v, double* out){ _mm256_storeu_pd(out, v); }
+};
+
+#elif defined(__SSE2__)
+
+struct Simd{
+	using Reg = __m128d;
+	static constexpr size_t WIDTH = 2;
+
+	static Reg load(const double* p){ return _mm_loadu_pd(p); }
+	static void store(double* p, Reg v){ _mm_storeu_pd(p, v); }
+	static Reg broadcast(double s){ return _mm_set1_pd(s); }
+	static Reg zero(){ return _mm_setzero_pd(); }
+
+	static Reg add(Reg a, Reg b){ return _mm_add_pd(a, b); }
+	static Reg sub(Reg a, Reg b){ return _mm_sub_pd(a, b); }
+	static Reg mul(Reg a, Reg b){ return _mm_mul_pd(a, b); }
+	static Reg div(Reg a, Reg b){ return _mm_div_pd(a, b); }
+	static Reg min(Reg a, Reg b){ return _mm_min_pd(a, b); }
+	static Reg max(Reg a, Reg b){ return _mm_max_pd(a, b); }
+
+	static bool anyZero(Reg v){
+		return _mm_movemask_pd(_mm_cmpeq_pd(v, zero())) != 0;
+	}
+
+	static void spill(Reg v, double* out){ _mm_storeu_pd(out, v); }
+};
+
+#else
+
+// no vector unit: the same interface over a single double
+struct Simd{
+	using Reg = double;
+	static constexpr size_t WIDTH = 1;
+
+	static Reg load(const double* p){ return *p; }
+	static void store(double* p, Reg v){ *p = v; }
+	static Reg broadcast(double s){ return s; }
+	static Reg zero(){ return 0.0; }
+
+	static Reg add(Reg a, Reg b){ return a + b; }
+	static Reg sub(Reg a, Reg b){ return a - b; }
+	static Reg mul(Reg a, Reg b){ return a * b; }
+	static Reg div(Reg a, Reg b){ return a / b; }
+	static Reg min(Reg a, Reg b){ return b < a ? b : a; }
+	static Reg max(Reg a, Reg b){ return a < b ? b : a; }
+
+	static bool anyZero(Reg v){ return v == 0.0; }
+
+	static void spill(Reg v, double* out){ *out = v; }
+};
+
+#endif
+
+template<Op op>
+Simd::Reg vop(Simd::Reg a, Simd::Reg b){
+	if constexpr(op == Op::kAdd) return Simd::add(a, b);
+	if constexpr(op == Op::kSub) return Simd::sub(a, b);
+	if constexpr(op == Op::kMul) return Simd::mul(a, b);
+	if constexpr(op == Op::kDiv) return Simd::div(a, b);
+}
+
+template<Op op>
+double sop(double a, double b){
+	if constexpr(op == Op::kAdd) return a + b;
+	if constexpr(op == Op::kSub) return a - b;
+	if constexpr(op == Op::kMul) return a * b;
+	if constexpr(op == Op::kDiv) return a / b;
+}
+
+template<Op op>
+void kernel(const double* a, const double* b, double* out, size_t n){
+	size_t i = 0;
+	for(; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+		Simd::store(out + i, vop<op>(Simd::load(a + i), Simd::load(b + i)));
+	}
+	for(; i < n; ++i){
+		out[i] = sop<op>(a[i], b[i]);
+	}
+}
+
+template<Op op>
+void kernelScalarRight(const double* a, double s, double* out, size_t n){
+	const Simd::Reg sv = Simd::broadcast(s);
+
+	size_t i = 0;
+	for(; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+		Simd::store(out + i, vop<op>(Simd::load(a + i), sv));
+	}
+	for(; i < n; ++i){
+		out[i] = sop<op>(a[i], s);
+	}
+}
+
+template<Op op>
+void kernelScalarLeft(double s, const double* a, double* out, size_t n){
+	const Simd::Reg sv = Simd::broadcast(s);
+
+	size_t i = 0;
+	for(; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+		Simd::store(out + i, vop<op>(sv, Simd::load(a + i)));
+	}
+	for(; i < n; ++i){
+		out[i] = sop<op>(s, a[i]);
+	}
+}
+
+// horizontal reduction of one register with a scalar combiner
+template<typename Combine>
+double reduceLanes(Simd::Reg v, double init, Combine combine){
+	double lanes[Simd::WIDTH];
+	Simd::spill(v, lanes);
+
+	double acc = init;
+	for(size_t i = 0; i < Simd::WIDTH; ++i){
+		acc = combine(acc, lanes[i]);
+	}
+	return acc;
+}
+
+}
+
+void apply(Op op, const double* a, const double* b, double* out, size_t n){
+	switch(op){
+		case Op::kAdd: kernel<Op::kAdd>(a, b, out, n); break;
+		case Op::kSub: kernel<Op::kSub>(a, b, out, n); break;
+		case Op::kMul: kernel<Op::kMul>(a, b, out, n); break;
+		case Op::kDiv: kernel<Op::kDiv>(a, b, out, n); break;
+	}
+}
+
+void applyScalarRight(Op op, const double* a, double s, double* out, size_t n){
+	switch(op){
+		case Op::kAdd: kernelScalarRight<Op::kAdd>(a, s, out, n); break;
+		case Op::kSub: kernelScalarRight<Op::kSub>(a, s, out, n); break;
+		case Op::kMul: kernelScalarRight<Op::kMul>(a, s, out, n); break;
+		case Op::kDiv: kernelScalarRight<Op::kDiv>(a, s, out, n); break;
+	}
+}
+
+void applyScalarLeft(Op op, double s, const double* a, double* out, size_t n){
+	switch(op){
+		case Op::kAdd: kernelScalarLeft<Op::kAdd>(s, a, out, n); break;
+		case Op::kSub: kernelScalarLeft<Op::kSub>(s, a, out, n); break;
+		case Op::kMul: kernelScalarLeft<Op::kMul>(s, a, out, n); break;
+		case Op::kDiv: kernelScalarLeft<Op::kDiv>(s, a, out, n); break;
+	}
+}
+
+double sum(const double* a, size_t n){
+	Simd::Reg acc = Simd::zero();
+
+	size_t i = 0;
+	for(; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+		acc = Simd::add(acc, Simd::load(a + i));
+	}
+
+	double result = reduceLanes(acc, 0.0, [](double x, double y){ return x + y; });
+	for(; i < n; ++i){
+		result += a[i];
+	}
+	return result;
+}
+
+double min(const double* a, size_t n){
+	size_t i = 0;
+	double result = a[0];
+
+	if(n >= Simd::WIDTH){
+		Simd::Reg acc = Simd::load(a);
+		for(i = Simd::WIDTH; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+			acc = Simd::min(acc, Simd::load(a + i));
+		}
+		result = reduceLanes(acc, result, [](double x, double y){ return std::min(x, y); });
+	}
+
+	for(; i < n; ++i){
+		result = std::min(result, a[i]);
+	}
+	return result;
+}
+
+double max(const double* a, size_t n){
+	size_t i = 0;
+	double result = a[0];
+
+	if(n >= Simd::WIDTH){
+		Simd::Reg acc = Simd::load(a);
+		for(i = Simd::WIDTH; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+			acc = Simd::max(acc, Simd::load(a + i));
+		}
+		result = reduceLanes(acc, result, [](double x, double y){ return std::max(x, y); });
+	}
+
+	for(; i < n; ++i){
+		result = std::max(result, a[i]);
+	}
+	return result;
+}
+
+double dot(const double* a, const double* b, size_t n){
+	Simd::Reg acc = Simd::zero();
+
+	size_t i = 0;
+	for(; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+		acc = Simd::add(acc, Simd::mul(Simd::load(a + i), Simd::load(b + i)));
+	}
+
+	double result = reduceLanes(acc, 0.0, [](double x, double y){ return x + y; });
+	for(; i < n; ++i){
+		result += a[i] * b[i];
+	}
+	return result;
+}
+
+bool containsZero(const double* a, size_t n){
+	size_t i = 0;
+	for(; i + Simd::WIDTH <= n; i += Simd::WIDTH){
+		if(Simd::anyZero(Simd::load(a + i))) return true;
+	}
+	for(; i < n; ++i){
+		if(a[i] == 0.0) return true;
+	}
+	return false;
+}
+
+}
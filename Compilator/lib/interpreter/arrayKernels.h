@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// Element-wise kernels for ArrayType (contiguous doubles).
+// Built with SSE2/AVX intrinsics when the target supports them, plain loops otherwise.
+namespace array_kernels{
+
+enum class Op{
+	kAdd,
+	kSub,
+	kMul,
+	kDiv
+};
+
+// out[i] = a[i] op b[i]
+void apply(Op op, const double* a, const double* b, double* out, size_t n);
+
+// out[i] = a[i] op s
+void applyScalarRight(Op op, const double* a, double s, double* out, size_t n);
+
+// out[i] = s op a[i]
+void applyScalarLeft(Op op, double s, const double* a, double* out, size_t n);
+
+// reductions
+double sum(const double* a, size_t n);
+double min(const double* a, size_t n);	// n > 0
+double max(const double* a, size_t n);	// n > 0
+double dot(const double* a, const double* b, size_t n);
+
+bool containsZero(const double* a, size_t n);
+
+}
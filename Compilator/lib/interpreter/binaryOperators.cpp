@@ -1,6 +1,88 @@
 #include "interpreter.h"
 
+Value Interpreter::arrayArithmetic(array_kernels::Op op, const std::string& operation, const Value& left, const Value& right){
+	auto result = makeTracked<ArrayType>();
+
+	if(left.getType() == ValueType::kArray && right.getType() == ValueType::kArray){
+		const ArrayType& a = *left.asArray();
+		const ArrayType& b = *right.asArray();
+
+		if(a.size() != b.size()){
+			ErrorManager(operation, "arrays must have the same length ("+std::to_string(a.size())+" and "+std::to_string(b.size())+")");
+		}
+		if(op == array_kernels::Op::kDiv && array_kernels::containsZero(b.data(), b.size())){
+			ErrorManager(operation, "division by zero");
+		}
+
+		result->resize(a.size());
+		array_kernels::apply(op, a.data(), b.data(), result->data(), a.size());
+
+		return Value(result);
+	}
+
+	if(left.getType() == ValueType::kArray && right.getType() == ValueType::kDouble){
+		const ArrayType& a = *left.asArray();
+		double s = right.asNumber();
+
+		if(op == array_kernels::Op::kDiv && s == 0){
+			ErrorManager(operation, "division by zero");
+		}
+
+		result->resize(a.size());
+		array_kernels::applyScalarRight(op, a.data(), s, result->data(), a.size());
+
+		return Value(result);
+	}
+
+	if(left.getType() == ValueType::kDouble && right.getType() == ValueType::kArray){
+		double s = left.asNumber();
+		const ArrayType& a = *right.asArray();
+
+		if(op == array_kernels::Op::kDiv && array_kernels::containsZero(a.data(), a.size())){
+			ErrorManager(operation, "division by zero");
+		}
+
+		result->resize(a.size());
+		array_kernels::applyScalarLeft(op, s, a.data(), result->data(), a.size());
+
+		return Value(result);
+	}
+
+	ErrorManager(operation, left, right);
+	return Value();
+}
+
+Value Interpreter::numericOperator(TokenType type, double left, double right){
+	switch(type){
+		case TokenType::tPlus: return Value(left + right);
+		case TokenType::tMinus: return Value(left - right);
+		case TokenType::tMultiply: return Value(left * right);
+		case TokenType::tDivide:
+			if(right == 0){
+				ErrorManager("divide (/)", "division by zero");
+			}
+			return Value(left / right);
+		case TokenType::tModule: return Value(std::fmod(left, right));
+		case TokenType::tPower: return Value(std::pow(left, right));
+
+		case TokenType::tEqual: return Value(left == right);
+		case TokenType::tNotEqual: return Value(left != right);
+		case TokenType::tLess: return Value(left < right);
+		case TokenType::tGreater: return Value(left > right);
+		case TokenType::tLessOrEqual: return Value(left <= right);
+		case TokenType::tGreaterOrEqual: return Value(left >= right);
+		default: break;
+	}
+
+	ErrorManager("numericOperator");
+	return Value();
+}
+
 Value Interpreter::add(const Value& left, const Value& right){
+	if(left.getType() == ValueType::kArray || right.getType() == ValueType::kArray){
+		return arrayArithmetic(array_kernels::Op::kAdd, "add (+)", left, right);
+	}
+
 	if(left.getType() == ValueType::kDouble && right.getType() == ValueType::kDouble){
 		return Value(left.asNumber() + right.asNumber());
 	}
@@ -10,7 +92,7 @@ Value Interpreter::add(const Value& left, const Value& right){
 	}
 
 	if(left.getType() == ValueType::kList && right.getType() == ValueType::kList){
-		auto new_list_ptr = std::make_shared<ListType>(*left.asList());
+		auto new_list_ptr = makeTracked<ListType>(*left.asList());
 		new_list_ptr->insert(new_list_ptr->end(), right.asList()->begin(), right.asList()->end());
 		return Value(new_list_ptr);
 	}
@@ -20,6 +102,10 @@ Value Interpreter::add(const Value& left, const Value& right){
 }
 
 Value Interpreter::subtract(const Value& left, const Value& right){
+	if(left.getType() == ValueType::kArray || right.getType() == ValueType::kArray){
+		return arrayArithmetic(array_kernels::Op::kSub, "subtract (-)", left, right);
+	}
+
 	if(left.getType() == ValueType::kDouble && right.getType() == ValueType::kDouble){
 		return Value(left.asNumber() - right.asNumber());
 	}
@@ -40,6 +126,10 @@ Value Interpreter::subtract(const Value& left, const Value& right){
 }
 
 Value Interpreter::multiply(const Value& left, const Value& right){
+	if(left.getType() == ValueType::kArray || right.getType() == ValueType::kArray){
+		return arrayArithmetic(array_kernels::Op::kMul, "multiply (*)", left, right);
+	}
+
 	Value l = left;
 	Value r = right;
 
@@ -62,7 +152,7 @@ Value Interpreter::multiply(const Value& left, const Value& right){
 				return Value("");
 			}
 			else if(r.getType() == ValueType::kList){
-				return Value(std::make_shared<ListType>());
+				return Value(makeTracked<ListType>());
 			}
 			else{
 				ErrorManager("multiply (*)", left, right);
@@ -94,7 +184,7 @@ Value Interpreter::multiply(const Value& left, const Value& right){
 						size_t slice_len = static_cast<size_t>(std::ceil(r.asList()->size() * frac_part));
 
 						if(slice_len > 0){
-							auto slice_list = std::make_shared<ListType>();
+							auto slice_list = makeTracked<ListType>();
 							slice_list->reserve(slice_len);
 
 							for(size_t i=0; i < slice_len; ++i){
@@ -123,7 +213,7 @@ Value Interpreter::multiply(const Value& left, const Value& right){
 				return Value("");
 			}
 			else if(l.getType() == ValueType::kList){
-				return Value(std::make_shared<ListType>());
+				return Value(makeTracked<ListType>());
 			}
 			else{
 				ErrorManager("multiply (*)", left, right);
@@ -155,7 +245,7 @@ Value Interpreter::multiply(const Value& left, const Value& right){
 						size_t slice_len = static_cast<size_t>(std::ceil(l.asList()->size() * frac_part));
 
 						if(slice_len > 0){
-							auto slice_list = std::make_shared<ListType>();
+							auto slice_list = makeTracked<ListType>();
 							slice_list->reserve(slice_len);
 
 							for(size_t i=0; i < slice_len; ++i){
@@ -181,6 +271,10 @@ Value Interpreter::multiply(const Value& left, const Value& right){
 }
 
 Value Interpreter::divide(const Value& left, const Value& right){
+	if(left.getType() == ValueType::kArray || right.getType() == ValueType::kArray){
+		return arrayArithmetic(array_kernels::Op::kDiv, "divide (/)", left, right);
+	}
+
 	if(left.getType() == ValueType::kDouble && right.getType() == ValueType::kDouble){
 		if(right.asNumber() == 0){
 			ErrorManager("divide (/)", "division by zero");
@@ -244,6 +338,15 @@ Value Interpreter::equal(const Value& left, const Value& right, bool isnot){
 
 		case ValueType::kFunc:
 			return Value(left.asFunction().get() == right.asFunction().get());
+
+		case ValueType::kArray:
+			return Value(*left.asArray() == *right.asArray());
+
+		case ValueType::kChannel:
+			return Value(left.asChannel().get() == right.asChannel().get());
+
+		case ValueType::kFile:
+			return Value(left.asFile().get() == right.asFile().get());
 	}
 
 	if(isnot) ErrorManager("not equal (!=)", left, right);
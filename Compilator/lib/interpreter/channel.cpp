@@ -0,0 +1,33 @@
+#include "channel.h"
+
+#include "errorManager.h"
+
+void Channel::send(Value value){
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::move(value));
+	}
+	m_ready.notify_one();
+}
+
+Value Channel::receive(){
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_ready.wait(lock, [this]{ return !m_queue.empty() || m_error; });
+
+	if(m_queue.empty()){
+		ErrorManager("recv", "spawned function failed: "+*m_error);
+	}
+
+	Value value = std::move(m_queue.front());
+	m_queue.pop_front();
+
+	return value;
+}
+
+void Channel::fail(const std::string& message){
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_error = message;
+	}
+	m_ready.notify_all();
+}
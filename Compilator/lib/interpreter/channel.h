@@ -0,0 +1,29 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <string>
+
+#include "value.h"
+
+// FIFO between isolates. Values stored here are already detached
+// (deep copies owned by nobody else), see Interpreter::detach.
+class Channel{
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_ready;
+	std::deque<Value> m_queue;
+
+	// set when the spawned function behind a result channel failed
+	std::optional<std::string> m_error;
+
+public:
+	void send(Value value);
+
+	// blocks until a value (or the failure of the producer) arrives
+	Value receive();
+
+	void fail(const std::string& message);
+};
@@ -11,6 +11,9 @@ private:
 			case ValueType::kBool: return "Bool type";
 			case ValueType::kNil: return "Nil type";
 			case ValueType::kFunc: return "Function type";
+			case ValueType::kArray: return "Array type";
+			case ValueType::kChannel: return "Channel type";
+			case ValueType::kFile: return "File type";
 			default: return "";
 		}
 	}
@@ -45,6 +48,11 @@ public:
 		throw std::runtime_error(formatError(function, "expected " + std::to_string(expected) + " argument(s), got " + std::to_string(received)));
 	}
 
+	// function with optional arguments: argument count error
+	ErrorManager(const std::string& function, size_t min_expected, size_t max_expected, size_t received){
+		throw std::runtime_error(formatError(function, "expected " + std::to_string(min_expected) + "-" + std::to_string(max_expected) + " arguments, got " + std::to_string(received)));
+	}
+
 	// function argument type error
 	ErrorManager(const std::string& function, size_t argIndex, const std::string& expectedType, ValueType receivedType){
 		throw std::runtime_error(formatError(function, "argument " + std::to_string(argIndex + 1) + " must be " + expectedType + ", got " + getTypeName(receivedType)));
@@ -0,0 +1,261 @@
+#include "file.h"
+
+#include "value.h"
+#include "errorManager.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <exception>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ITMOSCRIPT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+File::File(const std::string& path, const std::string& mode)
+	: m_path(path)
+{
+	if(mode == "w" || mode == "a"){
+		m_stream = std::fopen(path.c_str(), mode == "w" ? "wb" : "ab");
+		if(!m_stream){
+			ErrorManager("open", "cannot open \""+path+"\" for writing");
+		}
+		m_writable = true;
+		m_buffer.reserve(WRITE_BUFFER_SIZE);
+		return;
+	}
+
+	if(mode != "r"){
+		ErrorManager("open", "mode must be \"r\", \"w\" or \"a\", not \""+mode+"\"");
+	}
+
+#ifdef ITMOSCRIPT_MMAP
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0){
+		ErrorManager("open", "cannot open \""+path+"\"");
+	}
+
+	struct stat info{};
+	if(fstat(fd, &info) != 0 || S_ISDIR(info.st_mode)){
+		::close(fd);
+		ErrorManager("open", "\""+path+"\" is not a file");
+	}
+
+	if(S_ISREG(info.st_mode) && info.st_size > 0){
+		size_t size = static_cast<size_t>(info.st_size);
+		void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if(mapping != MAP_FAILED){
+			::close(fd);
+			// читаем последовательно
+			madvise(mapping, size, MADV_SEQUENTIAL);
+
+			m_mapping = mapping;
+			m_data = static_cast<const char*>(mapping);
+			m_size = size;
+			return;
+		}
+		if(errno != ENODEV && errno != EINVAL){
+			::close(fd);
+			ErrorManager("open", "cannot map \""+path+"\"");
+		}
+	}
+
+	// каналы, FIFO, /dev/stdin и файлы без размера (/proc) не отображаются:
+	// читаем по кускам через read(), по мере надобности
+	m_fd = fd;
+#else
+	std::ifstream input(path, std::ios::binary);
+	if(!input){
+		ErrorManager("open", "cannot open \""+path+"\"");
+	}
+	m_contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+#endif
+
+	m_data = m_contents.data();
+	m_size = m_contents.size();
+}
+
+File::~File(){
+	// ошибки при закрытии в деструкторе уже некому сообщить
+	try{
+		close();
+	}
+	catch(...){}
+}
+
+const std::string& File::path() const{
+	return m_path;
+}
+
+bool File::isWritable() const{
+	return m_writable;
+}
+
+void File::checkOpen(const char* operation) const{
+	if(m_closed){
+		ErrorManager(operation, "file \""+m_path+"\" is closed");
+	}
+}
+
+void File::fill(const char* operation){
+#ifdef ITMOSCRIPT_MMAP
+	// отданные строки уже скопированы, держим только непрочитанное
+	m_contents.erase(0, m_position);
+	m_position = 0;
+
+	size_t old_size = m_contents.size();
+	m_contents.resize(old_size + READ_CHUNK_SIZE);
+
+	ssize_t count;
+	do{
+		count = ::read(m_fd, m_contents.data() + old_size, READ_CHUNK_SIZE);
+	} while(count < 0 && errno == EINTR);
+
+	m_contents.resize(old_size + static_cast<size_t>(std::max<ssize_t>(count, 0)));
+	m_data = m_contents.data();
+	m_size = m_contents.size();
+
+	if(count < 0){
+		ErrorManager(operation, "cannot read \""+m_path+"\"");
+	}
+	if(count == 0){
+		::close(m_fd);
+		m_fd = -1;
+	}
+#else
+	(void)operation;
+	m_fd = -1;
+#endif
+}
+
+std::optional<std::string_view> File::readLine(){
+	checkOpen("read_line");
+	if(m_writable){
+		ErrorManager("read_line", "file \""+m_path+"\" is opened for writing");
+	}
+
+	// из потока строка приходит кусками: дочитываем до '\n' или до конца
+	size_t scanned = 0;
+	while(m_fd >= 0 && std::string_view(m_data + m_position, m_size - m_position).find('\n', scanned) == std::string_view::npos){
+		scanned = m_size - m_position;
+		fill("read_line");
+	}
+
+	if(m_position >= m_size){
+		return std::nullopt;
+	}
+
+	std::string_view rest(m_data + m_position, m_size - m_position);
+	size_t end = rest.find('\n');
+
+	std::string_view line = rest.substr(0, end);
+	m_position += (end == std::string_view::npos ? rest.size() : end + 1);
+
+	if(!line.empty() && line.back() == '\r'){
+		line.remove_suffix(1);
+	}
+	return line;
+}
+
+std::string_view File::readAll(){
+	checkOpen("read_all");
+	if(m_writable){
+		ErrorManager("read_all", "file \""+m_path+"\" is opened for writing");
+	}
+
+	while(m_fd >= 0){
+		fill("read_all");
+	}
+
+	std::string_view rest(m_data + m_position, m_size - m_position);
+	m_position = m_size;
+	return rest;
+}
+
+void File::write(std::string_view data){
+	checkOpen("write");
+	if(!m_writable){
+		ErrorManager("write", "file \""+m_path+"\" is opened for reading");
+	}
+
+	if(m_buffer.size() + data.size() > WRITE_BUFFER_SIZE){
+		flush();
+	}
+
+	// большие куски мимо буфера
+	if(data.size() >= WRITE_BUFFER_SIZE){
+		if(std::fwrite(data.data(), 1, data.size(), m_stream) != data.size()){
+			ErrorManager("write", "cannot write to \""+m_path+"\"");
+		}
+		return;
+	}
+
+	m_buffer.append(data);
+}
+
+void File::flush(){
+	if(!m_stream || m_buffer.empty()){
+		return;
+	}
+
+	size_t size = m_buffer.size();
+	size_t written = std::fwrite(m_buffer.data(), 1, size, m_stream);
+	m_buffer.clear();
+
+	if(written != size){
+		ErrorManager("write", "cannot write to \""+m_path+"\"");
+	}
+}
+
+void File::close(){
+	if(m_closed){
+		return;
+	}
+
+	m_closed = true;
+
+	// файл закрываем, даже если дописать буфер не вышло (например, диск полон)
+	std::exception_ptr error;
+	try{
+		flush();
+	}
+	catch(...){
+		error = std::current_exception();
+	}
+
+#ifdef ITMOSCRIPT_MMAP
+	if(m_fd >= 0){
+		::close(m_fd);
+		m_fd = -1;
+	}
+#endif
+
+	bool close_failed = false;
+	if(m_stream){
+		close_failed = std::fclose(m_stream) != 0;
+		m_stream = nullptr;
+	}
+
+#ifdef ITMOSCRIPT_MMAP
+	if(m_mapping){
+		munmap(m_mapping, m_size);
+		m_mapping = nullptr;
+	}
+#endif
+	m_data = nullptr;
+	m_size = m_position = 0;
+	m_contents.clear();
+
+	if(error){
+		std::rethrow_exception(error);
+	}
+	if(close_failed){
+		ErrorManager("close", "cannot write to \""+m_path+"\"");
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// File handle of open(). Reading maps the whole file into memory (mmap where
+// available) and hands out lines as views, so only the lines a script actually
+// looks at become Value strings. Pipes and other files that cannot be mapped
+// are read in chunks as lines are requested; a view stays valid until the next
+// read. Writing goes through a large buffer.
+class File{
+private:
+	std::string m_path;
+	bool m_writable = false;
+	bool m_closed = false;
+
+	// reading
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_position = 0;
+	void* m_mapping = nullptr;		// mmap
+	std::string m_contents;			// no mmap: what has been read and not consumed yet
+	int m_fd = -1;					// stream not read to the end yet (pipe, FIFO, /dev/stdin)
+
+	// writing
+	std::FILE* m_stream = nullptr;
+	std::string m_buffer;
+
+	void checkOpen(const char* operation) const;
+
+	// next chunk of m_fd into m_contents, closes m_fd at the end
+	void fill(const char* operation);
+
+public:
+	static constexpr size_t WRITE_BUFFER_SIZE = 1 << 20;
+	static constexpr size_t READ_CHUNK_SIZE = 1 << 16;
+
+	// mode: "r", "w" or "a"
+	File(const std::string& path, const std::string& mode);
+	~File();
+
+	File(const File&) = delete;
+	File& operator=(const File&) = delete;
+
+	const std::string& path() const;
+	bool isWritable() const;
+
+	// next line without '\n' (and '\r'), nullopt at the end
+	std::optional<std::string_view> readLine();
+
+	// everything from the current position
+	std::string_view readAll();
+
+	void write(std::string_view data);
+	void flush();
+	void close();
+};
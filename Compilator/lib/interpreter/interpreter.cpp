@@ -1,6 +1,7 @@
 #include "interpreter.h"
 
 #include "errorManager.h"
+#include "file.h"
 #include "../parser/ASTNode.h"
 
 #include <iostream>
@@ -11,6 +12,8 @@ Value Interpreter::evaluate(const ASTNode* node){
 }
 
 void Interpreter::visitAndExecute(const StatementNode* node){
+	// allocations are attributed to the innermost statement (--memstats)
+	MemoryStats::LineGuard line(node->line);
 	node->accept(*this);
 }
 
@@ -101,8 +104,8 @@ void Interpreter::visit(const WhileStatementNode* node){
 void Interpreter::visit(const ForStatementNode* node){
 	Value iterable_value = evaluate(node->iterable.get());
 
-	if(iterable_value.getType() != ValueType::kList && iterable_value.getType() != ValueType::kString){
-		ErrorManager("ForStatementNode", "for loop can only iterate over lists and strings, not "+iterable_value.toString()+".");
+	if(iterable_value.getType() != ValueType::kList && iterable_value.getType() != ValueType::kString && iterable_value.getType() != ValueType::kArray && iterable_value.getType() != ValueType::kFile){
+		ErrorManager("ForStatementNode", "for loop can only iterate over lists, arrays, strings and files, not "+iterable_value.toString()+".");
 	}
 
 	pushCall("for (line "+std::to_string(node->line)+")");
@@ -124,6 +127,22 @@ void Interpreter::visit(const ForStatementNode* node){
 				}
 			}
 		}
+		// kArray
+		else if(iterable_value.getType() == ValueType::kArray){
+			auto array = iterable_value.asArray();
+			for(size_t i = 0; i < array->size(); ++i){
+				auto body_env = std::make_shared<Scope>(m_current_scope);
+
+				body_env->define(node->loopVariable->name, Value((*array)[i]));
+
+				try{
+					executeBlock(node->body.get(), body_env);
+				}
+				catch(const ContinueSignal&){
+					continue;
+				}
+			}
+		}
 		// kString
 		else if(iterable_value.getType() == ValueType::kString){
 			const auto& str = *iterable_value.asString();
@@ -132,6 +151,22 @@ void Interpreter::visit(const ForStatementNode* node){
 
 				body_env->define(node->loopVariable->name, Value(std::string(1, c)));
 
+				try{
+					executeBlock(node->body.get(), body_env);
+				}
+				catch(const ContinueSignal&){
+					continue;
+				}
+			}
+		}
+		// kFile: строки читаются по одной, весь файл не материализуется
+		else if(iterable_value.getType() == ValueType::kFile){
+			auto file = iterable_value.asFile();
+			while(auto line = file->readLine()){
+				auto body_env = std::make_shared<Scope>(m_current_scope);
+
+				body_env->define(node->loopVariable->name, Value(std::string(*line)));
+
 				try{
 					executeBlock(node->body.get(), body_env);
 				}
@@ -171,7 +206,7 @@ Value Interpreter::visit(const IdentifierNode* node){
 }
 
 Value Interpreter::visit(const ListLiteralNode* node){
-	auto list_values = std::make_shared<ListType>();
+	auto list_values = makeTracked<ListType>();
 
 	for(const auto& elem_node : node->elements){
 		if(elem_node){
@@ -186,12 +221,23 @@ Value Interpreter::visit(const ListLiteralNode* node){
 }
 
 Value Interpreter::visit(const FunctionLiteralNode* node){
-	auto func = std::make_shared<Function>([this, node](const std::vector<Value>& args){
+	return makeFunction(node);
+}
+
+Value Interpreter::makeFunction(const FunctionLiteralNode* node){
+	auto func = makeTracked<Function>([this, node](const std::vector<Value>& args){
 		
 		if(args.size() != node->parameters.size()){
 			ErrorManager("FunctionLiteralNode", "args size hz");
 		}
 
+#ifdef ITMOSCRIPT_JIT
+		Value native_result;
+		if(m_jit.tryCall(node, args, *m_current_scope, native_result)){
+			return native_result;
+		}
+#endif
+
 		auto new_scope = std::make_shared<Scope>(m_current_scope);
 
 		for(size_t i=0; i < args.size() && i < node->parameters.size(); ++i){
@@ -212,7 +258,7 @@ Value Interpreter::visit(const FunctionLiteralNode* node){
 		m_current_scope = old_scope;
 
 		return result;
-	});
+	}, node);
 
 	return Value(func);
 }
@@ -231,6 +277,13 @@ void Interpreter::visit(const ContinueStatementNode* node){
 }
 
 Value Interpreter::visit(const BinaryOpNode* node){
+	// типы известны заранее (typeInference), проверки не нужны
+	if(node->numeric_operands){
+		double left = evaluate(node->left.get()).asNumber();
+		double right = evaluate(node->right.get()).asNumber();
+		return numericOperator(node->op, left, right);
+	}
+
 	Value left = evaluate(node->left.get());
 
 	if(node->op == TokenType::tAnd){
@@ -323,7 +376,12 @@ Value Interpreter::visit(const AssignmentNode* node){
 				default:
 					ErrorManager("AssignmentNode");
 			}
-			rvalue = applyBinaryOperator(type, lvalue, rvalue);
+			if(id_node->static_type == ValueType::kDouble && node->expression_r->static_type == ValueType::kDouble){
+				rvalue = numericOperator(type, lvalue.asNumber(), rvalue.asNumber());
+			}
+			else{
+				rvalue = applyBinaryOperator(type, lvalue, rvalue);
+			}
 			m_current_scope->assign(id_node->name, rvalue);
 		}
 		return rvalue;
@@ -334,8 +392,10 @@ Value Interpreter::visit(const AssignmentNode* node){
 		Value object_val = evaluate(index_expr_node->object.get());
 		Value index_val = evaluate(index_expr_node->index.get());
 
+		bool numeric_index = index_expr_node->index->static_type == ValueType::kDouble;
+
 		if(object_val.getType() == ValueType::kList){
-			if(index_val.getType() != ValueType::kDouble){
+			if(!numeric_index && index_val.getType() != ValueType::kDouble){
 				ErrorManager("AssignmentNode", "list index must be a number.");
 			}
 			double raw_idx = index_val.asNumber();
@@ -375,6 +435,47 @@ Value Interpreter::visit(const AssignmentNode* node){
 
 			return rvalue;
 		}
+		else if(object_val.getType() == ValueType::kArray){
+			if(!numeric_index && index_val.getType() != ValueType::kDouble){
+				ErrorManager("AssignmentNode", "array index must be a number.");
+			}
+			double raw_idx = index_val.asNumber();
+			if(std::floor(raw_idx) != raw_idx){
+				ErrorManager("AssignmentNode", "array index must be a number.");
+			}
+			long long idx = static_cast<long long>(raw_idx);
+			auto array_ptr = object_val.asArray();
+			long long size = array_ptr->size();
+
+			if(idx < 0) idx += size;
+
+			if(idx < 0 || idx >= size){
+				ErrorManager("AssignmentNode", "array index out of bounds.");
+			}
+
+			if(node->assignmentOp != TokenType::tAssign){
+				TokenType type;
+
+				switch(node->assignmentOp){
+					case TokenType::tPlusAssign: type = TokenType::tPlus; break;
+					case TokenType::tMinusAssign: type = TokenType::tMinus; break;
+					case TokenType::tMultiplyAssign: type = TokenType::tMultiply; break;
+					case TokenType::tDivideAssign: type = TokenType::tDivide; break;
+					case TokenType::tModuleAssign: type = TokenType::tModule; break;
+					case TokenType::tPowerAssign: type = TokenType::tPower; break;
+					default:
+						ErrorManager("AssignmentNode");
+				}
+				rvalue = applyBinaryOperator(type, Value((*array_ptr)[idx]), rvalue);
+			}
+
+			if(rvalue.getType() != ValueType::kDouble){
+				ErrorManager("AssignmentNode", "array elements must be numbers.");
+			}
+			(*array_ptr)[idx] = rvalue.asNumber();
+
+			return rvalue;
+		}
 		else{
 			ErrorManager("AssignmentNode", "list[index]");
 		}
@@ -414,7 +515,7 @@ Value Interpreter::visit(const IndexExpressionNode* node){
 	Value object = evaluate(node->object.get());
 	Value index_val = evaluate(node->index.get());
 
-	if(index_val.getType() != ValueType::kDouble){
+	if(node->index->static_type != ValueType::kDouble && index_val.getType() != ValueType::kDouble){
 		ErrorManager("IndexExpressionNode", "index must be a number.");
 	}
 
@@ -424,8 +525,10 @@ Value Interpreter::visit(const IndexExpressionNode* node){
 	}
 	int idx = static_cast<int>(raw_idx);
 
+	ValueType object_type = node->object->static_type.value_or(object.getType());
+
 	// kList
-	if(object.getType() == ValueType::kList){
+	if(object_type == ValueType::kList){
 		auto list_ptr = object.asList();
 		int size = list_ptr->size();
 
@@ -439,8 +542,23 @@ Value Interpreter::visit(const IndexExpressionNode* node){
 		return (*list_ptr)[idx];
 	}
 
+	// kArray
+	if(object_type == ValueType::kArray){
+		auto array_ptr = object.asArray();
+		int size = array_ptr->size();
+
+		if(idx < 0){
+			idx += size;
+		}
+
+		if(idx < 0 || idx >= size){
+			return Value();
+		}
+		return Value((*array_ptr)[idx]);
+	}
+
 	// kString
-	if(object.getType() == ValueType::kString){
+	if(object_type == ValueType::kString){
 		auto str_ptr = object.asString();
 		int size = str_ptr->length();
 
@@ -455,7 +573,7 @@ Value Interpreter::visit(const IndexExpressionNode* node){
 		return Value(std::string(1, (*str_ptr)[idx]));
 	}
 
-	ErrorManager("IndexExpressionNode", "indexing operator [] can only be applied to lists and strings.");
+	ErrorManager("IndexExpressionNode", "indexing operator [] can only be applied to lists, arrays and strings.");
 	return Value();
 }
 
@@ -465,7 +583,7 @@ long long Interpreter::resolve_slice_index(const std::unique_ptr<ExpressionNode>
 	}
 
 	Value val = evaluate(expr_node.get());
-	if(val.getType() != ValueType::kDouble){
+	if(expr_node->static_type != ValueType::kDouble && val.getType() != ValueType::kDouble){
 		ErrorManager("SliceExpressionNode", "slice indices must be numbers.");
 	}
 	double raw_idx = val.asNumber();
@@ -484,16 +602,17 @@ long long Interpreter::resolve_slice_index(const std::unique_ptr<ExpressionNode>
 
 Value Interpreter::visit(const SliceExpressionNode* node){
 	Value object = evaluate(node->object.get());
+	ValueType object_type = node->object->static_type.value_or(object.getType());
 
 	// kList
-	if(object.getType() == ValueType::kList){
+	if(object_type == ValueType::kList){
 		auto list_ptr = object.asList();
 		long long size = list_ptr->size();
 
 		long long start = resolve_slice_index(node->start, size, 0);
 		long long end = resolve_slice_index(node->end, size, size);
 
-		auto new_list = std::make_shared<ListType>();
+		auto new_list = makeTracked<ListType>();
 
 		if(start < end){
 			for(long long i = start; i < end; ++i){
@@ -504,8 +623,25 @@ Value Interpreter::visit(const SliceExpressionNode* node){
 		return Value(new_list);
 	}
 
+	// kArray
+	if(object_type == ValueType::kArray){
+		auto array_ptr = object.asArray();
+		long long size = array_ptr->size();
+
+		long long start = resolve_slice_index(node->start, size, 0);
+		long long end = resolve_slice_index(node->end, size, size);
+
+		auto new_array = makeTracked<ArrayType>();
+
+		if(start < end){
+			new_array->assign(array_ptr->begin() + start, array_ptr->begin() + end);
+		}
+
+		return Value(new_array);
+	}
+
 	// kString
-	if(object.getType() == ValueType::kString){
+	if(object_type == ValueType::kString){
 		auto str_ptr = object.asString();
 		long long size = str_ptr->length();
 
@@ -521,7 +657,7 @@ Value Interpreter::visit(const SliceExpressionNode* node){
 		return Value(new_str);
 	}
 
-	ErrorManager("SliceExpressionNode", "slicing operator [:] can only be applied to lists and strings.");
+	ErrorManager("SliceExpressionNode", "slicing operator [:] can only be applied to lists, arrays and strings.");
 	return Value();
 }
 
@@ -536,7 +672,7 @@ void Interpreter::popCall(){
 }
 
 Value Interpreter::getStackTrace(){
-	auto list_ptr = std::make_shared<ListType>();
+	auto list_ptr = makeTracked<ListType>();
 
 	for(const auto& call_info : call_stack_trace){
 		list_ptr->push_back(Value(call_info));
@@ -547,6 +683,10 @@ Value Interpreter::getStackTrace(){
 	return Value(list_ptr);
 }
 
+OutputBuffer& Interpreter::output(){
+	return m_output;
+}
+
 
 bool interpret(std::istream& in, std::ostream& out){
 	std::streambuf* oldCoutBuf = nullptr;
@@ -2,10 +2,17 @@
 
 #include <memory>
 #include <iostream>
+#include <thread>
+#include <utility>
 
 #include "value.h"
 #include "scope.h"
 #include "errorManager.h"
+#include "outputBuffer.h"
+#include "arrayKernels.h"
+#include "channel.h"
+#include "typeInference.h"
+#include "jit.h"
 #include "../lexer/token.h"
 #include "../lexer/lexer.h"
 #include "../parser/ASTNode.h"
@@ -34,10 +41,16 @@ struct StandardLibrary{
 
 class Interpreter{
 private:
+	// buffered print/println
+	OutputBuffer m_output;
+
 	// scopes
 	std::shared_ptr<Scope> m_current_scope;
 	std::shared_ptr<Scope> m_global_scope;
 
+	// standard library of this interpreter (isolates bind aliases of builtins to it)
+	std::unordered_map<std::string, Value> m_builtins;
+
 	// recursion depth
 	int m_recursion_depth = 0;
 	const int MAX_RECURSION_DEPTH = 1000;
@@ -45,15 +58,29 @@ private:
 	// stacktrace
 	std::vector<std::string> call_stack_trace;
 
+#ifdef ITMOSCRIPT_JIT
+	// hot numeric functions -> x86-64
+	Jit m_jit;
+#endif
+
+	// isolates started by spawn(), joined before the AST and globals go away
+	std::vector<std::jthread> m_workers;
+
 public:
 	Interpreter(std::unique_ptr<ProgramNode> start)
-		: m_global_scope(std::make_shared<Scope>(std::move(start)))
+		: m_output(std::cout.rdbuf())
+		, m_global_scope(std::make_shared<Scope>(std::move(start)))
 	{
 		m_current_scope = m_global_scope;
 		StandardLibrary std_lib(*m_global_scope, *this);
+		m_builtins = m_global_scope->getVariables();
+		TypeInference().run(m_global_scope->getAstRoot().get());
 		visit(m_global_scope->getAstRoot().get());
 	}
 
+	// isolate for spawn(): stdlib + detached copy of the parent globals, no program
+	Interpreter(const std::vector<std::pair<std::string, Value>>& globals, std::streambuf* output);
+
 	// BinaryOP (math?)
 	Value add(const Value& left, const Value& right);
 	Value subtract(const Value& left, const Value& right);
@@ -62,6 +89,12 @@ public:
 	Value modulo(const Value& left, const Value& right);
 	Value power(const Value& left, const Value& right);
 
+	// both operands are known to be numbers (BinaryOpNode::numeric_operands)
+	Value numericOperator(TokenType type, double left, double right);
+
+	// element-wise + - * / when at least one side is an array
+	Value arrayArithmetic(array_kernels::Op op, const std::string& operation, const Value& left, const Value& right);
+
 	// BinaryOP equals
 	Value equal(const Value& left, const Value& right, bool isnot = false);
 	Value notEqual(const Value& left, const Value& right);
@@ -126,6 +159,23 @@ public:
 	void pushCall(const std::string& name);
 	void popCall();
 	Value getStackTrace();
+
+	// print | println | flush
+	OutputBuffer& output();
+
+	// isolates (spawn | send | recv), see isolate.cpp
+	Value makeFunction(const FunctionLiteralNode* node);
+	Value spawn(const Value& func, const ListType& args);
+	Value pmap(const Value& func, const ListType& items, size_t workers);
+	std::vector<std::pair<std::string, Value>> snapshotGlobals() const;
+	Value builtin(const std::string& name) const;
+	Value callInIsolate(const FunctionLiteralNode* source, const std::vector<Value>& args);
+
+	// deep copy that shares nothing mutable with the original; strict = error on builtins
+	// and memoized functions, otherwise they are rebuilt by adopt()
+	static Value detach(const Value& value, bool strict = true);
+	// bind functions of a detached value to this interpreter
+	Value adopt(const Value& value);
 };
 
 // only for test
@@ -0,0 +1,306 @@
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "interpreter.h"
+#include "memoCache.h"
+
+// Isolates: spawn(f, args) runs f on its own thread inside a fresh Interpreter.
+// Nothing mutable is shared between isolates — lists and arrays are deep-copied
+// on the way in and out, strings are immutable and are passed as is, channels
+// are the only shared objects. Functions travel as their AST node and are
+// re-created (adopted) by the receiving interpreter; globals may also hold
+// aliases of builtins, bound to the isolate's own builtin of the same name,
+// and memoized functions, re-created around their function with an empty cache.
+
+namespace{
+
+Value detachImpl(const Value& value, bool strict, std::unordered_map<const ListType*, Value>& copies){
+	switch(value.getType()){
+		case ValueType::kList: {
+			const auto& source = value.asList();
+
+			// lists may contain themselves
+			auto it = copies.find(source.get());
+			if(it != copies.end()){
+				return it->second;
+			}
+
+			auto copy = makeTracked<ListType>();
+			Value result(copy);
+			copies.emplace(source.get(), result);
+
+			copy->reserve(source->size());
+			for(const auto& element : *source){
+				copy->push_back(detachImpl(element, strict, copies));
+			}
+
+			return result;
+		}
+		case ValueType::kArray:
+			return Value(makeTracked<ArrayType>(*value.asArray()));
+		case ValueType::kFunc: {
+			const auto& func = value.asFunction();
+			if(func->getSource()){
+				return value;
+			}
+			if(strict){
+				ErrorManager("isolate", "builtin functions cannot be passed between isolates");
+			}
+			if(!func->getBuiltin().empty()){
+				return value;
+			}
+			if(func->getMemo()){
+				// своя пустая копия кэша: исходный кэш меняет поток-владелец
+				Value wrapped = detachImpl(Value(func->getWrapped()), strict, copies);
+				return Value(makeMemoized(wrapped.asFunction(), func->getMemo()->capacity()));
+			}
+			ErrorManager("isolate", "function cannot be passed between isolates");
+			return Value();
+		}
+		case ValueType::kFile:
+			// позиция чтения и буфер записи не делятся между потоками
+			if(strict){
+				ErrorManager("isolate", "files cannot be passed between isolates");
+			}
+			return Value();
+		default:
+			// числа, строки, bool, nil, каналы
+			return value;
+	}
+}
+
+void adoptImpl(Interpreter& interpreter, Value& value, std::unordered_set<const ListType*>& seen){
+	switch(value.getType()){
+		case ValueType::kList: {
+			const auto& list = value.asList();
+			if(!seen.insert(list.get()).second){
+				return;
+			}
+			for(auto& element : *list){
+				adoptImpl(interpreter, element, seen);
+			}
+			break;
+		}
+		case ValueType::kFunc: {
+			const auto func = value.asFunction();
+			if(func->getSource()){
+				value = interpreter.makeFunction(func->getSource());
+			}
+			else if(!func->getBuiltin().empty()){
+				value = interpreter.builtin(func->getBuiltin());
+			}
+			else if(func->getMemo()){
+				Value wrapped(func->getWrapped());
+				adoptImpl(interpreter, wrapped, seen);
+				value = Value(makeMemoized(wrapped.asFunction(), func->getMemo()->capacity()));
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+}
+
+Interpreter::Interpreter(const std::vector<std::pair<std::string, Value>>& globals, std::streambuf* output)
+	: m_output(output)
+	, m_global_scope(std::make_shared<Scope>(std::unique_ptr<ProgramNode>()))
+{
+	m_current_scope = m_global_scope;
+	StandardLibrary std_lib(*m_global_scope, *this);
+	m_builtins = m_global_scope->getVariables();
+
+	for(const auto& [name, value] : globals){
+		m_global_scope->define(name, adopt(value));
+	}
+}
+
+Value Interpreter::detach(const Value& value, bool strict){
+	std::unordered_map<const ListType*, Value> copies;
+	return detachImpl(value, strict, copies);
+}
+
+Value Interpreter::adopt(const Value& value){
+	// value is already detached, so it can be rebound in place
+	Value result = value;
+	std::unordered_set<const ListType*> seen;
+	adoptImpl(*this, result, seen);
+	return result;
+}
+
+Value Interpreter::builtin(const std::string& name) const{
+	auto it = m_builtins.find(name);
+	if(it == m_builtins.end()){
+		ErrorManager("isolate", "unknown builtin " + name);
+	}
+	return it->second;
+}
+
+std::vector<std::pair<std::string, Value>> Interpreter::snapshotGlobals() const{
+	std::vector<std::pair<std::string, Value>> globals;
+	for(const auto& [name, value] : m_global_scope->getVariables()){
+		// builtins under their own name are provided by the isolate itself
+		if(value.getType() == ValueType::kFunc && value.asFunction()->getBuiltin() == name){
+			continue;
+		}
+
+		try{
+			globals.emplace_back(name, detach(value, false));
+		}
+		catch(const std::runtime_error& e){
+			ErrorManager("isolate", "global " + name + " cannot be passed to an isolate (" + e.what() + ")");
+		}
+	}
+	return globals;
+}
+
+Value Interpreter::spawn(const Value& func, const ListType& args){
+	const FunctionLiteralNode* source = func.asFunction()->getSource();
+	if(!source){
+		ErrorManager("spawn", "only script functions can be spawned");
+	}
+
+	std::vector<Value> call_args;
+	call_args.reserve(args.size());
+	for(const auto& arg : args){
+		call_args.push_back(detach(arg));
+	}
+
+	auto globals = snapshotGlobals();
+
+	// isolate prints into the same stream, so our pending output goes first
+	m_output.flush();
+
+	auto result = std::make_shared<Channel>();
+	std::streambuf* target = m_output.target();
+
+	m_workers.emplace_back([source, call_args = std::move(call_args), globals = std::move(globals), result, target](){
+		try{
+			Interpreter isolate(globals, target);
+			Value value = isolate.callInIsolate(source, call_args);
+			isolate.output().flush();
+			result->send(detach(value));
+		}
+		catch(const std::exception& e){
+			result->fail(e.what());
+		}
+		catch(...){
+			result->fail("unexpected control flow");
+		}
+	});
+
+	return Value(result);
+}
+
+Value Interpreter::callInIsolate(const FunctionLiteralNode* source, const std::vector<Value>& args){
+	std::vector<Value> adopted;
+	adopted.reserve(args.size());
+	for(const auto& arg : args){
+		adopted.push_back(adopt(arg));
+	}
+
+	Value func = makeFunction(source);
+
+	pushCall("isolate");
+	Value result = (*func.asFunction())(adopted);
+	popCall();
+
+	return result;
+}
+
+Value Interpreter::pmap(const Value& func, const ListType& items, size_t workers){
+	const FunctionLiteralNode* source = func.asFunction()->getSource();
+	if(!source){
+		ErrorManager("pmap", "only script functions can be mapped in parallel");
+	}
+
+	auto results = makeTracked<ListType>(items.size());
+	if(items.empty()){
+		return Value(results);
+	}
+	workers = std::max<size_t>(1, std::min(workers, items.size()));
+
+	// each element separately: elements must not share lists between workers
+	std::vector<Value> inputs;
+	inputs.reserve(items.size());
+	for(const auto& item : items){
+		inputs.push_back(detach(item));
+	}
+
+	// one snapshot for all workers, read-only: adopt() rebinds in place, so each
+	// worker copies it into its own isolate (one copy of the globals per worker)
+	const auto globals = snapshotGlobals();
+
+	m_output.flush();
+	std::streambuf* target = m_output.target();
+
+	// небольшие куски из общей очереди: итерации бывают разной длины
+	const size_t chunk = std::max<size_t>(1, inputs.size() / (workers * 8));
+	std::atomic<size_t> next{0};
+	std::atomic<bool> failed{false};
+
+	std::mutex error_mutex;
+	size_t error_index = inputs.size();
+	std::string error;
+
+	auto fail = [&](size_t index, const std::string& message){
+		std::lock_guard<std::mutex> lock(error_mutex);
+		if(index <= error_index){
+			error_index = index;
+			error = message;
+		}
+		failed = true;
+	};
+
+	{
+		std::vector<std::jthread> pool;
+		for(size_t w = 0; w < workers; ++w){
+			pool.emplace_back([&](){
+				size_t index = 0;
+				try{
+					std::vector<std::pair<std::string, Value>> own;
+					own.reserve(globals.size());
+					for(const auto& [name, value] : globals){
+						own.emplace_back(name, detach(value, false));
+					}
+
+					Interpreter isolate(own, target);
+					Value mapped = isolate.makeFunction(source);
+
+					while(!failed){
+						size_t begin = next.fetch_add(chunk);
+						if(begin >= inputs.size()) break;
+
+						size_t end = std::min(begin + chunk, inputs.size());
+						for(index = begin; index < end; ++index){
+							Value value = (*mapped.asFunction())({isolate.adopt(inputs[index])});
+							(*results)[index] = detach(value);
+						}
+					}
+
+					isolate.output().flush();
+				}
+				catch(const std::exception& e){
+					fail(index, e.what());
+				}
+				catch(...){
+					fail(index, "unexpected control flow");
+				}
+			});
+		}
+	}
+
+	if(failed){
+		ErrorManager("pmap", "element "+std::to_string(error_index)+": "+error);
+	}
+
+	for(auto& value : *results){
+		value = adopt(value);
+	}
+
+	return Value(results);
+}
@@ -0,0 +1,676 @@
+#include "jit.h"
+
+#ifdef ITMOSCRIPT_JIT
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <unordered_set>
+
+#include <sys/mman.h>
+
+namespace{
+
+// int f(double* frame, double* result)
+using NativeEntry = int(*)(double*, double*);
+
+// what the native code returns
+enum Status : int{
+	kReturned = 0,	// return x, x is in *result
+	kFinished = 1,	// end of body, result is nil
+	kBailout = 2	// repeat the call in the interpreter
+};
+
+// Jcc condition codes (0F 80+cc)
+enum Condition : uint8_t{
+	kBelow = 0x2,
+	kAboveOrEqual = 0x3,
+	kEqual = 0x4,
+	kNotEqual = 0x5,
+	kBelowOrEqual = 0x6,
+	kAbove = 0x7,
+	kParity = 0xA
+};
+
+// SSE2 scalar double opcodes (F2 0F op)
+enum SseOp : uint8_t{
+	kAddsd = 0x58,
+	kMulsd = 0x59,
+	kSubsd = 0x5C,
+	kDivsd = 0x5E
+};
+
+// Just the instructions the compiler below needs.
+// rbx = frame, r12 = result, values live in xmm0..xmm2.
+class Assembler{
+private:
+	struct Label{
+		int64_t position = -1;
+		std::vector<size_t> fixups;
+	};
+
+	std::vector<uint8_t> m_code;
+	std::vector<Label> m_labels;
+
+	void emit(std::initializer_list<uint8_t> bytes){
+		m_code.insert(m_code.end(), bytes);
+	}
+
+	void emit32(uint32_t value){
+		for(int i = 0; i < 4; ++i) m_code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+
+	void emit64(uint64_t value){
+		for(int i = 0; i < 8; ++i) m_code.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+
+	void emitLabel(size_t label){
+		m_labels[label].fixups.push_back(m_code.size());
+		emit32(0);
+	}
+
+	static uint8_t modrm(int reg, int rm){
+		return static_cast<uint8_t>(0xC0 | (reg << 3) | rm);
+	}
+
+public:
+	size_t newLabel(){
+		m_labels.emplace_back();
+		return m_labels.size() - 1;
+	}
+
+	void bind(size_t label){
+		m_labels[label].position = static_cast<int64_t>(m_code.size());
+	}
+
+	// resolves jumps
+	const std::vector<uint8_t>& finish(){
+		for(const auto& label : m_labels){
+			for(size_t fixup : label.fixups){
+				int32_t rel = static_cast<int32_t>(label.position - static_cast<int64_t>(fixup + 4));
+				std::memcpy(&m_code[fixup], &rel, sizeof(rel));
+			}
+		}
+		return m_code;
+	}
+
+	// push rbx; push r12; push rbp (stack is 16-aligned for calls); rbx = rdi; r12 = rsi
+	void prologue(){
+		emit({0x53, 0x41, 0x54, 0x55, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4});
+	}
+
+	// pop rbp; pop r12; pop rbx; ret
+	void epilogue(){
+		emit({0x5D, 0x41, 0x5C, 0x5B, 0xC3});
+	}
+
+	// movsd xmm, [rbx + slot*8]
+	void loadSlot(int xmm, size_t slot){
+		emit({0xF2, 0x0F, 0x10, static_cast<uint8_t>(0x83 | (xmm << 3))});
+		emit32(static_cast<uint32_t>(slot * sizeof(double)));
+	}
+
+	// movsd [rbx + slot*8], xmm
+	void storeSlot(size_t slot, int xmm){
+		emit({0xF2, 0x0F, 0x11, static_cast<uint8_t>(0x83 | (xmm << 3))});
+		emit32(static_cast<uint32_t>(slot * sizeof(double)));
+	}
+
+	// movsd [r12], xmm
+	void storeResult(int xmm){
+		emit({0xF2, 0x41, 0x0F, 0x11, static_cast<uint8_t>(0x04 | (xmm << 3)), 0x24});
+	}
+
+	// movsd dst, src
+	void move(int dst, int src){
+		emit({0xF2, 0x0F, 0x10, modrm(dst, src)});
+	}
+
+	void arithmetic(SseOp op, int dst, int src){
+		emit({0xF2, 0x0F, op, modrm(dst, src)});
+	}
+
+	// ucomisd a, b
+	void compare(int a, int b){
+		emit({0x66, 0x0F, 0x2E, modrm(a, b)});
+	}
+
+	// xorpd dst, src
+	void bitXor(int dst, int src){
+		emit({0x66, 0x0F, 0x57, modrm(dst, src)});
+	}
+
+	// mov rax, imm64; movq xmm, rax
+	void loadConstant(int xmm, double value){
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		emit({0x48, 0xB8});
+		emit64(bits);
+		emit({0x66, 0x48, 0x0F, 0x6E, modrm(xmm, 0)});
+	}
+
+	// mov rax, imm64; call rax
+	void call(const void* function){
+		emit({0x48, 0xB8});
+		emit64(reinterpret_cast<uint64_t>(function));
+		emit({0xFF, 0xD0});
+	}
+
+	// mov eax, imm32
+	void setStatus(Status status){
+		emit({0xB8});
+		emit32(static_cast<uint32_t>(status));
+	}
+
+	void jump(size_t label){
+		emit({0xE9});
+		emitLabel(label);
+	}
+
+	void jumpIf(Condition condition, size_t label){
+		emit({0x0F, static_cast<uint8_t>(0x80 | condition)});
+		emitLabel(label);
+	}
+};
+
+double callFmod(double left, double right){
+	return std::fmod(left, right);
+}
+
+double callPow(double left, double right){
+	return std::pow(left, right);
+}
+
+// names assigned anywhere in the body (they get frame slots)
+void collectAssigned(const ASTNode* node, std::vector<std::string>& names){
+	if(!node){
+		return;
+	}
+
+	if(auto block_node = dynamic_cast<const BlockNode*>(node)){
+		for(const auto& stmt : block_node->statements) collectAssigned(stmt.get(), names);
+	}
+	else if(auto expr_stmt = dynamic_cast<const ExpressionStatementNode*>(node)){
+		collectAssigned(expr_stmt->expression.get(), names);
+	}
+	else if(auto if_stmt = dynamic_cast<const IfStatementNode*>(node)){
+		collectAssigned(if_stmt->thenBranch.get(), names);
+		collectAssigned(if_stmt->elseBranch.get(), names);
+	}
+	else if(auto while_stmt = dynamic_cast<const WhileStatementNode*>(node)){
+		collectAssigned(while_stmt->body.get(), names);
+	}
+	else if(auto assign = dynamic_cast<const AssignmentNode*>(node)){
+		if(auto id_node = dynamic_cast<const IdentifierNode*>(assign->expression_l.get())){
+			names.push_back(id_node->name);
+		}
+	}
+}
+
+// Compiles the body or gives up (returns false) on anything outside the subset.
+// Tracks which names are defined in which block exactly like Scope does at run
+// time, so reading a variable that the interpreter would look up outside the
+// function is rejected too.
+class FunctionCompiler{
+private:
+	struct Loop{
+		size_t head;
+		size_t exit;
+	};
+
+	Assembler m_asm;
+
+	std::unordered_map<std::string, size_t> m_slots;
+	std::vector<std::unordered_set<std::string>> m_defined;
+	std::vector<Loop> m_loops;
+
+	size_t m_exit = 0;
+	size_t m_bailout = 0;
+
+	// temporaries live after the variables
+	size_t m_temp_base = 0;
+	size_t m_depth = 0;
+	size_t m_max_depth = 0;
+
+	bool isDefined(const std::string& name) const{
+		for(const auto& names : m_defined){
+			if(names.contains(name)) return true;
+		}
+		return false;
+	}
+
+	size_t pushTemp(){
+		size_t slot = m_temp_base + m_depth++;
+		m_max_depth = std::max(m_max_depth, m_depth);
+		return slot;
+	}
+
+	void popTemp(){
+		--m_depth;
+	}
+
+	// xmm0 = left, xmm1 = right
+	bool operands(const BinaryOpNode* node){
+		if(!numeric(node->left.get())) return false;
+		size_t temp = pushTemp();
+		m_asm.storeSlot(temp, 0);
+
+		if(!numeric(node->right.get())) return false;
+		m_asm.move(1, 0);
+		m_asm.loadSlot(0, temp);
+		popTemp();
+
+		return true;
+	}
+
+	// number -> xmm0
+	bool numeric(const ExpressionNode* node){
+		if(auto number = dynamic_cast<const NumberLiteralNode*>(node)){
+			m_asm.loadConstant(0, number->value);
+			return true;
+		}
+		if(auto id_node = dynamic_cast<const IdentifierNode*>(node)){
+			if(!isDefined(id_node->name)) return false;
+			m_asm.loadSlot(0, m_slots.at(id_node->name));
+			return true;
+		}
+		if(auto unary = dynamic_cast<const UnaryOpNode*>(node)){
+			if(unary->op != TokenType::tMinus && unary->op != TokenType::tPlus) return false;
+			if(!numeric(unary->operand.get())) return false;
+
+			if(unary->op == TokenType::tMinus){
+				m_asm.loadConstant(1, -0.0);
+				m_asm.bitXor(0, 1);
+			}
+			return true;
+		}
+		if(auto binary = dynamic_cast<const BinaryOpNode*>(node)){
+			switch(binary->op){
+				case TokenType::tPlus:
+				case TokenType::tMinus:
+				case TokenType::tMultiply:
+				case TokenType::tDivide:
+				case TokenType::tModule:
+				case TokenType::tPower:
+					break;
+				default:
+					return false;
+			}
+
+			if(!operands(binary)) return false;
+			return arithmetic(binary->op);
+		}
+		return false;
+	}
+
+	// xmm0 = xmm0 op xmm1
+	bool arithmetic(TokenType op){
+		switch(op){
+			case TokenType::tPlus: m_asm.arithmetic(kAddsd, 0, 1); return true;
+			case TokenType::tMinus: m_asm.arithmetic(kSubsd, 0, 1); return true;
+			case TokenType::tMultiply: m_asm.arithmetic(kMulsd, 0, 1); return true;
+			case TokenType::tDivide: {
+				// деление на ноль - ошибка, её сообщит интерпретатор
+				size_t nonzero = m_asm.newLabel();
+				m_asm.bitXor(2, 2);
+				m_asm.compare(1, 2);
+				m_asm.jumpIf(kParity, nonzero);
+				m_asm.jumpIf(kEqual, m_bailout);
+				m_asm.bind(nonzero);
+				m_asm.arithmetic(kDivsd, 0, 1);
+				return true;
+			}
+			case TokenType::tModule: m_asm.call(reinterpret_cast<const void*>(&callFmod)); return true;
+			case TokenType::tPower: m_asm.call(reinterpret_cast<const void*>(&callPow)); return true;
+			default: return false;
+		}
+	}
+
+	// jump to label if the condition is `when`, fall through otherwise
+	bool branch(const ExpressionNode* node, bool when, size_t label){
+		if(auto boolean = dynamic_cast<const BooleanLiteralNode*>(node)){
+			if(boolean->value == when) m_asm.jump(label);
+			return true;
+		}
+		if(auto unary = dynamic_cast<const UnaryOpNode*>(node)){
+			if(unary->op != TokenType::tNot) return false;
+			return branch(unary->operand.get(), !when, label);
+		}
+
+		auto binary = dynamic_cast<const BinaryOpNode*>(node);
+		if(!binary){
+			return false;
+		}
+
+		if(binary->op == TokenType::tAnd || binary->op == TokenType::tOr){
+			bool is_and = binary->op == TokenType::tAnd;
+
+			// and: false if left is false; or: true if left is true
+			if(when != is_and){
+				return branch(binary->left.get(), when, label) && branch(binary->right.get(), when, label);
+			}
+
+			size_t skip = m_asm.newLabel();
+			if(!branch(binary->left.get(), !when, skip)) return false;
+			if(!branch(binary->right.get(), when, label)) return false;
+			m_asm.bind(skip);
+			return true;
+		}
+
+		// NaN: ucomisd sets ZF = PF = CF = 1, every comparison except != is false
+		switch(binary->op){
+			case TokenType::tLess:
+			case TokenType::tLessOrEqual:
+				if(!operands(binary)) return false;
+				m_asm.compare(1, 0); // right vs left
+				break;
+			case TokenType::tGreater:
+			case TokenType::tGreaterOrEqual:
+			case TokenType::tEqual:
+			case TokenType::tNotEqual:
+				if(!operands(binary)) return false;
+				m_asm.compare(0, 1);
+				break;
+			default:
+				return false;
+		}
+
+		switch(binary->op){
+			case TokenType::tLess:
+			case TokenType::tGreater:
+				m_asm.jumpIf(when ? kAbove : kBelowOrEqual, label);
+				return true;
+			case TokenType::tLessOrEqual:
+			case TokenType::tGreaterOrEqual:
+				m_asm.jumpIf(when ? kAboveOrEqual : kBelow, label);
+				return true;
+			default:
+				break;
+		}
+
+		bool equal = (binary->op == TokenType::tEqual) == when;
+		if(equal){
+			size_t skip = m_asm.newLabel();
+			m_asm.jumpIf(kParity, skip);
+			m_asm.jumpIf(kEqual, label);
+			m_asm.bind(skip);
+		}
+		else{
+			m_asm.jumpIf(kParity, label);
+			m_asm.jumpIf(kNotEqual, label);
+		}
+		return true;
+	}
+
+	bool assignment(const AssignmentNode* node){
+		auto id_node = dynamic_cast<const IdentifierNode*>(node->expression_l.get());
+		if(!id_node){
+			return false;
+		}
+		const std::string& name = id_node->name;
+
+		if(!numeric(node->expression_r.get())){
+			return false;
+		}
+
+		if(node->assignmentOp == TokenType::tAssign){
+			// как Scope::assign / define
+			if(!isDefined(name)) m_defined.back().insert(name);
+			m_asm.storeSlot(m_slots.at(name), 0);
+			return true;
+		}
+
+		if(!isDefined(name)){
+			return false;
+		}
+
+		TokenType op;
+		switch(node->assignmentOp){
+			case TokenType::tPlusAssign: op = TokenType::tPlus; break;
+			case TokenType::tMinusAssign: op = TokenType::tMinus; break;
+			case TokenType::tMultiplyAssign: op = TokenType::tMultiply; break;
+			case TokenType::tDivideAssign: op = TokenType::tDivide; break;
+			case TokenType::tModuleAssign: op = TokenType::tModule; break;
+			case TokenType::tPowerAssign: op = TokenType::tPower; break;
+			default: return false;
+		}
+
+		m_asm.move(1, 0);
+		m_asm.loadSlot(0, m_slots.at(name));
+		if(!arithmetic(op)) return false;
+		m_asm.storeSlot(m_slots.at(name), 0);
+		return true;
+	}
+
+	bool block(const BlockNode* node){
+		m_defined.emplace_back();
+		for(const auto& stmt : node->statements){
+			if(stmt && !statement(stmt.get())) return false;
+		}
+		m_defined.pop_back();
+		return true;
+	}
+
+	bool statement(const StatementNode* node){
+		if(auto expr_stmt = dynamic_cast<const ExpressionStatementNode*>(node)){
+			if(auto assign = dynamic_cast<const AssignmentNode*>(expr_stmt->expression.get())){
+				return assignment(assign);
+			}
+			return numeric(expr_stmt->expression.get());
+		}
+		if(auto if_stmt = dynamic_cast<const IfStatementNode*>(node)){
+			size_t otherwise = m_asm.newLabel();
+			size_t end = m_asm.newLabel();
+
+			if(!branch(if_stmt->condition.get(), false, otherwise)) return false;
+			if(if_stmt->thenBranch && !block(if_stmt->thenBranch.get())) return false;
+			m_asm.jump(end);
+
+			m_asm.bind(otherwise);
+			if(auto else_block = dynamic_cast<const BlockNode*>(if_stmt->elseBranch.get())){
+				if(!block(else_block)) return false;
+			}
+			else if(if_stmt->elseBranch && !statement(if_stmt->elseBranch.get())){
+				return false;
+			}
+			m_asm.bind(end);
+			return true;
+		}
+		if(auto while_stmt = dynamic_cast<const WhileStatementNode*>(node)){
+			Loop loop{m_asm.newLabel(), m_asm.newLabel()};
+
+			m_asm.bind(loop.head);
+			if(!branch(while_stmt->condition.get(), false, loop.exit)) return false;
+
+			m_loops.push_back(loop);
+			if(while_stmt->body && !block(while_stmt->body.get())) return false;
+			m_loops.pop_back();
+
+			m_asm.jump(loop.head);
+			m_asm.bind(loop.exit);
+			return true;
+		}
+		if(auto return_stmt = dynamic_cast<const ReturnStatementNode*>(node)){
+			if(!return_stmt->returnValue || !numeric(return_stmt->returnValue.get())) return false;
+			m_asm.storeResult(0);
+			m_asm.setStatus(kReturned);
+			m_asm.jump(m_exit);
+			return true;
+		}
+		if(dynamic_cast<const BreakStatementNode*>(node)){
+			if(m_loops.empty()) return false;
+			m_asm.jump(m_loops.back().exit);
+			return true;
+		}
+		if(dynamic_cast<const ContinueStatementNode*>(node)){
+			if(m_loops.empty()) return false;
+			m_asm.jump(m_loops.back().head);
+			return true;
+		}
+		if(auto block_node = dynamic_cast<const BlockNode*>(node)){
+			return block(block_node);
+		}
+		return false;
+	}
+
+public:
+	std::vector<size_t> param_slots;
+	std::vector<std::string> locals;
+
+	bool compile(const FunctionLiteralNode* node){
+		if(!node->body){
+			return false;
+		}
+
+		auto slotOf = [this](const std::string& name){
+			auto [it, inserted] = m_slots.emplace(name, m_slots.size());
+			return it->second;
+		};
+
+		m_defined.emplace_back();
+		for(const auto& param : node->parameters){
+			param_slots.push_back(slotOf(param->name));
+			m_defined.back().insert(param->name);
+		}
+
+		std::vector<std::string> assigned;
+		collectAssigned(node->body.get(), assigned);
+		for(const auto& name : assigned){
+			slotOf(name);
+			if(!m_defined.front().contains(name) && std::find(locals.begin(), locals.end(), name) == locals.end()){
+				locals.push_back(name);
+			}
+		}
+		m_temp_base = m_slots.size();
+
+		m_exit = m_asm.newLabel();
+		m_bailout = m_asm.newLabel();
+
+		m_asm.prologue();
+
+		// тело функции выполняется прямо в scope параметров
+		for(const auto& stmt : node->body->statements){
+			if(stmt && !statement(stmt.get())) return false;
+		}
+
+		m_asm.setStatus(kFinished);
+		m_asm.jump(m_exit);
+
+		m_asm.bind(m_bailout);
+		m_asm.setStatus(kBailout);
+
+		m_asm.bind(m_exit);
+		m_asm.epilogue();
+
+		return true;
+	}
+
+	size_t frameSize() const{
+		return m_temp_base + m_max_depth;
+	}
+
+	const std::vector<uint8_t>& code(){
+		return m_asm.finish();
+	}
+};
+
+}
+
+struct Jit::CompiledFunction{
+	void* memory = nullptr;
+	size_t size = 0;
+	NativeEntry entry = nullptr;
+
+	size_t frame_size = 0;
+	std::vector<size_t> param_slots;
+	std::vector<std::string> locals;
+
+	~CompiledFunction(){
+		if(memory) munmap(memory, size);
+	}
+};
+
+Jit::Jit() = default;
+
+Jit::~Jit() = default;
+
+bool Jit::tryCall(const FunctionLiteralNode* node, const std::vector<Value>& args, const Scope& caller, Value& result){
+	Entry& entry = m_entries[node];
+
+	if(!entry.compiled){
+		if(++entry.calls < CALL_THRESHOLD){
+			return false;
+		}
+		entry.compiled = true;
+		entry.code = compile(node);
+	}
+	if(!entry.code){
+		return false;
+	}
+
+	const CompiledFunction& code = *entry.code;
+
+	// guards
+	if(args.size() != code.param_slots.size()){
+		return false;
+	}
+	for(const auto& arg : args){
+		if(arg.getType() != ValueType::kDouble) return false;
+	}
+	for(const auto& name : code.locals){
+		if(caller.isDefined(name)) return false;
+	}
+
+	if(m_frame.size() < code.frame_size){
+		m_frame.resize(code.frame_size);
+	}
+	for(size_t i = 0; i < args.size(); ++i){
+		m_frame[code.param_slots[i]] = args[i].asNumber();
+	}
+
+	double value = 0;
+	switch(code.entry(m_frame.data(), &value)){
+		case kReturned:
+			result = Value(value);
+			return true;
+		case kFinished:
+			result = Value();
+			return true;
+		default:
+			return false;
+	}
+}
+
+std::unique_ptr<Jit::CompiledFunction> Jit::compile(const FunctionLiteralNode* node){
+	FunctionCompiler compiler;
+	if(!compiler.compile(node)){
+		return nullptr;
+	}
+
+	const std::vector<uint8_t>& bytes = compiler.code();
+
+	void* memory = mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(memory == MAP_FAILED){
+		return nullptr;
+	}
+
+	auto code = std::make_unique<CompiledFunction>();
+	code->memory = memory;
+	code->size = bytes.size();
+
+	std::memcpy(memory, bytes.data(), bytes.size());
+	if(mprotect(memory, bytes.size(), PROT_READ | PROT_EXEC) != 0){
+		return nullptr;
+	}
+
+	code->entry = reinterpret_cast<NativeEntry>(memory);
+	code->frame_size = compiler.frameSize();
+	code->param_slots = std::move(compiler.param_slots);
+	code->locals = std::move(compiler.locals);
+
+	return code;
+}
+
+#endif
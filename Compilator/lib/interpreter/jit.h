@@ -0,0 +1,59 @@
+#pragma once
+
+#ifdef ITMOSCRIPT_JIT
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "value.h"
+#include "scope.h"
+#include "../parser/ASTNode.h"
+
+// Baseline x86-64 JIT (Linux, ITMOSCRIPT_ENABLE_JIT).
+//
+// A function literal is compiled once it has been called CALL_THRESHOLD times,
+// if its body is purely numeric: parameters and local variables, + - * / % ^,
+// comparisons / and / or / not in conditions, if, while, break, continue,
+// assignments and return of a number. No calls and no access to outer variables,
+// so running the body has no side effects. Thanks to that the native code may
+// give up at any point (division by zero, ...) and the call is simply repeated
+// by the interpreter, which reports the error as usual.
+//
+// Guards on every call: all arguments are numbers and no local variable of the
+// function is visible from the caller (otherwise, with dynamic scoping, the
+// assignment would change the caller's variable).
+class Jit{
+private:
+	struct CompiledFunction; // jit.cpp
+
+	struct Entry{
+		size_t calls = 0;
+		bool compiled = false; // tried to compile (code may still be null)
+		std::unique_ptr<CompiledFunction> code;
+	};
+
+	std::unordered_map<const FunctionLiteralNode*, Entry> m_entries;
+
+	// slots of params, locals and temporaries; compiled code never calls back,
+	// so one buffer is enough
+	std::vector<double> m_frame;
+
+	// nullptr if the body is outside the compilable subset
+	static std::unique_ptr<CompiledFunction> compile(const FunctionLiteralNode* node);
+
+public:
+	static constexpr size_t CALL_THRESHOLD = 100;
+
+	Jit();
+	~Jit();
+
+	Jit(const Jit&) = delete;
+	Jit& operator=(const Jit&) = delete;
+
+	// true if the call was executed by native code, result is set then
+	bool tryCall(const FunctionLiteralNode* node, const std::vector<Value>& args, const Scope& caller, Value& result);
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "memoCache.h"
+
+#include <set>
+#include <utility>
+
+namespace{
+
+// lists may contain themselves, so the hash only looks this deep
+const int MAX_HASH_DEPTH = 8;
+
+void hashCombine(size_t& seed, size_t value){
+	seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+size_t hashValue(const Value& value, int depth){
+	size_t seed = static_cast<size_t>(value.getType());
+
+	switch(value.getType()){
+		case ValueType::kDouble: {
+			double num = value.asNumber();
+			if(num == 0) num = 0; // -0 == 0
+			hashCombine(seed, std::hash<double>{}(num));
+			break;
+		}
+		case ValueType::kString:
+			hashCombine(seed, std::hash<std::string>{}(*value.asString()));
+			break;
+		case ValueType::kBool:
+			hashCombine(seed, value.asBool());
+			break;
+		case ValueType::kNil:
+			break;
+		case ValueType::kList: {
+			const auto& list = *value.asList();
+			hashCombine(seed, list.size());
+			if(depth < MAX_HASH_DEPTH){
+				for(const auto& element : list){
+					hashCombine(seed, hashValue(element, depth + 1));
+				}
+			}
+			break;
+		}
+		case ValueType::kArray:
+			for(double num : *value.asArray()){
+				hashCombine(seed, std::hash<double>{}(num == 0 ? 0.0 : num));
+			}
+			break;
+		case ValueType::kFunc:
+			hashCombine(seed, std::hash<const void*>{}(value.asFunction().get()));
+			break;
+		case ValueType::kChannel:
+			hashCombine(seed, std::hash<const void*>{}(value.asChannel().get()));
+			break;
+		case ValueType::kFile:
+			hashCombine(seed, std::hash<const void*>{}(value.asFile().get()));
+			break;
+	}
+
+	return seed;
+}
+
+// lists may contain themselves: a pair of lists already being compared counts
+// as equal, the rest of the comparison decides
+bool equalValue(const Value& left, const Value& right, std::set<std::pair<const ListType*, const ListType*>>& visiting){
+	if(left.getType() != right.getType()){
+		return false;
+	}
+
+	switch(left.getType()){
+		case ValueType::kDouble: return left.asNumber() == right.asNumber();
+		case ValueType::kString: return *left.asString() == *right.asString();
+		case ValueType::kBool: return left.asBool() == right.asBool();
+		case ValueType::kNil: return true;
+		case ValueType::kList: {
+			const ListType* left_list = left.asList().get();
+			const ListType* right_list = right.asList().get();
+			if(left_list == right_list) return true;
+			if(left_list->size() != right_list->size()) return false;
+			if(!visiting.emplace(left_list, right_list).second) return true;
+
+			for(size_t i=0; i < left_list->size(); ++i){
+				if(!equalValue((*left_list)[i], (*right_list)[i], visiting)){
+					return false;
+				}
+			}
+			return true;
+		}
+		case ValueType::kArray: return *left.asArray() == *right.asArray();
+		case ValueType::kFunc: return left.asFunction() == right.asFunction();
+		case ValueType::kChannel: return left.asChannel() == right.asChannel();
+		case ValueType::kFile: return left.asFile() == right.asFile();
+	}
+
+	return false;
+}
+
+// списки и массивы копируем: аргумент или результат могут изменить после вызова
+Value copyValue(const Value& value, std::unordered_map<const ListType*, Value>& copies){
+	if(value.getType() == ValueType::kArray){
+		return Value(makeTracked<ArrayType>(*value.asArray()));
+	}
+	if(value.getType() != ValueType::kList){
+		return value;
+	}
+
+	const auto& source = value.asList();
+	auto it = copies.find(source.get());
+	if(it != copies.end()){
+		return it->second;
+	}
+
+	auto copy = makeTracked<ListType>();
+	Value result(copy);
+	copies.emplace(source.get(), result);
+
+	copy->reserve(source->size());
+	for(const auto& element : *source){
+		copy->push_back(copyValue(element, copies));
+	}
+
+	return result;
+}
+
+}
+
+size_t ValueHash::operator()(const Value& value) const{
+	return hashValue(value, 0);
+}
+
+size_t ValueHash::operator()(const std::vector<Value>& values) const{
+	size_t seed = values.size();
+	for(const auto& value : values){
+		hashCombine(seed, hashValue(value, 0));
+	}
+	return seed;
+}
+
+bool ValueEqual::operator()(const Value& left, const Value& right) const{
+	std::set<std::pair<const ListType*, const ListType*>> visiting;
+	return equalValue(left, right, visiting);
+}
+
+bool ValueEqual::operator()(const std::vector<Value>& left, const std::vector<Value>& right) const{
+	if(left.size() != right.size()){
+		return false;
+	}
+	for(size_t i=0; i < left.size(); ++i){
+		if(!(*this)(left[i], right[i])){
+			return false;
+		}
+	}
+	return true;
+}
+
+MemoCache::MemoCache(size_t capacity)
+	: m_capacity(capacity)
+{}
+
+std::optional<Value> MemoCache::find(const Key& args){
+	auto it = m_index.find(args);
+	if(it == m_index.end()){
+		++m_misses;
+		return std::nullopt;
+	}
+
+	++m_hits;
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	std::unordered_map<const ListType*, Value> copies;
+	return copyValue(it->second->second, copies);
+}
+
+void MemoCache::insert(const Key& args, const Value& result){
+	if(m_capacity == 0){
+		return;
+	}
+
+	std::unordered_map<const ListType*, Value> result_copies;
+	Value stored = copyValue(result, result_copies);
+
+	// recursive calls may have cached the same arguments already
+	auto it = m_index.find(args);
+	if(it != m_index.end()){
+		it->second->second = std::move(stored);
+		m_entries.splice(m_entries.begin(), m_entries, it->second);
+		return;
+	}
+
+	if(m_entries.size() >= m_capacity){
+		m_index.erase(m_entries.back().first);
+		m_entries.pop_back();
+	}
+
+	Key key;
+	key.reserve(args.size());
+	std::unordered_map<const ListType*, Value> copies;
+	for(const auto& arg : args){
+		key.push_back(copyValue(arg, copies));
+	}
+
+	m_entries.emplace_front(std::move(key), std::move(stored));
+	m_index.emplace(m_entries.front().first, m_entries.begin());
+}
+
+size_t MemoCache::hits() const{
+	return m_hits;
+}
+
+size_t MemoCache::misses() const{
+	return m_misses;
+}
+
+size_t MemoCache::size() const{
+	return m_entries.size();
+}
+
+size_t MemoCache::capacity() const{
+	return m_capacity;
+}
+
+std::shared_ptr<Function> makeMemoized(std::shared_ptr<Function> func, size_t capacity){
+	auto cache = std::make_shared<MemoCache>(capacity);
+
+	auto memoized = makeTracked<Function>([func, cache](const std::vector<Value>& call_args){
+		if(auto cached = cache->find(call_args)){
+			return *cached;
+		}
+
+		Value result = (*func)(call_args);
+		cache->insert(call_args, result);
+		return result;
+	});
+	memoized->setMemo(cache, func);
+
+	return memoized;
+}
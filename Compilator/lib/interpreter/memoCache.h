@@ -0,0 +1,56 @@
+#pragma once
+
+#include <list>
+#include <optional>
+#include <vector>
+#include <cstddef>
+#include <unordered_map>
+
+#include "value.h"
+
+// structural hash / equality of values (memoize keys)
+// numbers, strings, bools, nil, lists and arrays are compared by content,
+// functions and channels by identity
+struct ValueHash{
+	size_t operator()(const Value& value) const;
+	size_t operator()(const std::vector<Value>& values) const;
+};
+
+struct ValueEqual{
+	bool operator()(const Value& left, const Value& right) const;
+	bool operator()(const std::vector<Value>& left, const std::vector<Value>& right) const;
+};
+
+// LRU cache of function results, arguments -> result
+class MemoCache{
+private:
+	using Key = std::vector<Value>;
+	using Entry = std::pair<Key, Value>;
+
+	size_t m_capacity;
+
+	// front = most recently used
+	std::list<Entry> m_entries;
+	std::unordered_map<Key, std::list<Entry>::iterator, ValueHash, ValueEqual> m_index;
+
+	size_t m_hits = 0;
+	size_t m_misses = 0;
+
+public:
+	static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+	static constexpr size_t MAX_CAPACITY = 1 << 24;
+
+	explicit MemoCache(size_t capacity = DEFAULT_CAPACITY);
+
+	// lists and arrays are copied in and out: callers may change them
+	std::optional<Value> find(const Key& args);
+	void insert(const Key& args, const Value& result);
+
+	size_t hits() const;
+	size_t misses() const;
+	size_t size() const;
+	size_t capacity() const;
+};
+
+// memoize(func, capacity): func behind a fresh cache of results
+std::shared_ptr<Function> makeMemoized(std::shared_ptr<Function> func, size_t capacity);
@@ -0,0 +1,146 @@
+#include "memoryStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace{
+
+struct AtomicCounters{
+	std::atomic<size_t> allocations{0};
+	std::atomic<size_t> bytes{0};
+	std::atomic<size_t> live_bytes{0};
+};
+
+AtomicCounters g_kinds[MemoryStats::KINDS];
+std::atomic<size_t> g_live{0};
+std::atomic<size_t> g_peak{0};
+
+std::atomic<bool> g_track_lines{false};
+std::mutex g_lines_mutex;
+
+// строка -> {allocations, bytes}
+std::unordered_map<int, std::pair<size_t, size_t>>& lineTable(){
+	// never destroyed: values may be freed during static destruction
+	static auto* table = new std::unordered_map<int, std::pair<size_t, size_t>>();
+	return *table;
+}
+
+std::string formatBytes(size_t bytes){
+	const char* units[] = {"B", "KiB", "MiB", "GiB"};
+	double value = static_cast<double>(bytes);
+	size_t unit = 0;
+	while(value >= 1024 && unit + 1 < std::size(units)){
+		value /= 1024;
+		++unit;
+	}
+
+	std::ostringstream out;
+	if(unit == 0) out<<bytes<<" B";
+	else out<<std::fixed<<std::setprecision(1)<<value<<' '<<units[unit];
+	return out.str();
+}
+
+}
+
+void MemoryStats::allocated(MemoryKind kind, size_t bytes){
+	auto& counters = g_kinds[static_cast<size_t>(kind)];
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+	counters.live_bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+	size_t live = g_live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	size_t peak = g_peak.load(std::memory_order_relaxed);
+	while(live > peak && !g_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)){}
+
+	if(g_track_lines.load(std::memory_order_relaxed)){
+		std::lock_guard<std::mutex> lock(g_lines_mutex);
+		auto& line = lineTable()[s_line];
+		line.first += 1;
+		line.second += bytes;
+	}
+}
+
+void MemoryStats::freed(MemoryKind kind, size_t bytes){
+	g_kinds[static_cast<size_t>(kind)].live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+	g_live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+MemoryStats::Counters MemoryStats::get(MemoryKind kind){
+	const auto& counters = g_kinds[static_cast<size_t>(kind)];
+
+	Counters result;
+	result.allocations = counters.allocations.load(std::memory_order_relaxed);
+	result.bytes = counters.bytes.load(std::memory_order_relaxed);
+	result.live_bytes = counters.live_bytes.load(std::memory_order_relaxed);
+	return result;
+}
+
+size_t MemoryStats::liveBytes(){
+	return g_live.load(std::memory_order_relaxed);
+}
+
+size_t MemoryStats::peakBytes(){
+	return g_peak.load(std::memory_order_relaxed);
+}
+
+void MemoryStats::trackLines(bool enabled){
+	g_track_lines = enabled;
+}
+
+std::vector<MemoryStats::LineCounters> MemoryStats::lines(){
+	std::vector<LineCounters> result;
+	{
+		std::lock_guard<std::mutex> lock(g_lines_mutex);
+		for(const auto& [line, counters] : lineTable()){
+			result.push_back({line, counters.first, counters.second});
+		}
+	}
+
+	std::sort(result.begin(), result.end(), [](const LineCounters& left, const LineCounters& right){
+		if(left.bytes != right.bytes) return left.bytes > right.bytes;
+		return left.line < right.line;
+	});
+	return result;
+}
+
+const char* MemoryStats::kindName(MemoryKind kind){
+	switch(kind){
+		case MemoryKind::kString: return "string";
+		case MemoryKind::kList: return "list";
+		case MemoryKind::kFunction: return "function";
+		case MemoryKind::kArray: return "array";
+	}
+	return "unknown";
+}
+
+void MemoryStats::report(std::ostream& out, size_t top_lines){
+	out<<"memstats: peak "<<formatBytes(peakBytes())<<", live at exit "<<formatBytes(liveBytes())<<'\n';
+
+	out<<"  "<<std::left<<std::setw(10)<<"kind"<<std::right<<std::setw(14)<<"allocations"<<std::setw(14)<<"bytes"<<std::setw(14)<<"live"<<'\n';
+	for(size_t i = 0; i < KINDS; ++i){
+		auto kind = static_cast<MemoryKind>(i);
+		Counters counters = get(kind);
+		out<<"  "<<std::left<<std::setw(10)<<kindName(kind)<<std::right
+			<<std::setw(14)<<counters.allocations
+			<<std::setw(14)<<formatBytes(counters.bytes)
+			<<std::setw(14)<<formatBytes(counters.live_bytes)<<'\n';
+	}
+
+	auto by_line = lines();
+	if(by_line.empty()){
+		return;
+	}
+
+	out<<"  top lines by allocated bytes:\n";
+	for(size_t i = 0; i < by_line.size() && i < top_lines; ++i){
+		const auto& line = by_line[i];
+		std::string name = line.line > 0 ? "line "+std::to_string(line.line) : "setup";
+		out<<"  "<<std::left<<std::setw(10)<<name<<std::right
+			<<std::setw(14)<<line.allocations
+			<<std::setw(14)<<formatBytes(line.bytes)<<'\n';
+	}
+}
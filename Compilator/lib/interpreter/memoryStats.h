@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Heap accounting of value contents (memstats(), --memstats).
+//
+// Strings, lists, functions and arrays are allocated through TrackingAllocator /
+// makeTracked, which count allocations and bytes per kind, the live heap and its
+// peak. Counters are process-wide (isolates included). With trackLines(true)
+// every allocation is also attributed to the source line being executed.
+// Bytes are payload sizes: allocator overhead is not included.
+
+enum class MemoryKind{
+	kString,
+	kList,
+	kFunction,
+	kArray
+};
+
+class MemoryStats{
+public:
+	static constexpr size_t KINDS = 4;
+
+	struct Counters{
+		size_t allocations = 0;
+		size_t bytes = 0;		// allocated in total
+		size_t live_bytes = 0;	// not freed yet
+	};
+
+	struct LineCounters{
+		int line = 0;
+		size_t allocations = 0;
+		size_t bytes = 0;
+	};
+
+	// line of the statement being executed, restored on exit
+	class LineGuard{
+	private:
+		int m_previous;
+
+	public:
+		explicit LineGuard(int line)
+			: m_previous(s_line)
+		{
+			s_line = line;
+		}
+
+		~LineGuard(){
+			s_line = m_previous;
+		}
+
+		LineGuard(const LineGuard&) = delete;
+		LineGuard& operator=(const LineGuard&) = delete;
+	};
+
+	static void allocated(MemoryKind kind, size_t bytes);
+	static void freed(MemoryKind kind, size_t bytes);
+
+	static Counters get(MemoryKind kind);
+	static size_t liveBytes();
+	static size_t peakBytes();
+
+	static void trackLines(bool enabled);
+	// sorted by bytes, largest first
+	static std::vector<LineCounters> lines();
+
+	static const char* kindName(MemoryKind kind);
+
+	// report of --memstats
+	static void report(std::ostream& out, size_t top_lines = 10);
+
+private:
+	inline static thread_local int s_line = 0;
+};
+
+template<class T, MemoryKind Kind>
+class TrackingAllocator{
+public:
+	using value_type = T;
+
+	template<class U>
+	struct rebind{
+		using other = TrackingAllocator<U, Kind>;
+	};
+
+	TrackingAllocator() = default;
+
+	template<class U>
+	TrackingAllocator(const TrackingAllocator<U, Kind>&){}
+
+	T* allocate(size_t n){
+		T* result = std::allocator<T>().allocate(n);
+		MemoryStats::allocated(Kind, n * sizeof(T));
+		return result;
+	}
+
+	void deallocate(T* p, size_t n){
+		MemoryStats::freed(Kind, n * sizeof(T));
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	template<class U>
+	bool operator==(const TrackingAllocator<U, Kind>&) const{
+		return true;
+	}
+};
+
+// kind of the objects made by makeTracked<T>, specialized next to the types
+template<class T>
+struct TrackedKind;
+
+template<>
+struct TrackedKind<std::string>{
+	static constexpr MemoryKind value = MemoryKind::kString;
+};
+
+namespace detail{
+
+// string characters live outside the object, so they are counted on creation
+// (strings of values are not modified afterwards)
+struct TrackedStringDeleter{
+	size_t bytes;
+
+	void operator()(std::string* str) const{
+		MemoryStats::freed(MemoryKind::kString, bytes);
+		delete str;
+	}
+};
+
+}
+
+// std::make_shared that is counted in MemoryStats
+template<class T, class... Args>
+std::shared_ptr<T> makeTracked(Args&&... args){
+	if constexpr(std::is_same_v<T, std::string>){
+		auto str = std::make_unique<std::string>(std::forward<Args>(args)...);
+
+		size_t bytes = sizeof(std::string);
+		if(str->capacity() > std::string().capacity()){
+			bytes += str->capacity() + 1;
+		}
+		MemoryStats::allocated(MemoryKind::kString, bytes);
+
+		return std::shared_ptr<std::string>(str.release(), detail::TrackedStringDeleter{bytes});
+	}
+	else{
+		return std::allocate_shared<T>(TrackingAllocator<T, TrackedKind<T>::value>(), std::forward<Args>(args)...);
+	}
+}
@@ -0,0 +1,49 @@
+#include "outputBuffer.h"
+
+namespace{
+
+// several isolates may share one target stream
+std::mutex target_mutex;
+
+}
+
+OutputBuffer::OutputBuffer(std::streambuf* target)
+	: m_target(target)
+{
+	m_block.reserve(BLOCK_SIZE);
+}
+
+OutputBuffer::~OutputBuffer(){
+	flush();
+}
+
+void OutputBuffer::write(const Value& value){
+	value.appendTo(m_block);
+	if(m_block.size() >= BLOCK_SIZE) flush();
+}
+
+void OutputBuffer::write(std::string_view str){
+	m_block.append(str);
+	if(m_block.size() >= BLOCK_SIZE) flush();
+}
+
+void OutputBuffer::write(char c){
+	m_block.push_back(c);
+	if(m_block.size() >= BLOCK_SIZE) flush();
+}
+
+void OutputBuffer::flush(){
+	if(!m_target) return;
+
+	std::lock_guard<std::mutex> lock(target_mutex);
+
+	if(!m_block.empty()){
+		m_target->sputn(m_block.data(), static_cast<std::streamsize>(m_block.size()));
+		m_block.clear();
+	}
+	m_target->pubsync();
+}
+
+std::streambuf* OutputBuffer::target() const{
+	return m_target;
+}
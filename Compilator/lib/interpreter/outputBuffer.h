@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <streambuf>
+#include <mutex>
+
+#include "value.h"
+
+// print/println пишут сюда, а не в std::cout напрямую:
+// вывод копится блоками и уходит в поток только при flush
+class OutputBuffer{
+private:
+	static constexpr size_t BLOCK_SIZE = 1 << 16;
+
+	std::streambuf* m_target;
+	std::string m_block;
+
+public:
+	explicit OutputBuffer(std::streambuf* target);
+	~OutputBuffer();
+
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	void write(const Value& value);
+	void write(std::string_view str);
+	void write(char c);
+
+	// отдать накопленное в target (exit, read(), flush())
+	void flush();
+
+	// isolates print into the same stream as the interpreter that spawned them
+	std::streambuf* target() const;
+};
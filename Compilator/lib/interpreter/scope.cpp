@@ -51,6 +51,19 @@ bool Scope::isDefinedLocally(const std::string& name) const{
 	return variables.count(name);
 }
 
+bool Scope::isDefined(const std::string& name) const{
+	for(const Scope* scope = this; scope; scope = scope->outer_scope.get()){
+		if(scope->variables.count(name)){
+			return true;
+		}
+	}
+	return false;
+}
+
+const std::unordered_map<std::string, Value>& Scope::getVariables() const{
+	return variables;
+}
+
 const std::unique_ptr<ProgramNode>& Scope::getAstRoot() const{
 	return ast_root;
 }
\ No newline at end of file
@@ -34,6 +34,12 @@ public:
 	// is there a variable locally
 	bool isDefinedLocally(const std::string& name) const;
 
+	// is there a variable here or in outer scopes
+	bool isDefined(const std::string& name) const;
+
+	// local variables (isolate snapshot of globals)
+	const std::unordered_map<std::string, Value>& getVariables() const;
+
 	// show_ast
 	const std::unique_ptr<ProgramNode>& getAstRoot() const;
 };
\ No newline at end of file
@@ -6,13 +6,15 @@
 #include <algorithm>
 
 #include "scope.h"
+#include "memoCache.h"
+#include "file.h"
 
 StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	// random
 	std::srand(static_cast<unsigned>(std::time(nullptr)));
 
 	// abs(x)
-	globals.define("abs", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("abs", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("abs", 1, args.size());
 		}
@@ -24,7 +26,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// ceil(x)
-	globals.define("ceil", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("ceil", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("ceil", 1, args.size());
 		}
@@ -36,7 +38,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// floor(x)
-	globals.define("floor", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("floor", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("floor", 1, args.size());
 		}
@@ -48,7 +50,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// round(x)
-	globals.define("round", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("round", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("round", 1, args.size());
 		}
@@ -60,7 +62,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// sqrt(x)
-	globals.define("sqrt", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("sqrt", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("sqrt", 1, args.size());
 		}
@@ -75,7 +77,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// rnd(n)
-	globals.define("rnd", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("rnd", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("rnd", 1, args.size());
 		}
@@ -90,7 +92,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// parse_num(s)
-	globals.define("parse_num", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("parse_num", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("parse_num", 1, args.size());
 		}
@@ -111,7 +113,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// to_string(x)
-	globals.define("to_string", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("to_string", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("parse_num", 1, args.size());
 		}
@@ -120,12 +122,12 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// len(s)
-	globals.define("len", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("len", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("len", 1, args.size());
 		}
-		if(args[0].getType() != ValueType::kString && args[0].getType() != ValueType::kList){
-			ErrorManager("len", 0, "string or list", args[0].getType());
+		if(args[0].getType() != ValueType::kString && args[0].getType() != ValueType::kList && args[0].getType() != ValueType::kArray){
+			ErrorManager("len", 0, "string, list or array", args[0].getType());
 		}
 
 		if(args[0].getType() == ValueType::kString){
@@ -134,12 +136,15 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 		if(args[0].getType() == ValueType::kList){
 			return Value(static_cast<double>(args[0].asList()->size()));
 		}
+		if(args[0].getType() == ValueType::kArray){
+			return Value(static_cast<double>(args[0].asArray()->size()));
+		}
 
 		return Value();
 	})));
 
 	// lower(s)
-	globals.define("lower", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("lower", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("lower", 1, args.size());
 		}
@@ -154,7 +159,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// upper(s)
-	globals.define("upper", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("upper", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("upper", 1, args.size());
 		}
@@ -169,7 +174,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// split(s)
-	globals.define("split", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("split", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 2){
 			ErrorManager("split", 2, args.size());
 		}
@@ -182,7 +187,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 
 		std::string s = *args[0].asString();
 		std::string delim = *args[1].asString();
-		auto list = std::make_shared<ListType>();
+		auto list = makeTracked<ListType>();
 		list->reserve(s.size() /(delim.empty() ? 1 : delim.size()) + 1);
 
 		if(delim.empty()){
@@ -205,7 +210,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// join(list, delim)
-	globals.define("join", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("join", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 2){
 			ErrorManager("join", 2, args.size());
 		}
@@ -229,7 +234,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// replace(s, old, new)
-	globals.define("replace", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("replace", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 3){
 			ErrorManager("replace", 3, args.size());
 		}
@@ -257,7 +262,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// range(start, end, step)
-	globals.define("range", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("range", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() < 1 || args.size() > 3){
 			ErrorManager("range", "requires 1 to 3 arguments, got " + std::to_string(args.size()));
 		}
@@ -273,7 +278,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 
 		if(step == 0) ErrorManager("range", "step cannot be zero");
 
-		auto list = std::make_shared<ListType>();
+		auto list = makeTracked<ListType>();
 		if(step > 0){
 			for(double i = start; i < end; i += step){
 				list->push_back(Value(i));
@@ -289,7 +294,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// push(list, x)
-	globals.define("push", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("push", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 2){
 			ErrorManager("push", 2, args.size());
 		}
@@ -303,7 +308,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// pop(list)
-	globals.define("pop", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("pop", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("pop", 1, args.size());
 		}
@@ -321,7 +326,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// insert(list, index, x)
-	globals.define("insert", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("insert", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 3){
 			ErrorManager("insert", 3, args.size());
 		}
@@ -342,7 +347,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// remove(list, index)
-	globals.define("remove", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("remove", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 2){
 			ErrorManager("remove", 2, args.size());
 		}
@@ -366,7 +371,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// sort(list)
-	globals.define("sort", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("sort", Value(makeTracked<Function>([](const std::vector<Value>& args){
 		if(args.size() != 1){
 			ErrorManager("sort", 1, args.size());
 		}
@@ -392,30 +397,435 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 		return Value(); // nil
 	})));
 
+	// array(list)
+	globals.define("array", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("array", 1, args.size());
+		}
+		if(args[0].getType() == ValueType::kArray){
+			return Value(makeTracked<ArrayType>(*args[0].asArray()));
+		}
+		if(args[0].getType() != ValueType::kList){
+			ErrorManager("array", 0, "list or array", args[0].getType());
+		}
+
+		auto list = args[0].asList();
+		auto array = makeTracked<ArrayType>();
+		array->reserve(list->size());
+
+		for(const Value& elem : *list){
+			if(elem.getType() != ValueType::kDouble){
+				ErrorManager("array", "list elements must be numbers");
+			}
+			array->push_back(elem.asNumber());
+		}
+
+		return Value(array);
+	})));
+
+	// arange(start, end, step)
+	globals.define("arange", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() < 1 || args.size() > 3){
+			ErrorManager("arange", "requires 1 to 3 arguments, got " + std::to_string(args.size()));
+		}
+		for(size_t i=0; i < args.size(); ++i){
+			if(args[i].getType() != ValueType::kDouble){
+				ErrorManager("arange", i, "number", args[i].getType());
+			}
+		}
+
+		double start =(args.size() == 1) ? 0 : args[0].asNumber();
+		double end =(args.size() == 1) ? args[0].asNumber() : args[1].asNumber();
+		double step =(args.size() == 3) ? args[2].asNumber() : 1.0;
+
+		if(step == 0) ErrorManager("arange", "step cannot be zero");
+
+		// same sequence as range(), without a Value per element
+		auto array = makeTracked<ArrayType>();
+		if(step > 0){
+			for(double i = start; i < end; i += step){
+				array->push_back(i);
+			}
+		}
+		else{
+			for(double i = start; i > end; i += step){
+				array->push_back(i);
+			}
+		}
+
+		return Value(array);
+	})));
+
+	// sum(array)
+	globals.define("sum", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("sum", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kArray){
+			ErrorManager("sum", 0, "array", args[0].getType());
+		}
+
+		auto array = args[0].asArray();
+
+		return Value(array_kernels::sum(array->data(), array->size()));
+	})));
+
+	// min(array)
+	globals.define("min", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("min", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kArray){
+			ErrorManager("min", 0, "array", args[0].getType());
+		}
+
+		auto array = args[0].asArray();
+		if(array->empty()) return Value(); // nil
+
+		return Value(array_kernels::min(array->data(), array->size()));
+	})));
+
+	// max(array)
+	globals.define("max", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("max", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kArray){
+			ErrorManager("max", 0, "array", args[0].getType());
+		}
+
+		auto array = args[0].asArray();
+		if(array->empty()) return Value(); // nil
+
+		return Value(array_kernels::max(array->data(), array->size()));
+	})));
+
+	// dot(a, b)
+	globals.define("dot", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 2){
+			ErrorManager("dot", 2, args.size());
+		}
+		if(args[0].getType() != ValueType::kArray){
+			ErrorManager("dot", 0, "array", args[0].getType());
+		}
+		if(args[1].getType() != ValueType::kArray){
+			ErrorManager("dot", 1, "array", args[1].getType());
+		}
+
+		auto a = args[0].asArray();
+		auto b = args[1].asArray();
+		if(a->size() != b->size()){
+			ErrorManager("dot", "arrays must have the same length");
+		}
+
+		return Value(array_kernels::dot(a->data(), b->data(), a->size()));
+	})));
+
+	// memoize(func, capacity)
+	globals.define("memoize", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1 && args.size() != 2){
+			ErrorManager("memoize", 1, 2, args.size());
+		}
+		if(args[0].getType() != ValueType::kFunc){
+			ErrorManager("memoize", 0, "function", args[0].getType());
+		}
+
+		size_t capacity = MemoCache::DEFAULT_CAPACITY;
+		if(args.size() == 2){
+			if(args[1].getType() != ValueType::kDouble){
+				ErrorManager("memoize", 1, "number", args[1].getType());
+			}
+			// cast to size_t is defined only for integers in range
+			double requested = args[1].asNumber();
+			if(!std::isfinite(requested) || requested != std::floor(requested) || requested < 1 || requested > MemoCache::MAX_CAPACITY){
+				ErrorManager("memoize", "capacity must be an integer from 1 to " + std::to_string(MemoCache::MAX_CAPACITY));
+			}
+			capacity = static_cast<size_t>(requested);
+		}
+
+		return Value(makeMemoized(args[0].asFunction(), capacity));
+	})));
+
+	// memo_stats(func) -> [hits, misses, size, capacity]
+	globals.define("memo_stats", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("memo_stats", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kFunc){
+			ErrorManager("memo_stats", 0, "function", args[0].getType());
+		}
+
+		const auto& cache = args[0].asFunction()->getMemo();
+		if(!cache){
+			ErrorManager("memo_stats", "function is not memoized");
+		}
+
+		auto stats = makeTracked<ListType>();
+		stats->push_back(Value(static_cast<double>(cache->hits())));
+		stats->push_back(Value(static_cast<double>(cache->misses())));
+		stats->push_back(Value(static_cast<double>(cache->size())));
+		stats->push_back(Value(static_cast<double>(cache->capacity())));
+
+		return Value(stats);
+	})));
+
+	// spawn(func, args) -> channel with the result
+	globals.define("spawn", Value(makeTracked<Function>([&interpreter](const std::vector<Value>& args){
+		if(args.size() != 2){
+			ErrorManager("spawn", 2, args.size());
+		}
+		if(args[0].getType() != ValueType::kFunc){
+			ErrorManager("spawn", 0, "function", args[0].getType());
+		}
+		if(args[1].getType() != ValueType::kList){
+			ErrorManager("spawn", 1, "list", args[1].getType());
+		}
+
+		return interpreter.spawn(args[0], *args[1].asList());
+	})));
+
+	// pmap(func, list, workers) -> [func(x) for x in list]
+	globals.define("pmap", Value(makeTracked<Function>([&interpreter](const std::vector<Value>& args){
+		if(args.size() != 2 && args.size() != 3){
+			ErrorManager("pmap", 2, 3, args.size());
+		}
+		if(args[0].getType() != ValueType::kFunc){
+			ErrorManager("pmap", 0, "function", args[0].getType());
+		}
+		if(args[1].getType() != ValueType::kList){
+			ErrorManager("pmap", 1, "list", args[1].getType());
+		}
+
+		size_t workers = std::max(1u, std::thread::hardware_concurrency());
+		if(args.size() == 3){
+			if(args[2].getType() != ValueType::kDouble){
+				ErrorManager("pmap", 2, "number", args[2].getType());
+			}
+			if(args[2].asNumber() < 1){
+				ErrorManager("pmap", "number of workers must be positive");
+			}
+			workers = static_cast<size_t>(args[2].asNumber());
+		}
+
+		return interpreter.pmap(args[0], *args[1].asList(), workers);
+	})));
+
+	// channel()
+	globals.define("channel", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 0){
+			ErrorManager("channel", 0, args.size());
+		}
+
+		return Value(std::make_shared<Channel>());
+	})));
+
+	// send(ch, x)
+	globals.define("send", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 2){
+			ErrorManager("send", 2, args.size());
+		}
+		if(args[0].getType() != ValueType::kChannel){
+			ErrorManager("send", 0, "channel", args[0].getType());
+		}
+
+		args[0].asChannel()->send(Interpreter::detach(args[1]));
+		return Value();
+	})));
+
+	// recv(ch)
+	globals.define("recv", Value(makeTracked<Function>([&interpreter](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("recv", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kChannel){
+			ErrorManager("recv", 0, "channel", args[0].getType());
+		}
+
+		// то, что напечатали до ожидания, не должно оказаться после вывода isolate
+		interpreter.output().flush();
+
+		return interpreter.adopt(args[0].asChannel()->receive());
+	})));
+
+	// open(path, mode)
+	globals.define("open", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1 && args.size() != 2){
+			ErrorManager("open", 1, 2, args.size());
+		}
+		if(args[0].getType() != ValueType::kString){
+			ErrorManager("open", 0, "string", args[0].getType());
+		}
+
+		std::string mode = "r";
+		if(args.size() == 2){
+			if(args[1].getType() != ValueType::kString){
+				ErrorManager("open", 1, "string", args[1].getType());
+			}
+			mode = *args[1].asString();
+		}
+
+		return Value(std::make_shared<File>(*args[0].asString(), mode));
+	})));
+
+	// read_all(f) or read_all(path)
+	globals.define("read_all", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("read_all", 1, args.size());
+		}
+		if(args[0].getType() == ValueType::kString){
+			File file(*args[0].asString(), "r");
+			return Value(std::string(file.readAll()));
+		}
+		if(args[0].getType() != ValueType::kFile){
+			ErrorManager("read_all", 0, "file or string", args[0].getType());
+		}
+
+		return Value(std::string(args[0].asFile()->readAll()));
+	})));
+
+	// read_line(f)
+	globals.define("read_line", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("read_line", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kFile){
+			ErrorManager("read_line", 0, "file", args[0].getType());
+		}
+
+		auto line = args[0].asFile()->readLine();
+		if(!line){
+			return Value();
+		}
+		return Value(std::string(*line));
+	})));
+
+	// read_lines(f, n)
+	globals.define("read_lines", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1 && args.size() != 2){
+			ErrorManager("read_lines", 1, 2, args.size());
+		}
+		if(args[0].getType() != ValueType::kFile){
+			ErrorManager("read_lines", 0, "file", args[0].getType());
+		}
+
+		// по кускам: весь многогигабайтный файл строками в память не влезет
+		size_t count = 4096;
+		if(args.size() == 2){
+			if(args[1].getType() != ValueType::kDouble){
+				ErrorManager("read_lines", 1, "number", args[1].getType());
+			}
+			if(args[1].asNumber() < 1){
+				ErrorManager("read_lines", "number of lines must be positive");
+			}
+			count = static_cast<size_t>(args[1].asNumber());
+		}
+
+		const auto& file = args[0].asFile();
+		auto lines = makeTracked<ListType>();
+		while(lines->size() < count){
+			auto line = file->readLine();
+			if(!line) break;
+			lines->emplace_back(std::string(*line));
+		}
+
+		return Value(lines);
+	})));
+
+	// write(f, args)
+	globals.define("write", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.empty()){
+			ErrorManager("write", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kFile){
+			ErrorManager("write", 0, "file", args[0].getType());
+		}
+
+		const auto& file = args[0].asFile();
+		std::string text;
+		for(size_t i = 1; i < args.size(); ++i){
+			if(args[i].getType() == ValueType::kString){
+				file->write(*args[i].asString());
+				continue;
+			}
+			text.clear();
+			args[i].appendTo(text);
+			file->write(text);
+		}
+
+		return Value();
+	})));
+
+	// write_file(path, s)
+	globals.define("write_file", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 2){
+			ErrorManager("write_file", 2, args.size());
+		}
+		if(args[0].getType() != ValueType::kString){
+			ErrorManager("write_file", 0, "string", args[0].getType());
+		}
+
+		File file(*args[0].asString(), "w");
+		if(args[1].getType() == ValueType::kString){
+			file.write(*args[1].asString());
+		}
+		else{
+			file.write(args[1].toString());
+		}
+		file.close();
+
+		return Value();
+	})));
+
+	// close(f)
+	globals.define("close", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 1){
+			ErrorManager("close", 1, args.size());
+		}
+		if(args[0].getType() != ValueType::kFile){
+			ErrorManager("close", 0, "file", args[0].getType());
+		}
+
+		args[0].asFile()->close();
+		return Value();
+	})));
+
 	// print(args)
-	globals.define("print", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("print", Value(makeTracked<Function>([&interpreter](const std::vector<Value>& args){
 		for(const Value& val : args){
-			std::cout<<val.toString();
+			interpreter.output().write(val);
 		}
 
 		return Value();
 	})));
 
 	// println(args)
-	globals.define("println", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("println", Value(makeTracked<Function>([&interpreter](const std::vector<Value>& args){
 		for(const Value& val : args){
-			std::cout<<val.toString();
+			interpreter.output().write(val);
 		}
-		std::cout<<'\n';
+		interpreter.output().write('\n');
+
+		return Value();
+	})));
+
+	// flush()
+	globals.define("flush", Value(makeTracked<Function>([&interpreter](const std::vector<Value>& args){
+		if(args.size() != 0){
+			ErrorManager("flush", 0, args.size());
+		}
+
+		interpreter.output().flush();
 
 		return Value();
 	})));
 
 	// read(cin)
-	globals.define("read", Value(std::make_shared<Function>([](const std::vector<Value>& args){
+	globals.define("read", Value(makeTracked<Function>([&interpreter](const std::vector<Value>& args){
 		for(const Value& val : args){
-			std::cout<<val.toString();
+			interpreter.output().write(val);
 		}
+		// prompt and everything before it must be visible before blocking on input
+		interpreter.output().flush();
 
 		std::string in;
 		std::getline(std::cin, in);
@@ -423,8 +833,34 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 		return Value(in);
 	})));
 
+	// memstats()
+	globals.define("memstats", Value(makeTracked<Function>([](const std::vector<Value>& args){
+		if(args.size() != 0){
+			ErrorManager("memstats", 0, args.size());
+		}
+
+		auto kinds = makeTracked<ListType>();
+		for(size_t i = 0; i < MemoryStats::KINDS; ++i){
+			auto kind = static_cast<MemoryKind>(i);
+			MemoryStats::Counters counters = MemoryStats::get(kind);
+
+			auto row = makeTracked<ListType>();
+			row->push_back(Value(MemoryStats::kindName(kind)));
+			row->push_back(Value(static_cast<double>(counters.allocations)));
+			row->push_back(Value(static_cast<double>(counters.bytes)));
+			row->push_back(Value(static_cast<double>(counters.live_bytes)));
+			kinds->push_back(Value(row));
+		}
+
+		auto result = makeTracked<ListType>();
+		result->push_back(Value(static_cast<double>(MemoryStats::liveBytes())));
+		result->push_back(Value(static_cast<double>(MemoryStats::peakBytes())));
+		result->push_back(Value(kinds));
+		return Value(result);
+	})));
+
 	// stacktrace()
-	globals.define("stacktrace", Value(std::make_shared<Function>([&](const std::vector<Value>& args){
+	globals.define("stacktrace", Value(makeTracked<Function>([&](const std::vector<Value>& args){
 		if(args.size() != 0){
 			ErrorManager("stacktrace", 0, args.size());
 		}
@@ -433,11 +869,13 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// show_ast()
-	globals.define("show_ast", Value(std::make_shared<Function>([&globals](const std::vector<Value>& args){
+	globals.define("show_ast", Value(makeTracked<Function>([&globals, &interpreter](const std::vector<Value>& args){
 		if(args.size() != 0){
 			ErrorManager("show_ast", 0, args.size());
 		}
 
+		interpreter.output().flush();
+
 		std::cout<<"Abstract Syntax Tree(AST):\n";
 		const auto& ast_root = globals.getAstRoot();
 
@@ -454,11 +892,13 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// exit()
-	globals.define("exit", Value(std::make_shared<Function>([&globals](const std::vector<Value>& args){
+	globals.define("exit", Value(makeTracked<Function>([&globals, &interpreter](const std::vector<Value>& args){
 		if(args.size() != 0){
 			ErrorManager("exit", 0, args.size());
 		}
 
+		interpreter.output().flush();
+
 		std::cout<<"\nExiting interactive mode (exit).\n";
 		exit(0);
 
@@ -466,11 +906,13 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 	})));
 
 	// help()
-	globals.define("help", Value(std::make_shared<Function>([&globals](const std::vector<Value>& args){
+	globals.define("help", Value(makeTracked<Function>([&globals, &interpreter](const std::vector<Value>& args){
 		if(args.size() != 0){
 			ErrorManager("help", 0, args.size());
 		}
 
+		interpreter.output().flush();
+
 		std::cout<<"Welcome to ITMOScript 1.0.0's help utility!\n\n";
 		std::cout<<"Available standard library functions:\n";
 		std::cout<<"------------------------------------\n";
@@ -488,7 +930,7 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 
 		// String functions
 		std::cout<<"\nString functions:\n";
-		std::cout<<"  len(s)           - Returns the length of string or list s\n";
+		std::cout<<"  len(s)           - Returns the length of string, list or array s\n";
 		std::cout<<"  lower(s)         - Converts string s to lowercase\n";
 		std::cout<<"  upper(s)         - Converts string s to uppercase\n";
 		std::cout<<"  split(s, delim)  - Splits string s by delimiter delim into a list\n";
@@ -505,12 +947,46 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 		std::cout<<"  remove(list, index) - Removes and returns element at index in list (nil if invalid)\n";
 		std::cout<<"  sort(list)       - Sorts list in ascending order\n";
 
+		// Array functions
+		std::cout<<"\nArray functions (packed numbers, element-wise + - * /):\n";
+		std::cout<<"  array(list)      - Creates an array from a list of numbers\n";
+		std::cout<<"  arange(x, y, step) - Same as range, but returns an array\n";
+		std::cout<<"  sum(a)           - Sum of array elements\n";
+		std::cout<<"  min(a), max(a)   - Smallest / largest element (nil if empty)\n";
+		std::cout<<"  dot(a, b)        - Dot product of two arrays of the same length\n";
+
+		// Memoization
+		std::cout<<"\nMemoization:\n";
+		std::cout<<"  memoize(f, capacity) - Returns f with an LRU cache of results (capacity is optional)\n";
+		std::cout<<"  memo_stats(f)    - [hits, misses, size, capacity] of a memoized function\n";
+
+		// Isolates
+		std::cout<<"\nIsolates (functions running in parallel, sharing nothing but channels):\n";
+		std::cout<<"  spawn(f, args)   - Runs f(args...) on its own thread, returns a channel with the result\n";
+		std::cout<<"  pmap(f, list, workers) - [f(x) for x in list] computed by a pool of isolates (workers is optional)\n";
+		std::cout<<"  channel()        - Creates a channel\n";
+		std::cout<<"  send(ch, x)      - Sends a copy of x to channel ch\n";
+		std::cout<<"  recv(ch)         - Waits for the next value from channel ch\n";
+
+		// Files
+		std::cout<<"\nFiles:\n";
+		std::cout<<"  open(path, mode) - Opens a file, mode is \"r\" (default), \"w\" or \"a\"\n";
+		std::cout<<"  read_all(f)      - Rest of file f (or of the file at path f) as a string\n";
+		std::cout<<"  read_line(f)     - Next line of f, nil at the end\n";
+		std::cout<<"  read_lines(f, n) - Next n lines of f as a list (4096 by default), [] at the end\n";
+		std::cout<<"  write(f, ...)    - Writes arguments to f\n";
+		std::cout<<"  write_file(path, s) - Replaces contents of the file at path with s\n";
+		std::cout<<"  close(f)         - Closes f (and writes buffered data)\n";
+		std::cout<<"  for line in f    - Iterates over the remaining lines of f\n";
+
 		// System functions
 		std::cout<<"\nSystem functions:\n";
 		std::cout<<"  print(...)       - Prints arguments without a newline\n";
 		std::cout<<"  println(...)     - Prints arguments with a newline\n";
 		std::cout<<"  read(...)        - Reads a line from input, optionally printing arguments first\n";
+		std::cout<<"  flush()          - Writes buffered output of print/println immediately\n";
 		std::cout<<"  stacktrace()     - Returns the current call stack as a list\n";
+		std::cout<<"  memstats()       - [live bytes, peak bytes, [[kind, allocations, bytes, live bytes], ...]] of the heap\n";
 		std::cout<<"  show_ast()       - Prints the abstract syntax tree of the program\n";
 		std::cout<<"  exit()           - Exits the interpreter\n";
 		std::cout<<"  help()           - Displays this help message\n";
@@ -519,4 +995,9 @@ StandardLibrary::StandardLibrary(Scope& globals, Interpreter& interpreter){
 
 		return Value();
 	})));
+
+	// isolates rebind aliases of builtins (p = println) by this name
+	for(const auto& [name, value] : globals.getVariables()){
+		value.asFunction()->setBuiltin(name);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,550 @@
+#include "typeInference.h"
+
+namespace{
+
+// builtins that never call back into script code, with their result type
+const std::unordered_map<std::string, std::optional<ValueType>> trusted_builtins = {
+	{"abs", ValueType::kDouble},
+	{"ceil", ValueType::kDouble},
+	{"floor", ValueType::kDouble},
+	{"round", ValueType::kDouble},
+	{"sqrt", ValueType::kDouble},
+	{"rnd", ValueType::kDouble},
+	{"parse_num", std::nullopt},	// nil при ошибке
+	{"to_string", ValueType::kString},
+	{"len", ValueType::kDouble},
+	{"lower", ValueType::kString},
+	{"upper", ValueType::kString},
+	{"split", ValueType::kList},
+	{"join", ValueType::kString},
+	{"replace", ValueType::kString},
+	{"range", ValueType::kList},
+	{"push", ValueType::kNil},
+	{"pop", std::nullopt},
+	{"insert", std::nullopt},
+	{"remove", std::nullopt},
+	{"sort", ValueType::kNil},
+	{"array", ValueType::kArray},
+	{"arange", ValueType::kArray},
+	{"sum", ValueType::kDouble},
+	{"min", std::nullopt},			// nil for an empty array
+	{"max", std::nullopt},
+	{"dot", ValueType::kDouble},
+	{"memoize", ValueType::kFunc},
+	{"memo_stats", ValueType::kList},
+	{"spawn", ValueType::kChannel},	// runs in another isolate
+	{"pmap", ValueType::kList},
+	{"channel", ValueType::kChannel},
+	{"send", ValueType::kNil},
+	{"recv", std::nullopt},
+	{"open", ValueType::kFile},
+	{"read_all", ValueType::kString},
+	{"read_line", std::nullopt},	// nil at the end of file
+	{"read_lines", ValueType::kList},
+	{"write", ValueType::kNil},
+	{"write_file", ValueType::kNil},
+	{"close", ValueType::kNil},
+	{"print", ValueType::kNil},
+	{"println", ValueType::kNil},
+	{"flush", ValueType::kNil},
+	{"read", ValueType::kString},
+	{"stacktrace", ValueType::kList},
+	{"memstats", ValueType::kList}
+};
+
+bool isArithmetic(TokenType op){
+	switch(op){
+		case TokenType::tPlus:
+		case TokenType::tMinus:
+		case TokenType::tMultiply:
+		case TokenType::tDivide:
+		case TokenType::tModule:
+		case TokenType::tPower:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool isComparison(TokenType op){
+	switch(op){
+		case TokenType::tEqual:
+		case TokenType::tNotEqual:
+		case TokenType::tLess:
+		case TokenType::tGreater:
+		case TokenType::tLessOrEqual:
+		case TokenType::tGreaterOrEqual:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// x += e -> x + e
+TokenType compoundOperator(TokenType op){
+	switch(op){
+		case TokenType::tPlusAssign: return TokenType::tPlus;
+		case TokenType::tMinusAssign: return TokenType::tMinus;
+		case TokenType::tMultiplyAssign: return TokenType::tMultiply;
+		case TokenType::tDivideAssign: return TokenType::tDivide;
+		case TokenType::tModuleAssign: return TokenType::tModule;
+		case TokenType::tPowerAssign: return TokenType::tPower;
+		default: return TokenType::tERROR;
+	}
+}
+
+}
+
+void TypeInference::run(ProgramNode* program){
+	if(!program){
+		return;
+	}
+
+	collectBoundNames(program);
+
+	m_facts.clear();
+	for(auto& stmt : program->statements){
+		if(stmt) statement(stmt.get());
+	}
+}
+
+void TypeInference::collectBoundNames(const ASTNode* node){
+	if(!node){
+		return;
+	}
+
+	if(auto program = dynamic_cast<const ProgramNode*>(node)){
+		for(const auto& stmt : program->statements) collectBoundNames(stmt.get());
+	}
+	else if(auto block_node = dynamic_cast<const BlockNode*>(node)){
+		for(const auto& stmt : block_node->statements) collectBoundNames(stmt.get());
+	}
+	else if(auto expr_stmt = dynamic_cast<const ExpressionStatementNode*>(node)){
+		collectBoundNames(expr_stmt->expression.get());
+	}
+	else if(auto if_stmt = dynamic_cast<const IfStatementNode*>(node)){
+		collectBoundNames(if_stmt->condition.get());
+		collectBoundNames(if_stmt->thenBranch.get());
+		collectBoundNames(if_stmt->elseBranch.get());
+	}
+	else if(auto while_stmt = dynamic_cast<const WhileStatementNode*>(node)){
+		collectBoundNames(while_stmt->condition.get());
+		collectBoundNames(while_stmt->body.get());
+	}
+	else if(auto for_stmt = dynamic_cast<const ForStatementNode*>(node)){
+		m_bound_names.insert(for_stmt->loopVariable->name);
+		collectBoundNames(for_stmt->iterable.get());
+		collectBoundNames(for_stmt->body.get());
+	}
+	else if(auto return_stmt = dynamic_cast<const ReturnStatementNode*>(node)){
+		collectBoundNames(return_stmt->returnValue.get());
+	}
+	else if(auto func = dynamic_cast<const FunctionLiteralNode*>(node)){
+		for(const auto& param : func->parameters) m_bound_names.insert(param->name);
+		collectBoundNames(func->body.get());
+	}
+	else if(auto assign = dynamic_cast<const AssignmentNode*>(node)){
+		if(auto id_node = dynamic_cast<const IdentifierNode*>(assign->expression_l.get())){
+			m_bound_names.insert(id_node->name);
+		}
+		else{
+			collectBoundNames(assign->expression_l.get());
+		}
+		collectBoundNames(assign->expression_r.get());
+	}
+	else if(auto binary = dynamic_cast<const BinaryOpNode*>(node)){
+		collectBoundNames(binary->left.get());
+		collectBoundNames(binary->right.get());
+	}
+	else if(auto unary = dynamic_cast<const UnaryOpNode*>(node)){
+		collectBoundNames(unary->operand.get());
+	}
+	else if(auto list = dynamic_cast<const ListLiteralNode*>(node)){
+		for(const auto& elem : list->elements) collectBoundNames(elem.get());
+	}
+	else if(auto call_node = dynamic_cast<const FunctionCallNode*>(node)){
+		collectBoundNames(call_node->callee.get());
+		for(const auto& arg : call_node->arguments) collectBoundNames(arg.get());
+	}
+	else if(auto index = dynamic_cast<const IndexExpressionNode*>(node)){
+		collectBoundNames(index->object.get());
+		collectBoundNames(index->index.get());
+	}
+	else if(auto slice = dynamic_cast<const SliceExpressionNode*>(node)){
+		collectBoundNames(slice->object.get());
+		collectBoundNames(slice->start.get());
+		collectBoundNames(slice->end.get());
+	}
+}
+
+void TypeInference::analyzeFunction(FunctionLiteralNode* node){
+	// тело выполняется позже и где угодно: ничего не известно, даже типы параметров
+	Facts saved_facts = std::move(m_facts);
+	std::vector<LoopFacts> saved_loops = std::move(m_loops);
+
+	m_facts.clear();
+	m_loops.clear();
+
+	if(node->body){
+		block(node->body.get());
+	}
+
+	m_facts = std::move(saved_facts);
+	m_loops = std::move(saved_loops);
+}
+
+void TypeInference::statement(StatementNode* node){
+	if(auto expr_stmt = dynamic_cast<ExpressionStatementNode*>(node)){
+		if(expr_stmt->expression) expression(expr_stmt->expression.get());
+	}
+	else if(auto block_node = dynamic_cast<BlockNode*>(node)){
+		block(block_node);
+	}
+	else if(auto if_stmt = dynamic_cast<IfStatementNode*>(node)){
+		ifStatement(if_stmt);
+	}
+	else if(auto while_stmt = dynamic_cast<WhileStatementNode*>(node)){
+		whileStatement(while_stmt);
+	}
+	else if(auto for_stmt = dynamic_cast<ForStatementNode*>(node)){
+		forStatement(for_stmt);
+	}
+	else if(auto return_stmt = dynamic_cast<ReturnStatementNode*>(node)){
+		if(return_stmt->returnValue) expression(return_stmt->returnValue.get());
+	}
+	else if(dynamic_cast<BreakStatementNode*>(node)){
+		if(!m_loops.empty()) m_loops.back().breaks.push_back(m_facts);
+	}
+	else if(dynamic_cast<ContinueStatementNode*>(node)){
+		if(!m_loops.empty()) m_loops.back().continues.push_back(m_facts);
+	}
+}
+
+void TypeInference::block(BlockNode* node){
+	for(auto& stmt : node->statements){
+		if(stmt) statement(stmt.get());
+	}
+}
+
+void TypeInference::ifStatement(IfStatementNode* node){
+	expression(node->condition.get());
+	Facts after_condition = m_facts;
+
+	if(node->thenBranch){
+		block(node->thenBranch.get());
+	}
+	Facts after_then = std::move(m_facts);
+
+	m_facts = std::move(after_condition);
+	if(node->elseBranch){
+		statement(node->elseBranch.get());
+	}
+
+	m_facts = merge(after_then, m_facts);
+}
+
+void TypeInference::whileStatement(WhileStatementNode* node){
+	Facts head = m_facts;
+
+	// facts only disappear, so this converges in at most (number of facts) rounds
+	while(true){
+		m_facts = head;
+		expression(node->condition.get());
+		Facts after_condition = m_facts;
+
+		m_loops.emplace_back();
+		if(node->body){
+			block(node->body.get());
+		}
+		LoopFacts loop = std::move(m_loops.back());
+		m_loops.pop_back();
+
+		Facts next = merge(head, m_facts);
+		for(const auto& facts : loop.continues){
+			next = merge(next, facts);
+		}
+
+		if(next == head){
+			m_facts = std::move(after_condition);
+			for(const auto& facts : loop.breaks){
+				m_facts = merge(m_facts, facts);
+			}
+			return;
+		}
+
+		head = std::move(next);
+	}
+}
+
+void TypeInference::forStatement(ForStatementNode* node){
+	std::optional<ValueType> iterable_type = expression(node->iterable.get());
+
+	std::optional<ValueType> element_type;
+	if(iterable_type == ValueType::kArray){
+		element_type = ValueType::kDouble;
+	}
+	else if(iterable_type == ValueType::kString || iterable_type == ValueType::kFile){
+		element_type = ValueType::kString;
+	}
+	else if(auto call_node = dynamic_cast<const FunctionCallNode*>(node->iterable.get())){
+		// range() of a trusted builtin produces numbers only
+		auto callee = dynamic_cast<const IdentifierNode*>(call_node->callee.get());
+		std::optional<ValueType> ignored;
+		if(callee && callee->name == "range" && isTrustedBuiltin(callee, ignored)){
+			element_type = ValueType::kDouble;
+		}
+	}
+
+	// переменная цикла живёт в scope тела, снаружи остаётся прежнее значение
+	const std::string& name = node->loopVariable->name;
+	std::optional<ValueType> outer_type = getFact(name);
+
+	Facts head = m_facts;
+
+	while(true){
+		m_facts = head;
+		setFact(name, element_type);
+
+		m_loops.emplace_back();
+		if(node->body){
+			block(node->body.get());
+		}
+		LoopFacts loop = std::move(m_loops.back());
+		m_loops.pop_back();
+
+		Facts next = merge(head, m_facts);
+		for(const auto& facts : loop.continues){
+			next = merge(next, facts);
+		}
+		m_facts = std::move(next);
+		setFact(name, outer_type);
+		next = std::move(m_facts);
+
+		if(next == head){
+			m_facts = std::move(head);
+			for(const auto& facts : loop.breaks){
+				m_facts = merge(m_facts, facts);
+			}
+			setFact(name, outer_type);
+			return;
+		}
+
+		head = std::move(next);
+	}
+}
+
+std::optional<ValueType> TypeInference::expression(ExpressionNode* node){
+	if(!node){
+		return std::nullopt;
+	}
+
+	node->static_type = infer(node);
+	return node->static_type;
+}
+
+std::optional<ValueType> TypeInference::infer(ExpressionNode* node){
+	if(dynamic_cast<NumberLiteralNode*>(node)){
+		return ValueType::kDouble;
+	}
+	if(dynamic_cast<StringLiteralNode*>(node)){
+		return ValueType::kString;
+	}
+	if(dynamic_cast<BooleanLiteralNode*>(node)){
+		return ValueType::kBool;
+	}
+	if(dynamic_cast<NilLiteralNode*>(node)){
+		return ValueType::kNil;
+	}
+	if(auto id_node = dynamic_cast<IdentifierNode*>(node)){
+		return getFact(id_node->name);
+	}
+	if(auto list = dynamic_cast<ListLiteralNode*>(node)){
+		for(auto& elem : list->elements) expression(elem.get());
+		return ValueType::kList;
+	}
+	if(auto func = dynamic_cast<FunctionLiteralNode*>(node)){
+		analyzeFunction(func);
+		return ValueType::kFunc;
+	}
+	if(auto binary = dynamic_cast<BinaryOpNode*>(node)){
+		std::optional<ValueType> left = expression(binary->left.get());
+		std::optional<ValueType> right;
+
+		if(binary->op == TokenType::tAnd || binary->op == TokenType::tOr){
+			// правая часть может и не выполниться
+			Facts before_right = m_facts;
+			right = expression(binary->right.get());
+			m_facts = merge(before_right, m_facts);
+		}
+		else{
+			right = expression(binary->right.get());
+		}
+
+		binary->numeric_operands = (left == ValueType::kDouble && right == ValueType::kDouble)
+			&& (isArithmetic(binary->op) || isComparison(binary->op));
+
+		return binaryResult(binary->op, left, right);
+	}
+	if(auto unary = dynamic_cast<UnaryOpNode*>(node)){
+		std::optional<ValueType> operand = expression(unary->operand.get());
+
+		if(unary->op == TokenType::tNot){
+			return ValueType::kBool;
+		}
+		if(operand == ValueType::kDouble){
+			return ValueType::kDouble;
+		}
+		return std::nullopt;
+	}
+	if(auto assign = dynamic_cast<AssignmentNode*>(node)){
+		return assignment(assign);
+	}
+	if(auto call_node = dynamic_cast<FunctionCallNode*>(node)){
+		return call(call_node);
+	}
+	if(auto index = dynamic_cast<IndexExpressionNode*>(node)){
+		expression(index->object.get());
+		expression(index->index.get());
+		return std::nullopt; // nil out of range
+	}
+	if(auto slice = dynamic_cast<SliceExpressionNode*>(node)){
+		std::optional<ValueType> object = expression(slice->object.get());
+		expression(slice->start.get());
+		expression(slice->end.get());
+
+		if(object == ValueType::kList || object == ValueType::kArray || object == ValueType::kString){
+			return object;
+		}
+		return std::nullopt;
+	}
+
+	return std::nullopt;
+}
+
+std::optional<ValueType> TypeInference::assignment(AssignmentNode* node){
+	// правая часть вычисляется первой
+	std::optional<ValueType> rvalue = expression(node->expression_r.get());
+
+	if(auto id_node = dynamic_cast<IdentifierNode*>(node->expression_l.get())){
+		if(node->assignmentOp == TokenType::tAssign){
+			setFact(id_node->name, rvalue);
+			return rvalue;
+		}
+
+		id_node->static_type = getFact(id_node->name);
+
+		std::optional<ValueType> result = binaryResult(compoundOperator(node->assignmentOp), id_node->static_type, rvalue);
+		setFact(id_node->name, result);
+		return result;
+	}
+
+	if(auto index = dynamic_cast<IndexExpressionNode*>(node->expression_l.get())){
+		expression(index->object.get());
+		expression(index->index.get());
+	}
+
+	if(node->assignmentOp == TokenType::tAssign){
+		return rvalue;
+	}
+	return std::nullopt;
+}
+
+std::optional<ValueType> TypeInference::call(FunctionCallNode* node){
+	expression(node->callee.get());
+	for(auto& arg : node->arguments){
+		expression(arg.get());
+	}
+
+	std::optional<ValueType> result;
+	if(isTrustedBuiltin(node->callee.get(), result)){
+		return result;
+	}
+
+	forgetAll();
+	return std::nullopt;
+}
+
+bool TypeInference::isTrustedBuiltin(const ExpressionNode* callee, std::optional<ValueType>& result) const{
+	auto id_node = dynamic_cast<const IdentifierNode*>(callee);
+	if(!id_node || m_bound_names.contains(id_node->name)){
+		return false;
+	}
+
+	auto it = trusted_builtins.find(id_node->name);
+	if(it == trusted_builtins.end()){
+		return false;
+	}
+
+	result = it->second;
+	return true;
+}
+
+void TypeInference::forgetAll(){
+	m_facts.clear();
+
+	// the function may also break/continue the loop we are in
+	if(!m_loops.empty()){
+		m_loops.back().breaks.emplace_back();
+		m_loops.back().continues.emplace_back();
+	}
+}
+
+void TypeInference::setFact(const std::string& name, std::optional<ValueType> type){
+	if(type){
+		m_facts[name] = *type;
+	}
+	else{
+		m_facts.erase(name);
+	}
+}
+
+std::optional<ValueType> TypeInference::getFact(const std::string& name) const{
+	auto it = m_facts.find(name);
+	if(it == m_facts.end()){
+		return std::nullopt;
+	}
+	return it->second;
+}
+
+TypeInference::Facts TypeInference::merge(const Facts& left, const Facts& right){
+	Facts result;
+	for(const auto& [name, type] : left){
+		auto it = right.find(name);
+		if(it != right.end() && it->second == type){
+			result.emplace(name, type);
+		}
+	}
+	return result;
+}
+
+std::optional<ValueType> TypeInference::binaryResult(TokenType op, std::optional<ValueType> left, std::optional<ValueType> right){
+	if(op == TokenType::tAnd || op == TokenType::tOr){
+		return ValueType::kBool;
+	}
+	if(isComparison(op)){
+		return ValueType::kBool;
+	}
+	if(!left || !right || !isArithmetic(op)){
+		return std::nullopt;
+	}
+
+	if(*left == ValueType::kDouble && *right == ValueType::kDouble){
+		return ValueType::kDouble;
+	}
+
+	// element-wise arithmetic
+	bool array_operands = (*left == ValueType::kArray || *left == ValueType::kDouble)
+		&& (*right == ValueType::kArray || *right == ValueType::kDouble);
+	if(array_operands && op != TokenType::tModule && op != TokenType::tPower){
+		return ValueType::kArray;
+	}
+
+	if(op == TokenType::tPlus && *left == *right && (*left == ValueType::kString || *left == ValueType::kList)){
+		return *left;
+	}
+	if(op == TokenType::tMinus && *left == ValueType::kString && *right == ValueType::kString){
+		return ValueType::kString;
+	}
+
+	return std::nullopt;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "value.h"
+#include "../parser/ASTNode.h"
+
+// Flow-sensitive type inference, runs once over the program before execution.
+// Fills ExpressionNode::static_type and BinaryOpNode::numeric_operands, so the
+// interpreter can skip type checks where types are statically known.
+//
+// Scoping is dynamic (a called function may assign any variable of the caller),
+// so every call of a script function forgets all facts. Builtins that never run
+// script code are trusted, unless the program binds their name itself.
+class TypeInference{
+private:
+	using Facts = std::unordered_map<std::string, ValueType>;
+
+	struct LoopFacts{
+		std::vector<Facts> breaks;
+		std::vector<Facts> continues;
+	};
+
+	// variable -> known type at the current point
+	Facts m_facts;
+
+	// facts at break/continue of enclosing loops (innermost is last)
+	std::vector<LoopFacts> m_loops;
+
+	// names assigned, used as parameters or loop variables anywhere in the program
+	std::unordered_set<std::string> m_bound_names;
+
+	void collectBoundNames(const ASTNode* node);
+
+	void analyzeFunction(FunctionLiteralNode* node);
+
+	// statements
+	void statement(StatementNode* node);
+	void block(BlockNode* node);
+	void ifStatement(IfStatementNode* node);
+	void whileStatement(WhileStatementNode* node);
+	void forStatement(ForStatementNode* node);
+
+	// expressions, returns (and stores) the static type
+	std::optional<ValueType> expression(ExpressionNode* node);
+	std::optional<ValueType> infer(ExpressionNode* node);
+	std::optional<ValueType> assignment(AssignmentNode* node);
+	std::optional<ValueType> call(FunctionCallNode* node);
+
+	// builtin called by name, if it can be trusted
+	bool isTrustedBuiltin(const ExpressionNode* callee, std::optional<ValueType>& result) const;
+
+	// nothing is known after a call of a script function
+	void forgetAll();
+
+	void setFact(const std::string& name, std::optional<ValueType> type);
+	std::optional<ValueType> getFact(const std::string& name) const;
+
+	// facts that hold on both paths
+	static Facts merge(const Facts& left, const Facts& right);
+
+public:
+	static std::optional<ValueType> binaryResult(TokenType op, std::optional<ValueType> left, std::optional<ValueType> right);
+
+	void run(ProgramNode* program);
+};
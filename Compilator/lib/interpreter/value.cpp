@@ -1,17 +1,20 @@
 #include "value.h"
 
 #include "errorManager.h"
+#include "file.h"
+
+#include <charconv>
 
 Value::Value(double val)
 	: data(val)
 {}
 
 Value::Value(const std::string& val)
-	: data(std::make_shared<std::string>(val))
+	: data(makeTracked<std::string>(val))
 {}
 
 Value::Value(const char* val)
-	: data(std::make_shared<std::string>(val))
+	: data(makeTracked<std::string>(val))
 {}
 
 Value::Value(bool val)
@@ -30,6 +33,18 @@ Value::Value(std::shared_ptr<Function> val)
 	: data(val)
 {}
 
+Value::Value(std::shared_ptr<ArrayType> val)
+	: data(val)
+{}
+
+Value::Value(std::shared_ptr<Channel> val)
+	: data(val)
+{}
+
+Value::Value(std::shared_ptr<File> val)
+	: data(val)
+{}
+
 
 ValueType Value::getType() const{
 	switch(data.index()){
@@ -39,6 +54,9 @@ ValueType Value::getType() const{
 		case 3: return ValueType::kNil;
 		case 4: return ValueType::kList;
 		case 5: return ValueType::kFunc;
+		case 6: return ValueType::kArray;
+		case 7: return ValueType::kChannel;
+		case 8: return ValueType::kFile;
 		default:
 			return ValueType::kNil;
 	}
@@ -89,52 +107,121 @@ std::shared_ptr<Function> Value::asFunction() const{
 	return nullptr;
 }
 
+std::shared_ptr<ArrayType> Value::asArray() const{
+	if(auto val = std::get_if<std::shared_ptr<ArrayType>>(&data)){
+		return *val;
+	}
+
+	ErrorManager("Value is not an array");
+	return nullptr;
+}
+
+std::shared_ptr<Channel> Value::asChannel() const{
+	if(auto val = std::get_if<std::shared_ptr<Channel>>(&data)){
+		return *val;
+	}
+
+	ErrorManager("Value is not a channel");
+	return nullptr;
+}
+
+std::shared_ptr<File> Value::asFile() const{
+	if(auto val = std::get_if<std::shared_ptr<File>>(&data)){
+		return *val;
+	}
+
+	ErrorManager("Value is not a file");
+	return nullptr;
+}
+
+
 
+void appendNumber(std::string& out, double num){
+	// 2^53: every integer below is exactly representable
+	constexpr double kMaxExactInteger = 9007199254740992.0;
+
+	char buf[32];
+	std::to_chars_result res;
+
+	if(std::trunc(num) == num && std::abs(num) < kMaxExactInteger && !(num == 0 && std::signbit(num))){
+		res = std::to_chars(buf, buf + sizeof(buf), static_cast<long long>(num));
+	}
+	else{
+		res = std::to_chars(buf, buf + sizeof(buf), num);
+	}
+
+	out.append(buf, res.ptr);
+}
 
 std::string Value::toString() const{
-	switch(getType()){
-		case ValueType::kDouble:{
-			double num = asNumber();
+	if(getType() == ValueType::kString) return *(asString());
 
-			std::string str = std::to_string(num);
-			str.erase(str.find_last_not_of('0') + 1, std::string::npos);
-			if(str.back() == '.') str.pop_back();
+	std::string out;
+	appendTo(out);
 
-			return str;
-		}
+	return out;
+}
 
-		case ValueType::kString: return *(asString());
-		case ValueType::kBool: return asBool() ? "true" : "false";
-		case ValueType::kNil: return "nil";
+void Value::appendTo(std::string& out) const{
+	switch(getType()){
+		case ValueType::kDouble: appendNumber(out, asNumber()); break;
+		case ValueType::kString: out += *(asString()); break;
+		case ValueType::kBool: out += asBool() ? "true" : "false"; break;
+		case ValueType::kNil: out += "nil"; break;
 		case ValueType::kList:{
 			auto list = asList();
 
-			std::string out;
-			out.reserve(list->size() * 10);
 			out += "[";
 
 			for(size_t i = 0; i < list->size(); ++i){
 				if(i > 0) out += ", ";
 
 				if((*list)[i].getType() == ValueType::kString){
-					out += "\""+(*list)[i].toString()+"\"";
+					out += '"';
+					(*list)[i].appendTo(out);
+					out += '"';
 				}
 				else{
-					out +=(*list)[i].toString();
+					(*list)[i].appendTo(out);
 				}
 			}
 			out += "]";
 
-			return out;
+			break;
 		}
 
 		case ValueType::kFunc:{
 			std::shared_ptr<Function> func = asFunction();
 
-			return "<function at "+std::to_string(reinterpret_cast<uintptr_t>(func.get()))+">";
+			out += "<function at "+std::to_string(reinterpret_cast<uintptr_t>(func.get()))+">";
+			break;
+		}
+
+		case ValueType::kArray:{
+			auto array = asArray();
+
+			out += "array([";
+
+			for(size_t i = 0; i < array->size(); ++i){
+				if(i > 0) out += ", ";
+				appendNumber(out, (*array)[i]);
+			}
+			out += "])";
+
+			break;
+		}
+
+		case ValueType::kChannel:{
+			out += "<channel at "+std::to_string(reinterpret_cast<uintptr_t>(asChannel().get()))+">";
+			break;
+		}
+
+		case ValueType::kFile:{
+			out += "<file \""+asFile()->path()+"\">";
+			break;
 		}
 
-		default: return "";
+		default: break;
 	}
 }
 
@@ -146,6 +233,9 @@ bool Value::isTruthy() const{
 		case ValueType::kNil: return false;
 		case ValueType::kList: return !asList()->empty();
 		case ValueType::kFunc: return true; // function is always true
+		case ValueType::kArray: return !asArray()->empty();
+		case ValueType::kChannel: return true;
+		case ValueType::kFile: return true;
 		default: return false;
 	}
 }
\ No newline at end of file
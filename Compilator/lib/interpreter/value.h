@@ -1,18 +1,24 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 #include <variant>
 #include <functional>
 #include <cmath>
 
+#include "memoryStats.h"
+
 enum class ValueType{
 	kDouble,
 	kString,
 	kBool,
 	kNil,
 	kList,
-	kFunc
+	kFunc,
+	kArray,
+	kChannel,
+	kFile
 };
 
 class Value;
@@ -20,8 +26,30 @@ class Value;
 class Nil{};
 
 class Function;
+class Channel;
+class File;
+class MemoCache;
+
+struct FunctionLiteralNode;
+
+// element storage is counted in memoryStats.h
+using ListType = std::vector<Value, TrackingAllocator<Value, MemoryKind::kList>>;
+using ArrayType = std::vector<double, TrackingAllocator<double, MemoryKind::kArray>>; // packed numbers, see arrayKernels.h
+
+template<>
+struct TrackedKind<ListType>{
+	static constexpr MemoryKind value = MemoryKind::kList;
+};
+
+template<>
+struct TrackedKind<ArrayType>{
+	static constexpr MemoryKind value = MemoryKind::kArray;
+};
 
-using ListType = std::vector<Value>;
+template<>
+struct TrackedKind<Function>{
+	static constexpr MemoryKind value = MemoryKind::kFunction;
+};
 
 class Value{
 private:
@@ -31,7 +59,10 @@ private:
 		bool,							// bool
 		std::nullptr_t,					// nil
 		std::shared_ptr<ListType>,		// list
-		std::shared_ptr<Function>		// function
+		std::shared_ptr<Function>,		// function
+		std::shared_ptr<ArrayType>,		// array
+		std::shared_ptr<Channel>,		// channel (spawn/send/recv)
+		std::shared_ptr<File>			// file (open)
 	> data;
 
 public:
@@ -43,6 +74,9 @@ public:
 	Value();
 	Value(std::shared_ptr<ListType> val);
 	Value(std::shared_ptr<Function> val);
+	Value(std::shared_ptr<ArrayType> val);
+	Value(std::shared_ptr<Channel> val);
+	Value(std::shared_ptr<File> val);
 
 	ValueType getType() const; // get ValueType lol
 
@@ -52,20 +86,69 @@ public:
 	bool asBool() const;
 	std::shared_ptr<ListType> asList() const;
 	std::shared_ptr<Function> asFunction() const;
+	std::shared_ptr<ArrayType> asArray() const;
+	std::shared_ptr<Channel> asChannel() const;
+	std::shared_ptr<File> asFile() const;
 
 	std::string toString() const; // converts everything to string for output
+	void appendTo(std::string& out) const; // same as toString, but without temporary strings
 	bool isTruthy() const; // true or false (typical for loops and if)
 };
 
+// shortest round-trip form of a number (integers are printed without exponent)
+void appendNumber(std::string& out, double num);
+
 class Function{
 private:
 	std::function<Value(const std::vector<Value>&)> func;
 
+	// literal this function was made from (nullptr for builtins),
+	// lets an isolate build its own copy of the function
+	const FunctionLiteralNode* source = nullptr;
+
+	// name in the standard library (empty for script functions),
+	// lets an isolate bind its own builtin in place of an alias
+	std::string builtin;
+
+	// results cache of memoize(f) and f itself, nullptr for plain functions
+	std::shared_ptr<MemoCache> memo;
+	std::shared_ptr<Function> wrapped;
+
 public:
 	Function(std::function<Value(const std::vector<Value>&)> f)
 		: func(f)
 	{}
 
+	Function(std::function<Value(const std::vector<Value>&)> f, const FunctionLiteralNode* src)
+		: func(f)
+		, source(src)
+	{}
+
+	const FunctionLiteralNode* getSource() const{
+		return source;
+	}
+
+	void setBuiltin(const std::string& name){
+		builtin = name;
+	}
+
+	const std::string& getBuiltin() const{
+		return builtin;
+	}
+
+	void setMemo(std::shared_ptr<MemoCache> cache, std::shared_ptr<Function> func){
+		memo = std::move(cache);
+		wrapped = std::move(func);
+	}
+
+	const std::shared_ptr<MemoCache>& getMemo() const{
+		return memo;
+	}
+
+	const std::shared_ptr<Function>& getWrapped() const{
+		return wrapped;
+	}
+
 	Value operator()(const std::vector<Value>& args){
 		return func(args);
 	}
@@ -59,7 +59,7 @@ std::string tokenTypeToStr(TokenType type) {
 }
 
 const std::unordered_map<std::string, TokenType> keywords = {
-    {"if", TokenType::tEndIf},
+    {"if", TokenType::tIf},
     {"else", TokenType::tElse},
     {"then", TokenType::tThen},
     {"while", TokenType::tWhile},
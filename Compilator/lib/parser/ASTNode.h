@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <iomanip>
+#include <optional>
 
 #include "../lexer/lexer.h"
 #include "../interpreter/value.h"
@@ -53,7 +54,10 @@ struct ASTNode{
 };
 
 // Expressions
-struct ExpressionNode : public ASTNode{};
+struct ExpressionNode : public ASTNode{
+	// type known before execution (see typeInference.h), nullopt = dynamic
+	std::optional<ValueType> static_type;
+};
 
 struct NumberLiteralNode : public ExpressionNode{
 	double value;
@@ -107,6 +111,9 @@ struct BinaryOpNode : public ExpressionNode{
 	std::unique_ptr<ExpressionNode> left;
 	std::unique_ptr<ExpressionNode> right;
 
+	// both operands are numbers, no type dispatch needed
+	bool numeric_operands = false;
+
 	BinaryOpNode(TokenType o, std::unique_ptr<ExpressionNode> l, std::unique_ptr<ExpressionNode> r, int l_num);
 	std::string toString(int indent = 0) const override;
 	Value accept(Interpreter& interpreter) const override;
@@ -423,7 +423,7 @@ std::unique_ptr<ExpressionNode> Parser::parsePrimary(){
 
 	if(match(TokenType::tLParenthesis)){
 		auto expr = parseExpression();
-		consume(TokenType::tLParenthesis, "Expect ')' after expression in parentheses.");
+		consume(TokenType::tRParenthesis, "Expect ')' after expression in parentheses.");
 		return expr;
 	}
 
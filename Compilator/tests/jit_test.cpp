@@ -0,0 +1,161 @@
+#include <../lib/interpreter/interpreter.h>
+#include <gtest/gtest.h>
+
+// Functions are called more than Jit::CALL_THRESHOLD times, so with
+// ITMOSCRIPT_JIT the later calls run natively; the output must not change.
+
+TEST(JitTestSuite, NumericLoopTest) {
+    std::string code = R"(
+        sum_squares = function(n)
+            s = 0
+            i = 1
+            while i <= n
+                if i % 3 == 0 and not (i > 100) then
+                    i += 1
+                    continue
+                end if
+                s += i ^ 2 / 2
+                i += 1
+            end while
+            return s
+        end function
+
+        total = 0
+        for k in range(300)
+            total += sum_squares(k)
+        end for
+        print(total)
+    )";
+
+    std::string expected = "324830833.5";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(JitTestSuite, ComparisonsTest) {
+    std::string code = R"(
+        cmp = function(a, b)
+            r = 0
+            if a < b then
+                r += 1
+            end if
+            if a <= b then
+                r += 10
+            end if
+            if a > b then
+                r += 100
+            end if
+            if a >= b then
+                r += 1000
+            end if
+            if a == b then
+                r += 10000
+            end if
+            if a != b then
+                r += 100000
+            end if
+            return -r
+        end function
+
+        nan = (-1) ^ 0.5
+        for i in range(150)
+            cmp(i, 1)
+        end for
+        println(cmp(1, 2), " ", cmp(2, 2), " ", cmp(3, 2), " ", cmp(nan, 2), " ", cmp(nan, nan))
+    )";
+
+    std::string expected = "-100011 -11010 -101100 -100000 -100000\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(JitTestSuite, GuardsTest) {
+    std::string code = R"(
+        acc = 0
+        store = function(x)
+            acc = x
+            return acc
+        end function
+        twice = function(x)
+            return x + x
+        end function
+        nothing = function(x)
+            y = x
+        end function
+
+        for i in range(200)
+            store(i)
+            twice(i)
+        end for
+        println(acc, " ", twice(21), " ", twice("ab"), " ", nothing(1))
+    )";
+
+    std::string expected = "199 42 abab nil\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(JitTestSuite, BailoutTest) {
+    std::string code = R"(
+        inverse = function(x)
+            return 1 / x
+        end function
+
+        for i in range(200)
+            inverse(i + 1)
+        end for
+        print("ok")
+        inverse(0)
+        print("unreachable")
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_EQ(output.str(), "ok");
+}
+
+
+#ifdef ITMOSCRIPT_JIT
+
+TEST(JitTestSuite, TierUpTest) {
+    Lexer lexer("f = function(a, b) return a * b - 1 end function");
+    Parser parser(lexer);
+    std::unique_ptr<ProgramNode> program = parser.parseProgram();
+
+    auto stmt = dynamic_cast<ExpressionStatementNode*>(program->statements.at(0).get());
+    auto assign = dynamic_cast<AssignmentNode*>(stmt->expression.get());
+    auto func = dynamic_cast<FunctionLiteralNode*>(assign->expression_r.get());
+    ASSERT_NE(func, nullptr);
+
+    Scope caller(std::unique_ptr<ProgramNode>{});
+    Jit jit;
+    Value result;
+
+    for (size_t i = 1; i < Jit::CALL_THRESHOLD; ++i) {
+        ASSERT_FALSE(jit.tryCall(func, {Value(2.0), Value(3.0)}, caller, result));
+    }
+
+    ASSERT_TRUE(jit.tryCall(func, {Value(2.0), Value(3.0)}, caller, result));
+    ASSERT_EQ(result.asNumber(), 5.0);
+
+    ASSERT_FALSE(jit.tryCall(func, {Value(2.0), Value("s")}, caller, result));
+}
+
+#endif
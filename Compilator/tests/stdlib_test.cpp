@@ -0,0 +1,544 @@
+#include <../lib/interpreter/interpreter.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <thread>
+
+#include <unistd.h>
+
+
+TEST(StdlibTestSuite, NumberFormattingTest) {
+    std::string code = R"(
+        println(3)
+        println(-7)
+        println(0.1 + 0.2)
+        println(1 / 4)
+        println(1e20)
+        println(2.5e-8)
+        print([1, 1.5, "a"])
+    )";
+
+    std::string expected = "3\n-7\n0.30000000000000004\n0.25\n1e+20\n2.5e-08\n[1, 1.5, \"a\"]";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, BufferedOutputTest) {
+    std::string code = R"(
+        for i in range(20000)
+            print(i % 10)
+        end for
+        flush()
+        println()
+    )";
+
+    std::string expected;
+    for (int i = 0; i < 20000; ++i) {
+        expected += static_cast<char>('0' + i % 10);
+    }
+    expected += "\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, OutputBeforeErrorTest) {
+    std::string code = R"(
+        print("before")
+        x = 1 + "a"
+        print("after")
+    )";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_FALSE(interpret(input, output));
+    ASSERT_EQ(output.str(), "before");
+}
+
+
+TEST(StdlibTestSuite, ArrayArithmeticTest) {
+    std::string code = R"(
+        a = array([1, 2, 3, 4, 5])
+        b = arange(5)
+        println(a + b)
+        println(a * 2 - 1)
+        println(10 / a[:2])
+        println(a[-1], " ", a[1:3], " ", len(a))
+        a[0] += 10
+        println(a)
+        for x in arange(0, 1, 0.5)
+            print(x, ";")
+        end for
+    )";
+
+    std::string expected =
+        "array([1, 3, 5, 7, 9])\n"
+        "array([1, 3, 5, 7, 9])\n"
+        "array([10, 5])\n"
+        "5 array([2, 3]) 5\n"
+        "array([11, 2, 3, 4, 5])\n"
+        "0;0.5;";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, ArrayReductionTest) {
+    std::string code = R"(
+        a = arange(1, 101)
+        println(sum(a), " ", min(a), " ", max(a))
+        println(dot(a[:3], array([1, 0, -1])))
+        print(min(array([])))
+    )";
+
+    std::string expected = "5050 1 100\n-2\nnil";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, ArrayIllegalOperationsTest) {
+    std::vector<std::string> codes = {
+        "x = array([1, 2]) + array([1, 2, 3])",
+        "x = array([1, 2]) + [1, 2]",
+        "x = array([1, \"a\"])",
+        "x = array([1, 2]) / array([1, 0])",
+        "a = array([1])\na[0] = \"s\"",
+    };
+
+    for (const auto& code : codes) {
+        std::istringstream input(code);
+        std::ostringstream output;
+
+        ASSERT_FALSE(interpret(input, output)) << code;
+    }
+}
+
+
+TEST(StdlibTestSuite, SpawnTest) {
+    std::string code = R"(
+        k = 10
+        shifted_square = function(x)
+            return x * x + k
+        end function
+
+        tasks = []
+        for i in range(4)
+            push(tasks, spawn(shifted_square, [i]))
+        end for
+        for t in tasks
+            print(recv(t), " ")
+        end for
+    )";
+
+    std::string expected = "10 11 14 19 ";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, ChannelTest) {
+    std::string code = R"(
+        data = [1, 2]
+        producer = function(ch, n)
+            i = 0
+            while i < n
+                send(ch, [i, "x"])
+                i += 1
+            end while
+            data[0] = 100
+            return data
+        end function
+
+        ch = channel()
+        t = spawn(producer, [ch, 3])
+        println(recv(ch), recv(ch), recv(ch))
+        println(recv(t), " ", data)
+    )";
+
+    std::string expected = "[0, \"x\"][1, \"x\"][2, \"x\"]\n[100, 2] [1, 2]\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, SpawnGlobalsTest) {
+    std::string code = R"(
+        fib = function(n)
+            if n < 2 then
+                return n
+            end if
+            return fib(n - 1) + fib(n - 2)
+        end function
+        fib = memoize(fib)
+
+        g = function(x)
+            return fib(x)
+        end function
+        println(recv(spawn(g, [3])), " ", recv(spawn(g, [70])), " ", memo_stats(fib))
+
+        p = println
+        h = function(x)
+            p("isolate ", x)
+            return len(x)
+        end function
+        println = nil
+        p(recv(spawn(h, ["abc"])))
+    )";
+
+    std::string expected = "2 190392490709135 [0, 0, 0, 65536]\nisolate abc\n3\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, SpawnFailureTest) {
+    std::vector<std::string> codes = {
+        "f = function(x) return x + \"a\" end function\nrecv(spawn(f, [1]))",
+        "f = function(g) return g end function\nrecv(spawn(f, [print]))",
+        "x = spawn(print, [])",
+        "send(channel(), [len])",
+    };
+
+    for (const auto& code : codes) {
+        std::istringstream input(code);
+        std::ostringstream output;
+
+        ASSERT_FALSE(interpret(input, output)) << code;
+    }
+}
+
+
+TEST(StdlibTestSuite, MemoizeTest) {
+    std::string code = R"(
+        fib = function(n)
+            if n < 2 then
+                return n
+            end if
+            return fib(n - 1) + fib(n - 2)
+        end function
+
+        fib = memoize(fib)
+        println(fib(70))
+        println(memo_stats(fib))
+
+        calls = 0
+        total = function(xs)
+            calls += 1
+            s = 0
+            for x in xs
+                s += x
+            end for
+            return s
+        end function
+        total = memoize(total, 2)
+
+        xs = [1, 2]
+        total(xs)
+        push(xs, 3)
+        println(total(xs), " ", total([1, 2]), " ", total([1, 2, 3]), " ", calls)
+        total([10])
+        total([1, 2])
+        println(memo_stats(total))
+
+        pair = function(n)
+            return [n, n]
+        end function
+        pair = memoize(pair)
+        r = pair(1)
+        push(r, 5)
+        push(pair(1), 6)
+        println(pair(1), " ", r)
+
+        cyclic = [1]
+        push(cyclic, cyclic)
+        same = [1]
+        push(same, same)
+        size = function(xs)
+            return len(xs)
+        end function
+        size = memoize(size)
+        println(size(cyclic), " ", size(cyclic), " ", size(same), " ", memo_stats(size))
+    )";
+
+    std::string expected = "190392490709135\n[68, 71, 71, 65536]\n6 3 6 2\n[2, 4, 2, 2]\n[1, 1] [1, 1, 5]\n2 2 2 [2, 1, 1, 65536]\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, MemoizeFailureTest) {
+    std::vector<std::string> codes = {
+        "memoize()",
+        "f = function(x) return x end function\nmemoize(f, 1, 2)",
+        "f = function(x) return x end function\nmemoize(f, 0)",
+        "f = function(x) return x end function\nmemoize(f, -1)",
+        "f = function(x) return x end function\nmemoize(f, 0.5)",
+        "f = function(x) return x end function\nmemoize(f, 1e300)",
+        "f = function(x) return x end function\nmemoize(f, parse_num(\"nan\"))",
+    };
+
+    for (const auto& code : codes) {
+        std::istringstream input(code);
+        std::ostringstream output;
+
+        ASSERT_FALSE(interpret(input, output)) << code;
+    }
+}
+
+
+TEST(StdlibTestSuite, PmapTest) {
+    std::string code = R"(
+        offset = 100
+        collatz = function(n)
+            steps = 0
+            while n != 1
+                if n % 2 == 0 then
+                    n = n / 2
+                else
+                    n = 3 * n + 1
+                end if
+                steps += 1
+            end while
+            return [steps + offset, to_string(steps)]
+        end function
+
+        xs = []
+        for i in range(1, 301)
+            push(xs, i)
+        end for
+
+        ys = pmap(collatz, xs, 4)
+        println(len(ys), " ", ys[0], " ", ys[26], " ", ys[-1])
+        println(pmap(collatz, [27], 16), " ", pmap(collatz, []))
+    )";
+
+    std::string expected = "300 [100, \"0\"] [211, \"111\"] [116, \"16\"]\n[[211, \"111\"]] []\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, PmapGlobalsTest) {
+    std::string code = R"(
+        fib = function(n)
+            if n < 2 then
+                return n
+            end if
+            return fib(n - 1) + fib(n - 2)
+        end function
+        fib = memoize(fib)
+
+        p = to_string
+        g = function(x)
+            return p(fib(x))
+        end function
+        println(pmap(g, [1, 2, 3, 10, 70], 2), " ", g(10))
+    )";
+
+    std::string expected = "[\"1\", \"1\", \"2\", \"55\", \"190392490709135\"] 55\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, PmapFailureTest) {
+    std::vector<std::string> codes = {
+        "f = function(x) return 10 / x end function\npmap(f, [1, 2, 0, 4])",
+        "pmap(print, [1, 2])",
+        "f = function(x) return x end function\npmap(f, [len])",
+        "f = function(x) return x end function\npmap(f, [1], 0)",
+    };
+
+    for (const auto& code : codes) {
+        std::istringstream input(code);
+        std::ostringstream output;
+
+        ASSERT_FALSE(interpret(input, output)) << code;
+    }
+}
+
+
+TEST(StdlibTestSuite, FileTest) {
+    std::string path = (std::filesystem::temp_directory_path() / "itmoscript_file_test.txt").string();
+
+    std::string code = R"(
+        path = ")" + path + R"("
+        f = open(path, "w")
+        for i in range(1, 6)
+            write(f, "line ", i, "\n")
+        end for
+        write(f, "last")
+        close(f)
+
+        println(len(read_all(path)))
+
+        f = open(path)
+        println(read_line(f))
+        chunks = 0
+        total = 0
+        while true
+            chunk = read_lines(f, 2)
+            if len(chunk) == 0 then
+                break
+            end if
+            chunks += 1
+            total += len(chunk)
+        end while
+        println(chunks, " ", total, " ", read_line(f))
+        close(f)
+
+        count = 0
+        for line in open(path)
+            count += len(line)
+        end for
+        println(count)
+
+        write_file(path, "a\n\nb")
+        println(read_lines(open(path)))
+    )";
+
+    std::string expected = "39\nline 1\n3 5 nil\n34\n[\"a\", \"\", \"b\"]\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+
+    std::filesystem::remove(path);
+}
+
+
+TEST(StdlibTestSuite, FilePipeTest) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    // больше одного куска чтения, строки рвутся на границах кусков
+    std::thread writer([fd = fds[1]] {
+        std::string data;
+        for (int i = 0; i < 20000; ++i) {
+            data += "line " + std::to_string(i) + "\n";
+        }
+        data += "tail";
+        for (size_t done = 0; done < data.size(); ) {
+            ssize_t n = write(fd, data.data() + done, data.size() - done);
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        close(fd);
+    });
+
+    std::string code = R"(
+        f = open("/dev/fd/)" + std::to_string(fds[0]) + R"(")
+        println(read_line(f))
+        rest = read_lines(f, 100000)
+        println(len(rest), " ", rest[9998], " ", rest[-1])
+        println(read_line(f), " ", len(read_all(f)))
+    )";
+
+    std::string expected = "line 0\n20000 line 9999 tail\nnil 0\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    bool ok = interpret(input, output);
+    writer.join();
+    close(fds[0]);
+
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(output.str(), expected);
+}
+
+
+TEST(StdlibTestSuite, FileFailureTest) {
+    std::vector<std::string> codes = {
+        "open(\"/nonexistent/itmoscript/file\")",
+        "open(\"/tmp\", \"x\")",
+        "f = open(\"/nonexistent/itmoscript/file\", \"w\")",
+        "read_line(42)",
+        "read_lines(open(\"/dev/null\", \"w\"))",
+        "f = open(\"/dev/null\", \"w\")\nclose(f)\nwrite(f, 1)",
+        "f = open(\"/dev/full\", \"w\")\nwrite(f, \"x\")\nclose(f)",
+    };
+
+    for (const auto& code : codes) {
+        std::istringstream input(code);
+        std::ostringstream output;
+
+        ASSERT_FALSE(interpret(input, output)) << code;
+    }
+}
+
+
+TEST(StdlibTestSuite, MemstatsTest) {
+    std::string code = R"(
+        before = memstats()
+        xs = []
+        for i in range(0, 1000)
+            push(xs, "a long enough string number " + to_string(i))
+        end for
+        after = memstats()
+
+        println(len(after), " ", len(after[2]))
+        for row in after[2]
+            print(row[0], " ")
+        end for
+        println()
+
+        println(after[0] - before[0] > 1000 * 28)
+        println(after[1] >= after[0])
+        println(after[2][0][1] - before[2][0][1] >= 1000)
+        println(after[2][1][2] > before[2][1][2])
+    )";
+
+    std::string expected = "3 4\nstring list function array \ntrue\ntrue\ntrue\ntrue\n";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
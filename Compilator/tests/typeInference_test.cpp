@@ -0,0 +1,118 @@
+#include <../lib/interpreter/interpreter.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+std::unique_ptr<ProgramNode> annotate(const std::string& code) {
+    Lexer lexer(code);
+    Parser parser(lexer);
+    std::unique_ptr<ProgramNode> program = parser.parseProgram();
+    TypeInference().run(program.get());
+    return program;
+}
+
+ExpressionNode* expressionAt(const std::unique_ptr<ProgramNode>& program, size_t i) {
+    auto stmt = dynamic_cast<ExpressionStatementNode*>(program->statements.at(i).get());
+    return stmt ? stmt->expression.get() : nullptr;
+}
+
+ExpressionNode* rvalueAt(const std::unique_ptr<ProgramNode>& program, size_t i) {
+    auto assign = dynamic_cast<AssignmentNode*>(expressionAt(program, i));
+    return assign ? assign->expression_r.get() : nullptr;
+}
+
+} // namespace
+
+
+TEST(TypeInferenceTestSuite, StraightLineTest) {
+    auto program = annotate(R"(
+        x = 1
+        s = "a"
+        y = x * 2 + 1
+        t = s + "b"
+        u = x + s
+        b = x < y
+    )");
+
+    ASSERT_EQ(rvalueAt(program, 2)->static_type, ValueType::kDouble);
+    ASSERT_TRUE(dynamic_cast<BinaryOpNode*>(rvalueAt(program, 2))->numeric_operands);
+    ASSERT_EQ(rvalueAt(program, 3)->static_type, ValueType::kString);
+    ASSERT_EQ(rvalueAt(program, 4)->static_type, std::nullopt);
+    ASSERT_EQ(rvalueAt(program, 5)->static_type, ValueType::kBool);
+}
+
+
+TEST(TypeInferenceTestSuite, ControlFlowTest) {
+    auto program = annotate(R"(
+        x = 1
+        if read() == "" then
+            x = "s"
+        end if
+        y = x + 1
+        i = 0
+        while i < 10
+            i += 1
+        end while
+        z = i + 1
+        for k in range(3)
+            w = k * 2
+        end for
+    )");
+
+    ASSERT_EQ(rvalueAt(program, 2)->static_type, std::nullopt);
+
+    auto loop = dynamic_cast<WhileStatementNode*>(program->statements.at(4).get());
+    ASSERT_TRUE(dynamic_cast<BinaryOpNode*>(loop->condition.get())->numeric_operands);
+    ASSERT_EQ(rvalueAt(program, 5)->static_type, ValueType::kDouble);
+
+    auto for_loop = dynamic_cast<ForStatementNode*>(program->statements.at(6).get());
+    auto body = dynamic_cast<ExpressionStatementNode*>(for_loop->body->statements.at(0).get());
+    auto assign = dynamic_cast<AssignmentNode*>(body->expression.get());
+    ASSERT_TRUE(dynamic_cast<BinaryOpNode*>(assign->expression_r.get())->numeric_operands);
+}
+
+
+TEST(TypeInferenceTestSuite, CallsForgetFactsTest) {
+    auto program = annotate(R"(
+        x = 1
+        f = function()
+            x = "s"
+        end function
+        f()
+        y = x + 1
+        len = function(v) return v end function
+        z = len(1) + 1
+        n = 1
+        m = n + 1
+    )");
+
+    ASSERT_EQ(rvalueAt(program, 3)->static_type, std::nullopt);
+    ASSERT_EQ(rvalueAt(program, 5)->static_type, std::nullopt);
+    ASSERT_EQ(rvalueAt(program, 7)->static_type, ValueType::kDouble);
+}
+
+
+TEST(TypeInferenceTestSuite, DynamicFallbackTest) {
+    std::string code = R"(
+        x = 1
+        f = function()
+            x = "s"
+        end function
+        i = 0
+        while i < 3
+            if i == 1 then
+                f()
+            end if
+            i += 1
+        end while
+        print(x + "!", " ", i)
+    )";
+
+    std::string expected = "s! 3";
+
+    std::istringstream input(code);
+    std::ostringstream output;
+
+    ASSERT_TRUE(interpret(input, output));
+    ASSERT_EQ(output.str(), expected);
+}
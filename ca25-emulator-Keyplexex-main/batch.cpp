@@ -0,0 +1,246 @@
+// batch.cpp — прогон многих образов (манифест или каталог) на пуле потоков.
+// У каждого образа свои CPU, Memory и кэши, общего состояния между потоками нет;
+// статистика по образам — в CSV или JSON.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "cache.hpp"
+#include "cpu.hpp"
+#include "io.hpp"
+#include "memory.hpp"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Args {
+    std::vector<std::string> inputs;
+    unsigned jobs = 0;          // 0 — по числу ядер
+    bool json = false;          // --json: вместо CSV
+    std::string out_path;       // -o <file>, по умолчанию stdout
+    bool paged = false;         // --paged, как у riscv-sim
+    bool no_stats = false;      // --no-stats: без моделей кэша
+};
+
+struct Result {
+    const char* status = "error"; // halted / failed / step_limit / error
+    std::string error;            // почему образ не запустился
+    uint64_t steps = 0;
+    double seconds = 0;
+    CacheStats lru, bplru;
+};
+
+// строки манифеста — пути к образам (относительно каталога манифеста); пустые и "#..." пропускаются
+bool read_manifest(const std::string& path, std::vector<std::string>& out, std::string& err) {
+    std::ifstream in(path);
+    if (!in) { err = "cannot open " + path; return false; }
+    const fs::path dir = fs::path(path).parent_path();
+    for (std::string line; std::getline(in, line); ) {
+        const auto b = line.find_first_not_of(" \t\r");
+        if (b == std::string::npos || line[b] == '#') continue;
+        line = line.substr(b, line.find_last_not_of(" \t\r") + 1 - b);
+        const fs::path p(line);
+        out.push_back((p.is_absolute() ? p : dir / p).string());
+    }
+    return true;
+}
+
+// все обычные файлы каталога, по имени
+bool read_directory(const std::string& path, std::vector<std::string>& out, std::string& err) {
+    std::error_code ec;
+    std::vector<std::string> files;
+    for (const auto& e : fs::directory_iterator(path, ec)) {
+        if (e.is_regular_file()) files.push_back(e.path().string());
+    }
+    if (ec) { err = "cannot read directory " + path + ": " + ec.message(); return false; }
+    std::sort(files.begin(), files.end());
+    out.insert(out.end(), files.begin(), files.end());
+    return true;
+}
+
+bool parse_args(int argc, char** argv, Args& a, std::string& err) {
+    for (int i = 1; i < argc; ++i) {
+        std::string s = argv[i];
+        if (s == "-m" || s == "-d") {
+            if (i + 1 >= argc) { err = "missing argument after " + s; return false; }
+            if (!(s == "-m" ? read_manifest : read_directory)(argv[++i], a.inputs, err)) return false;
+        } else if (s == "-j") {
+            if (i + 1 >= argc) { err = "missing argument after -j"; return false; }
+            a.jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        } else if (s == "-o") {
+            if (i + 1 >= argc) { err = "missing argument after -o"; return false; }
+            a.out_path = argv[++i];
+        } else if (s == "--json") {
+            a.json = true;
+        } else if (s == "--csv") {
+            a.json = false;
+        } else if (s == "--paged") {
+            a.paged = true;
+        } else if (s == "--no-stats") {
+            a.no_stats = true;
+        } else {
+            err = "unknown argument: " + s;
+            return false;
+        }
+    }
+    if (a.inputs.empty()) { err = "no input images (-m <manifest> or -d <directory>)"; return false; }
+    return true;
+}
+
+// один образ, как riscv-sim -i
+Result run_image(const std::string& path, const Args& args) {
+    Result res;
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::string err;
+    auto img = read_input_file(path, err);
+    if (!img) { res.error = err; return res; }
+
+    Memory mem(args.paged ? Memory::Layout::Paged : Memory::Layout::Flat);
+    for (auto& f : img->frags) {
+        if (static_cast<uint64_t>(f.addr) + f.data.size() > mem.size()) { res.error = "fragment out of memory bounds"; return res; }
+        mem.load_frag(f.addr, f.data);
+    }
+
+    CPU cpu;
+    uint32_t start_ra = 0;
+    cpu.reset_from_regs(img->regs, start_ra);
+
+    LRUCache lru;
+    BpLRUCache bplru;
+    const ExecResult r = args.no_stats ? cpu.run(mem, start_ra)
+                                       : cpu.run(mem, lru, bplru, /*enable_bplru=*/true, start_ra);
+
+    res.status = r.ok ? "halted" : r.step_limit ? "step_limit" : "failed";
+    res.steps = r.steps;
+    res.lru = lru.stats();
+    res.bplru = bplru.stats();
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return res;
+}
+
+double rate(uint64_t hits, uint64_t misses) {
+    return hits + misses ? 100.0 * static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+}
+
+// Поле CSV: в кавычках, если есть разделитель или кавычка
+std::string csv_field(const std::string& s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) return s;
+    std::string q = "\"";
+    for (char c : s) { if (c == '"') q += '"'; q += c; }
+    return q + '"';
+}
+
+std::string json_string(const std::string& s) {
+    std::string q = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') { q += '\\'; q += static_cast<char>(c); }
+        else if (c < 0x20) { char buf[8]; std::snprintf(buf, sizeof buf, "\\u%04x", c); q += buf; }
+        else q += static_cast<char>(c);
+    }
+    return q + '"';
+}
+
+// hit rate без обращений — пустое поле (CSV) / null (JSON)
+void print_rate(std::FILE* f, uint64_t hits, uint64_t misses, bool json) {
+    if (hits + misses == 0) { if (json) std::fputs("null", f); }
+    else std::fprintf(f, "%.5f", rate(hits, misses));
+}
+
+void write_csv(std::FILE* f, const std::vector<std::string>& inputs, const std::vector<Result>& results) {
+    std::fprintf(f, "image,status,error,instructions,seconds");
+    for (const char* p : {"lru", "bplru"})
+        std::fprintf(f, ",%s_hits,%s_misses,%s_hit_rate,%s_hit_rate_inst,%s_hit_rate_data", p, p, p, p, p);
+    std::fprintf(f, "\n");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(f, "%s,%s,%s,%llu,%.6f", csv_field(inputs[i]).c_str(), r.status, csv_field(r.error).c_str(),
+                     static_cast<unsigned long long>(r.steps), r.seconds);
+        for (const CacheStats* st : {&r.lru, &r.bplru}) {
+            std::fprintf(f, ",%llu,%llu,", static_cast<unsigned long long>(st->hits_total),
+                         static_cast<unsigned long long>(st->misses_total));
+            print_rate(f, st->hits_total, st->misses_total, false); std::fprintf(f, ",");
+            print_rate(f, st->hits_inst , st->misses_inst , false); std::fprintf(f, ",");
+            print_rate(f, st->hits_data , st->misses_data , false);
+        }
+        std::fprintf(f, "\n");
+    }
+}
+
+void write_json(std::FILE* f, const std::vector<std::string>& inputs, const std::vector<Result>& results) {
+    std::fprintf(f, "[\n");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(f, "  {\"image\": %s, \"status\": \"%s\"", json_string(inputs[i]).c_str(), r.status);
+        if (!r.error.empty()) std::fprintf(f, ", \"error\": %s", json_string(r.error).c_str());
+        std::fprintf(f, ", \"instructions\": %llu, \"seconds\": %.6f",
+                     static_cast<unsigned long long>(r.steps), r.seconds);
+        const char* names[] = {"lru", "bplru"};
+        const CacheStats* stats[] = {&r.lru, &r.bplru};
+        for (int p = 0; p < 2; ++p) {
+            const CacheStats& st = *stats[p];
+            std::fprintf(f, ", \"%s\": {\"hits\": %llu, \"misses\": %llu, \"hit_rate\": ", names[p],
+                         static_cast<unsigned long long>(st.hits_total), static_cast<unsigned long long>(st.misses_total));
+            print_rate(f, st.hits_total, st.misses_total, true); std::fprintf(f, ", \"hit_rate_inst\": ");
+            print_rate(f, st.hits_inst , st.misses_inst , true); std::fprintf(f, ", \"hit_rate_data\": ");
+            print_rate(f, st.hits_data , st.misses_data , true); std::fprintf(f, "}");
+        }
+        std::fprintf(f, i + 1 < results.size() ? "},\n" : "}\n");
+    }
+    std::fprintf(f, "]\n");
+}
+
+}
+
+int main(int argc, char** argv) {
+    Args args;
+    std::string err;
+    if (!parse_args(argc, argv, args, err)) { std::fprintf(stderr, "Error parsing arguments: %s\n", err.c_str()); return 1; }
+
+    unsigned jobs = args.jobs ? args.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<std::size_t>(jobs, args.inputs.size()));
+
+    // образы раздаются по одному: длинные прогоны не задерживают остальные потоки
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<Result> results(args.inputs.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t i; (i = next.fetch_add(1)) < args.inputs.size(); )
+            results[i] = run_image(args.inputs[i], args);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < jobs; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::FILE* out = stdout;
+    if (!args.out_path.empty() && !(out = std::fopen(args.out_path.c_str(), "w"))) {
+        std::fprintf(stderr, "Error writing results: cannot open %s\n", args.out_path.c_str()); return 6;
+    }
+    if (args.json) write_json(out, args.inputs, results);
+    else write_csv(out, args.inputs, results);
+    if (out != stdout && std::fclose(out) != 0) {
+        std::fprintf(stderr, "Error writing results: error writing %s\n", args.out_path.c_str()); return 6;
+    }
+
+    std::size_t bad = 0;
+    uint64_t insns = 0;
+    double cpu_seconds = 0;
+    for (const auto& r : results) {
+        if (r.status != std::string_view("halted")) ++bad;
+        insns += r.steps;
+        cpu_seconds += r.seconds;
+    }
+    std::fprintf(stderr, "%zu images (%zu not halted), %llu instructions, %.3f s wall, %.3f s total on %u threads\n",
+                 results.size(), bad, static_cast<unsigned long long>(insns), wall, cpu_seconds, jobs);
+    return bad ? 4 : 0;
+}
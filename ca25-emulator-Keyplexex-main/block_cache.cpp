@@ -0,0 +1,102 @@
+#include "block_cache.hpp"
+#include <algorithm>
+
+BlockCache::BlockCache()
+    : fast_(FAST_SIZE, nullptr),
+      code_pages_((std::size_t{1} << (32 - PAGE_SHIFT)) / 64, 0) {}
+
+void BlockCache::set_handlers(const void* const* handlers) {
+    if (handlers == handlers_) return;
+    handlers_ = handlers;
+    for (auto& [pc, b] : blocks_) {
+        for (auto& d : b->insns) d.handler = handlers_ ? handlers_[static_cast<std::size_t>(d.op)] : nullptr;
+    }
+}
+
+void BlockCache::reset(uint32_t stop_pc) {
+    stop_pc_ = stop_pc;
+    ++generation_;
+    blocks_.clear();
+    page_blocks_.clear();
+    std::fill(fast_.begin(), fast_.end(), nullptr);
+    std::fill(code_pages_.begin(), code_pages_.end(), 0);
+}
+
+const Block* BlockCache::lookup(uint32_t pc, const Memory& mem) {
+    auto it = blocks_.find(pc);
+    if (it == blocks_.end()) {
+        auto b = build(pc, mem);
+        if (!b) return nullptr;
+
+        // регистрируем блок во всех страницах, которые он занимает
+        const uint32_t first = b->start_pc >> PAGE_SHIFT;
+        const uint32_t last  = (b->end_pc - 1) >> PAGE_SHIFT;
+        for (uint32_t page = first; ; ++page) {
+            code_pages_[page >> 6] |= uint64_t{1} << (page & 63);
+            page_blocks_[page].push_back(pc);
+            if (page == last) break;
+        }
+        it = blocks_.emplace(pc, std::move(b)).first;
+    }
+    fast_[fast_index(pc)] = it->second.get();
+    return it->second.get();
+}
+
+std::unique_ptr<Block> BlockCache::build(uint32_t pc, const Memory& mem) const {
+    auto b = std::make_unique<Block>();
+    b->start_pc = pc;
+
+    // код блока читаем прямо из памяти хоста; на границе страницы/памяти — через read_u32
+    const auto code = mem.host_span(pc, MAX_BLOCK_LEN * 4);
+
+    uint32_t cur = pc;
+    while (b->insns.size() < MAX_BLOCK_LEN) {
+        uint32_t instr;
+        const std::size_t off = cur - pc;
+        if (off + 4 <= code.size()) instr = load_le<uint32_t>(code.data() + off);
+        else if (!mem.read_u32(cur, instr)) break; // дальше читать нельзя — упадём при исполнении
+
+        DecodedInsn d = decode(instr, cur);
+        if (handlers_) d.handler = handlers_[static_cast<std::size_t>(d.op)];
+        b->insns.push_back(d);
+        cur += 4;
+
+        // после перехода или если следующий pc — адрес останова
+        if (ends_block(d.op) || cur == stop_pc_) break;
+    }
+    if (b->insns.empty()) return nullptr;
+
+    b->end_pc = cur;
+
+    DecodedInsn end;
+    end.pc = cur;
+    end.op = Op::BLOCK_END;
+    if (handlers_) end.handler = handlers_[static_cast<std::size_t>(Op::BLOCK_END)];
+    b->insns.push_back(end);
+
+    return b;
+}
+
+void BlockCache::invalidate(uint32_t addr, std::size_t size) {
+    const uint32_t first = addr >> PAGE_SHIFT;
+    const uint32_t last  = static_cast<uint32_t>(addr + size - 1) >> PAGE_SHIFT;
+    if (page_bit(first)) invalidate_page(first);
+    if (last != first && page_bit(last)) invalidate_page(last);
+}
+
+void BlockCache::invalidate_page(uint32_t page) {
+    ++generation_;
+    auto it = page_blocks_.find(page);
+    if (it != page_blocks_.end()) {
+        for (uint32_t start : it->second) {
+            auto b = blocks_.find(start);
+            if (b == blocks_.end()) continue; // уже выброшен через соседнюю страницу
+
+            const std::size_t fi = fast_index(start);
+            if (fast_[fi] == b->second.get()) fast_[fi] = nullptr;
+            blocks_.erase(b);
+        }
+        page_blocks_.erase(it);
+    }
+    code_pages_[page >> 6] &= ~(uint64_t{1} << (page & 63));
+}
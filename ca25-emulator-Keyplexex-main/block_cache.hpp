@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "decode.hpp"
+#include "memory.hpp"
+
+// Линейный участок кода, декодированный один раз.
+// insns заканчивается служебной инструкцией BLOCK_END с pc = end_pc.
+struct Block {
+    uint32_t start_pc = 0;
+    uint32_t end_pc   = 0;   // адрес сразу после последней инструкции
+    std::vector<DecodedInsn> insns;
+
+    std::size_t size() const { return insns.size() - 1; }
+};
+
+// Кэш декодированных блоков по pc.
+// Блок заканчивается на переходе, ecall/ebreak, нелегальной инструкции,
+// адресе останова (stop_pc — ra на старте) или через MAX_BLOCK_LEN инструкций.
+// Запись в страницу, где лежит декодированный код, выбрасывает блоки этой страницы.
+class BlockCache {
+public:
+    static constexpr std::size_t MAX_BLOCK_LEN = 64;
+    static constexpr unsigned    PAGE_SHIFT    = 12;
+
+    BlockCache();
+
+    // Таблица меток Op -> обработчик (nullptr — диспетчеризация через switch).
+    // У каждой инстанциации CPU::run_impl своя таблица, уже собранные блоки перенастраиваются.
+    void set_handlers(const void* const* handlers);
+
+    // Сбросить всё; stop_pc влияет на границы блоков
+    void reset(uint32_t stop_pc);
+    uint32_t stop_pc() const { return stop_pc_; }
+
+    // nullptr, если инструкцию по pc нельзя прочитать
+    const Block* get(uint32_t pc, const Memory& mem) {
+        const Block* b = fast_[fast_index(pc)];
+        if (b && b->start_pc == pc) return b;
+        return lookup(pc, mem);
+    }
+
+    // Есть ли декодированный код в [addr, addr+size)
+    bool is_code(uint32_t addr, std::size_t size) const {
+        return page_bit(addr >> PAGE_SHIFT)
+            || page_bit(static_cast<uint32_t>(addr + size - 1) >> PAGE_SHIFT);
+    }
+
+    // Выбросить блоки страниц, задетых записью в [addr, addr+size)
+    void invalidate(uint32_t addr, std::size_t size);
+
+    // Растёт при каждом выбрасывании страницы: по нему транслятор (dbt.hpp) узнаёт,
+    // что код, с которого он делал машинный код, изменился
+    uint64_t generation() const { return generation_; }
+    // Битовая карта страниц с кодом, бит на страницу (для проверки записи из машинного кода)
+    const uint64_t* code_page_bits() const { return code_pages_.data(); }
+
+private:
+    static constexpr std::size_t FAST_SIZE = 4096;
+
+    static std::size_t fast_index(uint32_t pc) { return (pc >> 2) & (FAST_SIZE - 1); }
+
+    bool page_bit(uint32_t page) const { return (code_pages_[page >> 6] >> (page & 63)) & 1u; }
+
+    const Block* lookup(uint32_t pc, const Memory& mem);
+    std::unique_ptr<Block> build(uint32_t pc, const Memory& mem) const;
+    void invalidate_page(uint32_t page);
+
+    const void* const* handlers_ = nullptr;
+    uint32_t stop_pc_ = 0;
+    uint64_t generation_ = 0;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Block>> blocks_;
+    std::vector<const Block*> fast_;                               // прямое отображение pc -> блок
+    std::vector<uint64_t> code_pages_;                             // битовая карта страниц с кодом (все 4 ГиБ)
+    std::unordered_map<uint32_t, std::vector<uint32_t>> page_blocks_; // страница -> start_pc блоков
+};
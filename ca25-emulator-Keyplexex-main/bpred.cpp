@@ -0,0 +1,292 @@
+#include "bpred.hpp"
+#include <array>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+// 2-битный насыщающийся счётчик: 0,1 — не перейдёт, 2,3 — перейдёт
+void bump(uint8_t& c, bool taken, uint8_t max = 3) {
+    if (taken) { if (c < max) ++c; }
+    else       { if (c > 0) --c; }
+}
+
+uint32_t pc_index(uint32_t pc) { return pc >> 2; }
+
+class StaticPredictor : public DirectionPredictor {
+public:
+    bool predict(uint32_t pc, uint32_t target) override { return target <= pc; }
+    void update(uint32_t, bool) override {}
+    std::string name() const override { return "static"; }
+};
+
+class BimodalPredictor : public DirectionPredictor {
+public:
+    explicit BimodalPredictor(unsigned bits) : bits_(bits), table_(std::size_t{1} << bits, 1) {}
+
+    bool predict(uint32_t pc, uint32_t) override { return table_[index(pc)] >= 2; }
+    void update(uint32_t pc, bool taken) override { bump(table_[index(pc)], taken); }
+    std::string name() const override { return "bimodal:" + std::to_string(bits_); }
+
+private:
+    std::size_t index(uint32_t pc) const { return pc_index(pc) & (table_.size() - 1); }
+
+    unsigned bits_;
+    std::vector<uint8_t> table_;
+};
+
+class GsharePredictor : public DirectionPredictor {
+public:
+    explicit GsharePredictor(unsigned bits) : bits_(bits), table_(std::size_t{1} << bits, 1) {}
+
+    bool predict(uint32_t pc, uint32_t) override { return table_[index(pc)] >= 2; }
+    void update(uint32_t pc, bool taken) override {
+        bump(table_[index(pc)], taken);
+        history_ = (history_ << 1) | (taken ? 1u : 0u);
+    }
+    std::string name() const override { return "gshare:" + std::to_string(bits_); }
+
+private:
+    std::size_t index(uint32_t pc) const { return (pc_index(pc) ^ history_) & (table_.size() - 1); }
+
+    unsigned bits_;
+    std::vector<uint8_t> table_;
+    uint32_t history_ = 0;
+};
+
+// Упрощённый TAGE: базовый bimodal и TABLES таблиц с тегами, индексируемых pc и
+// всё более длинной глобальной историей. Предсказывает самая длинная совпавшая
+// таблица; при ошибке заводится запись в более длинной таблице.
+class TagePredictor : public DirectionPredictor {
+public:
+    explicit TagePredictor(unsigned bits)
+        : bits_(bits), tagged_bits_(bits > 2 ? bits - 2 : 1), base_(std::size_t{1} << bits, 1) {
+        for (auto& t : tables_) t.assign(std::size_t{1} << tagged_bits_, Entry{});
+    }
+
+    bool predict(uint32_t pc, uint32_t) override {
+        provider_ = alt_ = -1;
+        for (int t = TABLES - 1; t >= 0; --t) {
+            idx_[t] = index(pc, t);
+            tag_[t] = tag(pc, t);
+        }
+        for (int t = TABLES - 1; t >= 0; --t) {
+            if (tables_[t][idx_[t]].tag != tag_[t]) continue;
+            if (provider_ < 0) provider_ = t;
+            else { alt_ = t; break; }
+        }
+        alt_pred_ = alt_ >= 0 ? tables_[alt_][idx_[alt_]].ctr >= 4 : base_[base_index(pc)] >= 2;
+        pred_ = provider_ >= 0 ? tables_[provider_][idx_[provider_]].ctr >= 4 : alt_pred_;
+        return pred_;
+    }
+
+    void update(uint32_t pc, bool taken) override {
+        if (provider_ >= 0) {
+            Entry& e = tables_[provider_][idx_[provider_]];
+            if (pred_ != alt_pred_) {
+                if (pred_ == taken) { if (e.useful < 3) ++e.useful; }
+                else if (e.useful > 0) --e.useful;
+            }
+            bump(e.ctr, taken, 7);
+        } else {
+            bump(base_[base_index(pc)], taken);
+        }
+
+        // ошибка — пробуем завести запись в более длинной таблице
+        if (pred_ != taken && provider_ < TABLES - 1) {
+            bool allocated = false;
+            for (int t = provider_ + 1; t < TABLES; ++t) {
+                Entry& e = tables_[t][idx_[t]];
+                if (e.useful == 0) {
+                    e.tag = tag_[t];
+                    e.ctr = taken ? 4 : 3;
+                    allocated = true;
+                    break;
+                }
+            }
+            if (!allocated) {
+                for (int t = provider_ + 1; t < TABLES; ++t) {
+                    Entry& e = tables_[t][idx_[t]];
+                    if (e.useful > 0) --e.useful;
+                }
+            }
+        }
+
+        // периодически забываем полезность, чтобы таблицы не застывали
+        if ((++updates_ & ((uint64_t{1} << 18) - 1)) == 0) {
+            for (auto& tbl : tables_) for (auto& e : tbl) e.useful >>= 1;
+        }
+
+        history_ = (history_ << 1) | (taken ? 1u : 0u);
+    }
+
+    std::string name() const override { return "tage:" + std::to_string(bits_); }
+
+private:
+    static constexpr int TABLES = 4;
+    static constexpr std::array<unsigned, TABLES> HIST = {4, 9, 20, 44};
+    static constexpr unsigned TAG_BITS = 9;
+
+    struct Entry {
+        uint16_t tag = 0xFFFF;  // не совпадает ни с одним 9-битным тегом
+        uint8_t  ctr = 4;       // 3-битный счётчик, >= 4 — перейдёт
+        uint8_t  useful = 0;
+    };
+
+    // последние len бит истории, свёрнутые xor-ом до bits бит
+    uint32_t fold(unsigned len, unsigned bits) const {
+        uint64_t h = len >= 64 ? history_ : history_ & ((uint64_t{1} << len) - 1);
+        uint32_t r = 0;
+        for (; h; h >>= bits) r ^= static_cast<uint32_t>(h & ((uint64_t{1} << bits) - 1));
+        return r;
+    }
+
+    std::size_t base_index(uint32_t pc) const { return pc_index(pc) & (base_.size() - 1); }
+    uint32_t index(uint32_t pc, int t) const {
+        const uint32_t p = pc_index(pc);
+        return (p ^ (p >> tagged_bits_) ^ fold(HIST[t], tagged_bits_)) & ((1u << tagged_bits_) - 1);
+    }
+    uint16_t tag(uint32_t pc, int t) const {
+        const uint32_t p = pc_index(pc);
+        return static_cast<uint16_t>((p ^ fold(HIST[t], TAG_BITS) ^ (fold(HIST[t], TAG_BITS - 1) << 1))
+                                     & ((1u << TAG_BITS) - 1));
+    }
+
+    unsigned bits_, tagged_bits_;
+    std::vector<uint8_t> base_;
+    std::array<std::vector<Entry>, TABLES> tables_;
+    uint64_t history_ = 0;
+    uint64_t updates_ = 0;
+
+    // состояние между predict и update
+    uint32_t idx_[TABLES] = {};
+    uint16_t tag_[TABLES] = {};
+    int provider_ = -1, alt_ = -1;
+    bool pred_ = false, alt_pred_ = false;
+};
+
+bool is_link(uint8_t r) { return r == 1 || r == 5; } // ra или t0 по соглашению RISC-V
+
+bool is_pow2(std::size_t v) { return v && !(v & (v - 1)); }
+
+}
+
+bool make_predictor(const std::string& spec, std::unique_ptr<DirectionPredictor>& out, std::string& err) {
+    const auto colon = spec.find(':');
+    const std::string name = spec.substr(0, colon);
+
+    unsigned bits = name == "bimodal" ? 12 : name == "gshare" ? 14 : 10;
+    if (colon != std::string::npos) {
+        char* end = nullptr;
+        const char* s = spec.c_str() + colon + 1;
+        unsigned long v = std::strtoul(s, &end, 0);
+        if (end == s || *end != '\0' || v < 4 || v > 24) { err = "invalid predictor size: " + spec; return false; }
+        bits = static_cast<unsigned>(v);
+    }
+
+    if (name == "static" && colon == std::string::npos) out = std::make_unique<StaticPredictor>();
+    else if (name == "bimodal") out = std::make_unique<BimodalPredictor>(bits);
+    else if (name == "gshare")  out = std::make_unique<GsharePredictor>(bits);
+    else if (name == "tage")    out = std::make_unique<TagePredictor>(bits);
+    else { err = "unknown predictor: " + spec; return false; }
+    return true;
+}
+
+BranchUnit::BranchUnit(const Config& c, std::vector<std::unique_ptr<DirectionPredictor>> predictors)
+    : cfg_(c), btb_(is_pow2(c.btb_entries) ? c.btb_entries : 512), ras_(c.ras_depth ? c.ras_depth : 1) {
+    for (auto& p : predictors) predictors_.push_back({std::move(p), 0});
+}
+
+bool BranchUnit::btb_lookup(uint32_t pc, uint32_t& target) const {
+    const BtbEntry& e = btb_[pc_index(pc) & (btb_.size() - 1)];
+    if (!e.valid || e.pc != pc) return false;
+    target = e.target;
+    return true;
+}
+
+void BranchUnit::btb_update(uint32_t pc, uint32_t target) {
+    BtbEntry& e = btb_[pc_index(pc) & (btb_.size() - 1)];
+    e.valid = true;
+    e.pc = pc;
+    e.target = target;
+}
+
+void BranchUnit::retire(const DecodedInsn& d, uint32_t next_pc) {
+    ++instret_;
+
+    switch (d.op) {
+        case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGE: case Op::BLTU: case Op::BGEU: {
+            const bool taken = next_pc != d.pc + 4;
+            ++cond_;
+            ++btb_lookups_;
+            uint32_t t = 0;
+            const bool hit = btb_lookup(d.pc, t);
+            if (hit) ++btb_hits_;
+            // «перейдёт» без цели в BTB на стадии выборки — тоже ошибка
+            const bool target_known = hit && t == d.imm;
+            for (auto& s : predictors_) {
+                const bool pred = s.p->predict(d.pc, d.imm);
+                if (pred != taken || (taken && !target_known)) ++s.cond_miss;
+                s.p->update(d.pc, taken);
+            }
+            if (taken) btb_update(d.pc, d.imm);
+            break;
+        }
+        case Op::JAL:
+        case Op::JALR: {
+            const bool is_return = d.op == Op::JALR && d.rd == 0 && is_link(d.rs1);
+            if (is_return) {
+                ++returns_;
+                if (ras_size_ == 0) { ++return_miss_; break; }
+                ras_top_ = (ras_top_ + ras_.size() - 1) % ras_.size();
+                --ras_size_;
+                if (ras_[ras_top_] != next_pc) ++return_miss_;
+                break;
+            }
+
+            ++jumps_;
+            ++btb_lookups_;
+            uint32_t t = 0;
+            const bool hit = btb_lookup(d.pc, t);
+            if (hit) ++btb_hits_;
+            if (!hit || t != next_pc) ++jump_miss_;
+            btb_update(d.pc, next_pc);
+
+            if (is_link(d.rd)) { // вызов
+                ras_[ras_top_] = d.pc + 4;
+                ras_top_ = (ras_top_ + 1) % ras_.size();
+                if (ras_size_ < ras_.size()) ++ras_size_;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void BranchUnit::report(std::FILE* out) const {
+    auto rate = [&](uint64_t ok, uint64_t total) {
+        if (total == 0) std::fprintf(out, "nan%%");
+        else std::fprintf(out, "%3.5f%%", 100.0 * ok / total);
+    };
+    auto mpki = [&](uint64_t miss) {
+        return instret_ ? 1000.0 * miss / instret_ : std::numeric_limits<double>::quiet_NaN();
+    };
+
+    std::fprintf(out, "\nbranch prediction (BTB %zu entries, RAS %zu)\n", btb_.size(), ras_.size());
+    std::fprintf(out, "predictor\taccuracy\tmispredicts\tMPKI\n");
+    for (const auto& s : predictors_) {
+        const uint64_t miss = s.cond_miss + jump_miss_ + return_miss_;
+        std::fprintf(out, "%s\t", s.p->name().c_str());
+        rate(cond_ - s.cond_miss, cond_);
+        std::fprintf(out, "\t%llu\t%.4f\n", static_cast<unsigned long long>(miss), mpki(miss));
+    }
+
+    std::fprintf(out, "conditional branches\t%llu\n", static_cast<unsigned long long>(cond_));
+    std::fprintf(out, "jumps (BTB)\t"); rate(jumps_ - jump_miss_, jumps_);
+    std::fprintf(out, "\t%llu\n", static_cast<unsigned long long>(jumps_));
+    std::fprintf(out, "returns (RAS)\t"); rate(returns_ - return_miss_, returns_);
+    std::fprintf(out, "\t%llu\n", static_cast<unsigned long long>(returns_));
+    std::fprintf(out, "BTB hit rate\t"); rate(btb_hits_, btb_lookups_);
+    std::fprintf(out, "\n");
+}
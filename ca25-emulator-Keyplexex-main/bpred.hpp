@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "decode.hpp"
+
+// Предсказатели направления условных переходов. Размер таблиц — степень двойки (bits).
+class DirectionPredictor {
+public:
+    virtual ~DirectionPredictor() = default;
+    // target — адрес перехода (известен после декодирования)
+    virtual bool predict(uint32_t pc, uint32_t target) = 0;
+    // вызывается после predict для того же pc
+    virtual void update(uint32_t pc, bool taken) = 0;
+    virtual std::string name() const = 0;
+};
+
+// static:            назад — перейдёт, вперёд — нет (BTFN)
+// bimodal:<bits>     2-битные счётчики по pc
+// gshare:<bits>      2-битные счётчики по pc ^ глобальная история
+// tage:<bits>        упрощённый TAGE: bimodal + 4 таблицы с тегами и историями 4..64
+// false — неизвестное имя или размер
+bool make_predictor(const std::string& spec, std::unique_ptr<DirectionPredictor>& out, std::string& err);
+
+// Блок предсказания переходов: BTB и стек адресов возврата общие,
+// направление условных переходов предсказывает каждый из predictors.
+// Подключается хуком retire.
+class BranchUnit {
+public:
+    struct Config {
+        std::size_t btb_entries = 512;
+        std::size_t ras_depth   = 16;
+    };
+
+    BranchUnit(const Config& c, std::vector<std::unique_ptr<DirectionPredictor>> predictors);
+
+    void retire(const DecodedInsn& d, uint32_t next_pc);
+
+    void report(std::FILE* out) const;
+
+private:
+    struct BtbEntry { uint32_t pc = 0, target = 0; bool valid = false; };
+
+    // цель из BTB или false
+    bool btb_lookup(uint32_t pc, uint32_t& target) const;
+    void btb_update(uint32_t pc, uint32_t target);
+
+    Config cfg_;
+    std::vector<BtbEntry> btb_;
+    std::vector<uint32_t> ras_;   // кольцевой стек
+    std::size_t ras_top_ = 0, ras_size_ = 0;
+
+    struct PredictorStats {
+        std::unique_ptr<DirectionPredictor> p;
+        uint64_t cond_miss = 0;     // неверное направление или неизвестная цель
+    };
+    std::vector<PredictorStats> predictors_;
+
+    uint64_t instret_ = 0;
+    uint64_t cond_ = 0;
+    uint64_t jumps_ = 0, jump_miss_ = 0;     // JAL и JALR кроме возвратов
+    uint64_t returns_ = 0, return_miss_ = 0;
+    uint64_t btb_lookups_ = 0, btb_hits_ = 0;
+};
@@ -1,6 +1,12 @@
 #pragma once
 #include <cstdint>
+#include <bit>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 #include "config.hpp"
+#include "decode.hpp"
 
 // Тип обращения для раздельной статистики
 enum class AccessKind { Inst, Data };
@@ -12,16 +18,373 @@ struct CacheStats {
     uint64_t hits_data  = 0,  misses_data  = 0;
 };
 
-// Интерфейс кэша 
-class Cache {
+// Модели кэша без виртуальных функций: CPU::run_impl получает их списком типов
+// (CacheList) и вызовы read/write встраиваются прямо в обработчики инструкций.
+
+// Геометрия по заданию (config.hpp): всё известно при компиляции
+struct DefaultGeometry {
+    static constexpr std::size_t sets()        { return CACHE_SET_COUNT; }
+    static constexpr std::size_t ways()        { return CACHE_WAY; }
+    static constexpr unsigned    offset_bits() { return CACHE_OFFSET_LEN; }
+    static constexpr unsigned    index_bits()  { return CACHE_INDEX_LEN; }
+};
+
+// Геометрия, заданная при запуске (riscv-replay): sets и line_size — степени двойки
+class DynamicGeometry {
 public:
-    virtual ~Cache() = default;
-    virtual bool read (uint32_t addr, std::size_t size, AccessKind k) = 0; // только моделирование попадания/промаха
-    virtual bool write(uint32_t addr, std::size_t size, AccessKind k) = 0;
+    DynamicGeometry(std::size_t sets, std::size_t ways, std::size_t line_size)
+        : sets_(sets), ways_(ways),
+          offset_bits_(static_cast<unsigned>(std::countr_zero(line_size))),
+          index_bits_(static_cast<unsigned>(std::countr_zero(sets))) {}
+
+    std::size_t sets()        const { return sets_; }
+    std::size_t ways()        const { return ways_; }
+    unsigned    offset_bits() const { return offset_bits_; }
+    unsigned    index_bits()  const { return index_bits_; }
+
+private:
+    std::size_t sets_, ways_;
+    unsigned offset_bits_, index_bits_;
+};
+
+struct CacheLine {
+    bool     valid{false};
+    bool     dirty{false};
+    uint32_t tag{0};
+    uint8_t  age{0};
+    bool plru = false;
+};
+
+// --- база с общим хелпером обновления статистики ---
+template <class Geometry>
+class CacheModel {
+public:
+    explicit CacheModel(Geometry g = {}) : geo_(g), lines_(g.sets() * g.ways()) {}
+
     const CacheStats& stats() const { return st_; }
+    const Geometry& geometry() const { return geo_; }
+    uint32_t line_size() const { return 1u << geo_.offset_bits(); }
+
+    // Линия, вытесненная последним промахом (valid=false — место было свободно).
+    // Нужна иерархии кэшей, чтобы учесть write-back грязных линий.
+    struct Eviction { bool valid = false; bool dirty = false; uint32_t addr = 0; };
+    const Eviction& last_eviction() const { return evicted_; }
+
+    // Всё состояние модели (checkpoint.cpp): линии наборов подряд, счётчики
+    const std::vector<CacheLine>& lines() const { return lines_; }
+    void restore(const std::vector<CacheLine>& lines, const CacheStats& st, uint64_t inst, uint64_t data) {
+        lines_ = lines;
+        st_ = st;
+        total_accesses_inst_ = inst;
+        total_accesses_data_ = data;
+    }
+
+    // Accessors useful for debug/comparison with другой реализацией
+    uint64_t total_inst_accesses() const { return total_accesses_inst_; }
+    uint64_t total_data_accesses() const { return total_accesses_data_; }
+
 protected:
+    uint32_t addr_index(uint32_t addr) const {
+        return (addr >> geo_.offset_bits()) & ((1u << geo_.index_bits()) - 1u);
+    }
+    uint32_t addr_tag(uint32_t addr) const {
+        // сдвиг на 32 бита не определён — кэш из одной огромной линии не бывает
+        return addr >> (geo_.offset_bits() + geo_.index_bits());
+    }
+
+    int ways() const { return static_cast<int>(geo_.ways()); }
+
+    // линии набора лежат подряд
+    CacheLine*       set_lines(uint32_t set_idx)       { return &lines_[set_idx * geo_.ways()]; }
+    const CacheLine* set_lines(uint32_t set_idx) const { return &lines_[set_idx * geo_.ways()]; }
+
+    void stat_hit(AccessKind k) {
+        st_.hits_total++;
+        if (k == AccessKind::Inst) st_.hits_inst++; else st_.hits_data++;
+    }
+    void stat_miss(AccessKind k) {
+        st_.misses_total++;
+        if (k == AccessKind::Inst) st_.misses_inst++; else st_.misses_data++;
+    }
+
+    void count_access(AccessKind k) {
+        if (k == AccessKind::Inst) ++total_accesses_inst_;
+        else ++total_accesses_data_;
+    }
+
+    // Возвращает индекс way при попадании, иначе -1
+    int find_hit(uint32_t set_idx, uint32_t tag) const {
+        const CacheLine* S = set_lines(set_idx);
+        for (int w=0; w<ways(); ++w) {
+            if (S[w].valid && S[w].tag == tag) return w;
+        }
+        return -1;
+    }
+
+    void note_eviction(uint32_t set_idx, const CacheLine& L) {
+        evicted_.valid = L.valid;
+        evicted_.dirty = L.valid && L.dirty;
+        evicted_.addr  = (L.tag << (geo_.offset_bits() + geo_.index_bits())) | (set_idx << geo_.offset_bits());
+    }
+
+    [[no_unique_address]] Geometry geo_;
+    std::vector<CacheLine> lines_; // sets * ways
     CacheStats st_;
+
+    // counters for accesses separated by kind (instruction / data)
+    uint64_t total_accesses_inst_ = 0;
+    uint64_t total_accesses_data_ = 0;
+
+    Eviction evicted_;
 };
 
-Cache* make_lru_cache();
-Cache* make_bplru_cache();
+// ---------------- LRU ----------------
+template <class Geometry>
+class LRUCacheT : public CacheModel<Geometry> {
+    using Base = CacheModel<Geometry>;
+    using Base::addr_index, Base::addr_tag, Base::ways, Base::set_lines,
+          Base::stat_hit, Base::stat_miss, Base::count_access, Base::find_hit, Base::note_eviction;
+
+public:
+    using Base::Base;
+
+    bool read(uint32_t addr, std::size_t /*size*/, AccessKind k) {
+        count_access(k); // важный счётчик
+        const uint32_t si  = addr_index(addr);
+        const uint32_t tag = addr_tag(addr);
+        int w = find_hit(si, tag);
+        if (w >= 0) { stat_hit(k); touch_lru(si, w); return true; }
+        stat_miss(k);
+        int v = victim_lru(si);
+        // write-back: если dirty — «сбрасываем» (в нашей модели это no-op)
+        // write-allocate: при чтении всегда аллоцируем и помечаем clean
+        fill_line(si, v, tag, /*dirty_on_fill=*/false);
+        touch_lru(si, v);
+        return false;
+    }
+
+    bool write(uint32_t addr, std::size_t /*size*/, AccessKind k) {
+        count_access(k); // важный счётчик
+        const uint32_t si  = addr_index(addr);
+        const uint32_t tag = addr_tag(addr);
+        int w = find_hit(si, tag);
+        if (w >= 0) { // hit
+            stat_hit(k);
+            set_lines(si)[w].dirty = true; // write-back
+            touch_lru(si, w);
+            return true;
+        }
+        // miss
+        stat_miss(k);
+        int v = victim_lru(si);
+        // если была грязная — «сбросить» (no-op)
+        // write-allocate: загружаем и сразу помечаем dirty
+        fill_line(si, v, tag, /*dirty_on_fill=*/true);
+        touch_lru(si, v);
+        return false;
+    }
+
+private:
+    // Выбор жертвы: сначала ищем invalid; иначе — максимальный age
+    int victim_lru(uint32_t set_idx) const {
+        const CacheLine* S = set_lines(set_idx);
+        // сначала свободная линия
+        for (int w=0; w<ways(); ++w) if (!S[w].valid) return w;
+        // иначе — выбрать максимальную age
+        int vw = 0;
+        uint8_t best = S[0].age;
+        for (int w=1; w<ways(); ++w) {
+            if (S[w].age > best) { best = S[w].age; vw = w; }
+        }
+        return vw;
+    }
+
+    // Обновить LRU-возраст: у попавшей линии age=0; у остальных в наборе +1 (с насыщением до 255)
+    void touch_lru(uint32_t set_idx, int used_way) {
+        CacheLine* S = set_lines(set_idx);
+        for (int w=0; w<ways(); ++w) {
+            if (w == used_way) S[w].age = 0;
+            else if (S[w].valid && S[w].age < 255) S[w].age++;
+        }
+    }
+
+    // «Загрузка» в жертву: выставляем метаданные; dirty выставляем по типу операции
+    void fill_line(uint32_t set_idx, int way, uint32_t tag, bool dirty_on_fill) {
+        auto& L = set_lines(set_idx)[way];
+        note_eviction(set_idx, L);
+        L.valid = true;
+        L.tag   = tag;
+        L.dirty = dirty_on_fill;
+        L.age   = 0;
+        // Остальным age++ сделаем через touch_lru (вызовем сразу после fill)
+    }
+};
+
+// ---------------- (bpLRU) ----------------
+template <class Geometry>
+class BpLRUCacheT : public CacheModel<Geometry> {
+    using Base = CacheModel<Geometry>;
+    using Base::addr_index, Base::addr_tag, Base::ways, Base::set_lines,
+          Base::stat_hit, Base::stat_miss, Base::count_access, Base::find_hit, Base::note_eviction;
+
+public:
+    using Base::Base;
+
+    bool read(uint32_t addr, std::size_t /*size*/, AccessKind k) {
+        count_access(k);
+        const uint32_t si  = addr_index(addr);
+        const uint32_t tag = addr_tag(addr);
+        int w = find_hit(si, tag);
+        if (w >= 0) {
+            stat_hit(k);
+            touch_bplru(si, w);
+            return true;
+        }
+        stat_miss(k);
+        int v = victim_bplru(si);
+        fill_line(si, v, tag, /*dirty_on_fill=*/false);
+        return false;
+    }
+
+    bool write(uint32_t addr, std::size_t /*size*/, AccessKind k) {
+        count_access(k);
+        const uint32_t si  = addr_index(addr);
+        const uint32_t tag = addr_tag(addr);
+        int w = find_hit(si, tag);
+        if (w >= 0) {
+            stat_hit(k);
+            set_lines(si)[w].dirty = true;
+            touch_bplru(si, w);
+            return true;
+        }
+        stat_miss(k);
+        int v = victim_bplru(si);
+        fill_line(si, v, tag, /*dirty_on_fill=*/true);
+        return false;
+    }
+
+private:
+    void touch_bplru(uint32_t set_idx, int way) {
+        CacheLine* S = set_lines(set_idx);
+        S[way].plru = true;
+
+        // Проверяем, все ли стали 1
+        bool all_one = true;
+        for (int w = 0; w < ways(); ++w) {
+            if (!S[w].plru) {
+                all_one = false;
+                break;
+            }
+        }
+
+        if (all_one) {
+            // Обнуляем все, кроме текущей
+            for (int w = 0; w < ways(); ++w) {
+                if (w != way) S[w].plru = false;
+            }
+        }
+    }
+
+    int victim_bplru(uint32_t set_idx) const {
+        const CacheLine* S = set_lines(set_idx);
+
+        // Сначала ищем invalid
+        for (int w = 0; w < ways(); ++w)
+            if (!S[w].valid) return w;
+
+        // Ищем первую линию с plru = 0
+        for (int w = 0; w < ways(); ++w)
+            if (!S[w].plru) return w;
+
+        return 0;
+    }
+
+    void fill_line(uint32_t set_idx, int way, uint32_t tag, bool dirty_on_fill) {
+        auto& L = set_lines(set_idx)[way];
+        note_eviction(set_idx, L);
+        L.valid = true;
+        L.tag   = tag;
+        L.dirty = dirty_on_fill;
+        L.age   = 0;
+        touch_bplru(set_idx, way);
+    }
+};
+
+// Кэши из задания
+using LRUCache   = LRUCacheT<DefaultGeometry>;
+using BpLRUCache = BpLRUCacheT<DefaultGeometry>;
+
+// Модель, которой нужны обращения к памяти / выполненные инструкции
+template <class M>
+concept AccessObserver = requires (M& m, uint32_t addr, std::size_t size, AccessKind k) {
+    m.read(addr, size, k);
+    m.write(addr, size, k);
+};
+template <class M>
+concept RetireObserver = requires (M& m, const DecodedInsn& d, uint32_t next_pc) { m.retire(d, next_pc); };
+
+// Список моделей, через которые CPU прогоняет каждое обращение.
+// CacheList<> — режим без статистики: обращения не стоят ничего.
+template <class... Models>
+class CacheList {
+public:
+    explicit CacheList(Models&... models) : models_(models...) {}
+
+    void fetch(uint32_t addr) {
+        std::apply([&](auto&... m) { (m.read(addr, 4, AccessKind::Inst), ...); }, models_);
+    }
+    void load(uint32_t addr, std::size_t size) {
+        std::apply([&](auto&... m) { (m.read(addr, size, AccessKind::Data), ...); }, models_);
+    }
+    void store(uint32_t addr, std::size_t size) {
+        std::apply([&](auto&... m) { (m.write(addr, size, AccessKind::Data), ...); }, models_);
+    }
+    // после каждой выполненной инструкции; только если какой-то модели это нужно
+    void retire(const DecodedInsn& d, uint32_t next_pc) requires (RetireObserver<Models> || ...) {
+        std::apply([&](auto&... m) {
+            ([&] { if constexpr (RetireObserver<std::remove_reference_t<decltype(m)>>) m.retire(d, next_pc); }(), ...);
+        }, models_);
+    }
+
+private:
+    std::tuple<Models&...> models_;
+};
+
+// Необязательные модели (профилировщик, трасса, иерархия кэшей, конвейер), выбранные при запуске.
+// Вызываются через указатели на функции: одна инстанциация run_impl на любую их комбинацию.
+class DynamicModels {
+public:
+    template <class M>
+    void add(M& m) {
+        if constexpr (AccessObserver<M>) {
+            entries_.push_back({&m,
+                [](void* self, uint32_t addr, std::size_t size, AccessKind k) { static_cast<M*>(self)->read(addr, size, k); },
+                [](void* self, uint32_t addr, std::size_t size, AccessKind k) { static_cast<M*>(self)->write(addr, size, k); }});
+        }
+        if constexpr (RetireObserver<M>) {
+            retirers_.push_back({&m,
+                [](void* self, const DecodedInsn& d, uint32_t next_pc) { static_cast<M*>(self)->retire(d, next_pc); }});
+        }
+    }
+    bool empty() const { return entries_.empty() && retirers_.empty(); }
+
+    bool read(uint32_t addr, std::size_t size, AccessKind k) {
+        for (const auto& e : entries_) e.read(e.self, addr, size, k);
+        return true;
+    }
+    bool write(uint32_t addr, std::size_t size, AccessKind k) {
+        for (const auto& e : entries_) e.write(e.self, addr, size, k);
+        return true;
+    }
+    void retire(const DecodedInsn& d, uint32_t next_pc) {
+        for (const auto& e : retirers_) e.retire(e.self, d, next_pc);
+    }
+
+private:
+    using AccessFn = void (*)(void*, uint32_t, std::size_t, AccessKind);
+    using RetireFn = void (*)(void*, const DecodedInsn&, uint32_t);
+    struct Entry { void* self; AccessFn read; AccessFn write; };
+    struct Retirer { void* self; RetireFn retire; };
+    std::vector<Entry> entries_;
+    std::vector<Retirer> retirers_;
+};
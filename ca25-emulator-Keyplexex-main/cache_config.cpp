@@ -0,0 +1,45 @@
+#include "cache_config.hpp"
+#include <cstdlib>
+
+namespace {
+
+bool is_pow2(std::size_t v) { return v && !(v & (v - 1)); }
+
+}
+
+bool parse_cache_config(const std::string& s, CacheConfig& c, std::string& err) {
+    const auto p1 = s.find(':');
+    if (p1 == std::string::npos) { err = "invalid cache config: " + s; return false; }
+    const std::string policy = s.substr(0, p1);
+    if (policy == "lru") c.policy = Policy::LRU;
+    else if (policy == "bplru") c.policy = Policy::BpLRU;
+    else { err = "unknown policy: " + policy; return false; }
+
+    // sets:ways:line и необязательная задержка
+    unsigned long v[4] = {0, 0, 0, c.latency};
+    const char* cur = s.c_str() + p1 + 1;
+    for (int i = 0; i < 4; ++i) {
+        char* end = nullptr;
+        v[i] = std::strtoul(cur, &end, 0);
+        if (end == cur) { err = "invalid cache config: " + s; return false; }
+        if (*end == '\0' && i >= 2) break;
+        if (*end != ':' || i == 3) { err = "invalid cache config: " + s; return false; }
+        cur = end + 1;
+    }
+    c.sets = v[0]; c.ways = v[1]; c.line = v[2]; c.latency = static_cast<unsigned>(v[3]);
+    if (!is_pow2(c.sets) || !is_pow2(c.line) || c.line < 4 || c.ways == 0 || c.ways > 64
+        || c.sets * c.line > (std::size_t{1} << 31)) {
+        err = "unsupported geometry: " + s; return false;
+    }
+    return true;
+}
+
+DynamicCache make_cache(const CacheConfig& c) {
+    DynamicGeometry g(c.sets, c.ways, c.line);
+    if (c.policy == Policy::LRU) return DynamicCache(std::in_place_index<0>, g);
+    return DynamicCache(std::in_place_index<1>, g);
+}
+
+const char* policy_name(Policy p) {
+    return p == Policy::LRU ? "LRU" : "bpLRU";
+}
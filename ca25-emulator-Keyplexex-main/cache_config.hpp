@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <variant>
+#include "cache.hpp"
+
+// Кэш, геометрия и политика которого заданы при запуске (riscv-replay, иерархия).
+// Строка конфигурации: policy:sets:ways:line[:latency], например lru:16:4:32:1
+
+enum class Policy { LRU, BpLRU };
+
+struct CacheConfig {
+    Policy      policy  = Policy::LRU;
+    std::size_t sets    = CACHE_SET_COUNT;
+    std::size_t ways    = CACHE_WAY;
+    std::size_t line    = CACHE_LINE_SIZE;
+    unsigned    latency = 1;   // такты на попадание (только для иерархии)
+};
+
+using DynamicCache = std::variant<LRUCacheT<DynamicGeometry>, BpLRUCacheT<DynamicGeometry>>;
+
+bool parse_cache_config(const std::string& s, CacheConfig& c, std::string& err);
+DynamicCache make_cache(const CacheConfig& c);
+const char* policy_name(Policy p);
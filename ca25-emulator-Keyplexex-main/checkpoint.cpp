@@ -0,0 +1,155 @@
+#include "checkpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr char MAGIC[8] = {'R','V','C','K','P','T','0','1'};
+
+class Writer {
+public:
+    template <class T> void put(T v) {
+        uint8_t b[sizeof(T)];
+        store_le<T>(b, v);
+        buf_.insert(buf_.end(), b, b + sizeof(T));
+    }
+    void put_bytes(const uint8_t* p, std::size_t n) { buf_.insert(buf_.end(), p, p + n); }
+    const std::vector<uint8_t>& data() const { return buf_; }
+
+private:
+    std::vector<uint8_t> buf_;
+};
+
+class Reader {
+public:
+    explicit Reader(const std::vector<uint8_t>& d) : p_(d.data()), end_(d.data() + d.size()) {}
+
+    template <class T> bool get(T& v) {
+        if (static_cast<std::size_t>(end_ - p_) < sizeof(T)) return false;
+        v = load_le<T>(p_);
+        p_ += sizeof(T);
+        return true;
+    }
+    const uint8_t* get_bytes(std::size_t n) {
+        if (static_cast<std::size_t>(end_ - p_) < n) return nullptr;
+        const uint8_t* r = p_;
+        p_ += n;
+        return r;
+    }
+    bool at_end() const { return p_ == end_; }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+};
+
+template <class Cache>
+void put_cache(Writer& w, const Cache& c) {
+    const CacheStats& st = c.stats();
+    for (uint64_t v : {st.hits_total, st.misses_total, st.hits_inst, st.misses_inst, st.hits_data, st.misses_data,
+                       c.total_inst_accesses(), c.total_data_accesses()})
+        w.put<uint64_t>(v);
+
+    w.put<uint32_t>(static_cast<uint32_t>(c.lines().size()));
+    for (const CacheLine& L : c.lines()) {
+        w.put<uint8_t>(static_cast<uint8_t>((L.valid ? 1 : 0) | (L.dirty ? 2 : 0) | (L.plru ? 4 : 0)));
+        w.put<uint8_t>(L.age);
+        w.put<uint32_t>(L.tag);
+    }
+}
+
+template <class Cache>
+bool get_cache(Reader& r, Cache& c) {
+    CacheStats st;
+    uint64_t inst = 0, data = 0;
+    for (uint64_t* v : {&st.hits_total, &st.misses_total, &st.hits_inst, &st.misses_inst,
+                        &st.hits_data, &st.misses_data, &inst, &data})
+        if (!r.get(*v)) return false;
+
+    uint32_t n = 0;
+    if (!r.get(n) || n != c.lines().size()) return false; // другая геометрия
+    std::vector<CacheLine> lines(n);
+    for (CacheLine& L : lines) {
+        uint8_t flags = 0;
+        if (!r.get(flags) || !r.get(L.age) || !r.get(L.tag)) return false;
+        L.valid = flags & 1;
+        L.dirty = flags & 2;
+        L.plru  = flags & 4;
+    }
+    c.restore(lines, st, inst, data);
+    return true;
+}
+
+bool page_is_zero(const uint8_t* p) {
+    for (std::size_t i = 0; i < Memory::PAGE_SIZE; ++i) if (p[i]) return false;
+    return true;
+}
+
+}
+
+bool save_checkpoint(const std::string& path, const CPU& cpu, const CheckpointState& st,
+                     const Memory& mem, const LRUCache& lru, const BpLRUCache& bplru, std::string& err) {
+    Writer w;
+    w.put_bytes(reinterpret_cast<const uint8_t*>(MAGIC), sizeof(MAGIC));
+    w.put<uint64_t>(st.steps);
+    w.put<uint32_t>(st.start_ra);
+    w.put<uint32_t>(cpu.pc_);
+    for (int i = 0; i < 32; ++i) w.put<uint32_t>(cpu.x_[i]);
+
+    // память: раскладка и ненулевые страницы
+    w.put<uint8_t>(mem.layout() == Memory::Layout::Paged ? 1 : 0);
+    std::vector<uint32_t> pages;
+    mem.for_each_page([&](uint32_t addr, const uint8_t* bytes) { if (!page_is_zero(bytes)) pages.push_back(addr); });
+    w.put<uint32_t>(static_cast<uint32_t>(pages.size()));
+    for (uint32_t addr : pages) {
+        uint8_t buf[Memory::PAGE_SIZE];
+        mem.read_bytes(addr, buf, sizeof(buf));
+        w.put<uint32_t>(addr);
+        w.put_bytes(buf, sizeof(buf));
+    }
+
+    put_cache(w, lru);
+    put_cache(w, bplru);
+
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) { err = "cannot open checkpoint file: " + path; return false; }
+    const auto& d = w.data();
+    const bool ok = std::fwrite(d.data(), 1, d.size(), f) == d.size();
+    if (std::fclose(f) != 0 || !ok) { err = "error writing checkpoint file: " + path; return false; }
+    return true;
+}
+
+bool load_checkpoint(const std::string& path, CPU& cpu, CheckpointState& st,
+                     Memory& mem, LRUCache& lru, BpLRUCache& bplru, std::string& err) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) { err = "cannot open checkpoint file: " + path; return false; }
+    std::vector<uint8_t> data;
+    uint8_t chunk[1 << 16];
+    for (std::size_t n; (n = std::fread(chunk, 1, sizeof(chunk), f)) > 0; ) data.insert(data.end(), chunk, chunk + n);
+    std::fclose(f);
+
+    Reader r(data);
+    const uint8_t* magic = r.get_bytes(sizeof(MAGIC));
+    if (!magic || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) { err = "not a checkpoint file: " + path; return false; }
+
+    err = "corrupted checkpoint file: " + path;
+    if (!r.get(st.steps) || !r.get(st.start_ra) || !r.get(cpu.pc_)) return false;
+    for (int i = 0; i < 32; ++i) if (!r.get(cpu.x_[i])) return false;
+    cpu.x_[0] = 0;
+
+    uint8_t layout = 0;
+    uint32_t npages = 0;
+    if (!r.get(layout) || layout > 1 || !r.get(npages)) return false;
+    mem = Memory(layout ? Memory::Layout::Paged : Memory::Layout::Flat);
+    for (uint32_t i = 0; i < npages; ++i) {
+        uint32_t addr = 0;
+        if (!r.get(addr)) return false;
+        const uint8_t* bytes = r.get_bytes(Memory::PAGE_SIZE);
+        if (!bytes || !mem.write_bytes(addr, bytes, Memory::PAGE_SIZE)) return false;
+    }
+
+    if (!get_cache(r, lru) || !get_cache(r, bplru) || !r.at_end()) return false;
+    err.clear();
+    return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "cache.hpp"
+#include "cpu.hpp"
+#include "memory.hpp"
+
+// Снимок состояния симулятора: регистры и pc, ra на старте, число выполненных
+// инструкций, память (только ненулевые страницы) и полное состояние LRU/bpLRU —
+// линии с тегами, dirty, age и битами PLRU, плюс счётчики статистики.
+// После восстановления run() продолжает ровно с того же места: итоговая таблица
+// и память совпадают с прогоном без остановки.
+struct CheckpointState {
+    uint64_t steps    = 0;   // выполнено до снимка
+    uint32_t start_ra = 0;
+};
+
+bool save_checkpoint(const std::string& path, const CPU& cpu, const CheckpointState& st,
+                     const Memory& mem, const LRUCache& lru, const BpLRUCache& bplru, std::string& err);
+
+// mem пересоздаётся с раскладкой из снимка
+bool load_checkpoint(const std::string& path, CPU& cpu, CheckpointState& st,
+                     Memory& mem, LRUCache& lru, BpLRUCache& bplru, std::string& err);
@@ -2,11 +2,14 @@
 #include <cstdint>
 #include "memory.hpp"
 #include "cache.hpp"
+#include "block_cache.hpp"
 
 struct ExecResult {
     bool ok = true;
     bool halted = false;
+    bool step_limit = false;  // остановились по max_steps (ok == false)
     uint32_t final_pc = 0;
+    uint64_t steps = 0;       // выполнено инструкций
 };
 
 class CPU {
@@ -15,11 +18,36 @@ public:
     void reset_from_regs(const uint32_t regs_in[32], uint32_t& start_ra_out);
     void export_regs(uint32_t regs_out[32]) const;
 
-    ExecResult run(Memory& mem, Cache& cache_lru, Cache& cache_bplru,
+    // Сколько инструкций может выполнить run() (по заданию — 50M)
+    static constexpr uint64_t MAX_STEPS = 50'000'000ULL;
+    void set_max_steps(uint64_t n) { max_steps_ = n; }
+
+    // LRU и (при enable_bplru) bpLRU видят каждое обращение
+    ExecResult run(Memory& mem, LRUCache& cache_lru, BpLRUCache& cache_bplru,
                    bool enable_bplru, uint32_t start_ra);
+    // без моделей кэша
+    ExecResult run(Memory& mem, uint32_t start_ra);
+
+    // Произвольный набор хуков, например CacheList с дополнительными моделями
+    // (нужен cpu_run.hpp в месте вызова)
+    template <class Hooks>
+    ExecResult run_with(Memory& mem, Hooks& hooks, uint32_t start_ra) {
+        blocks_.reset(start_ra);
+        return run_impl(mem, hooks, start_ra);
+    }
+
+    // Основной цикл (cpu_run.hpp). Hooks может определять fetch(pc),
+    // load(addr, size) и store(addr, size) — вызываются перед обращением к памяти,
+    // retire(insn, next_pc) — после выполнения инструкции, block(start_pc, n) — на выходе
+    // из блока. Вызывается повторно — продолжает с pc_ (блоки не сбрасываются).
+    template <class Hooks>
+    ExecResult run_impl(Memory& mem, Hooks& hooks, uint32_t start_ra);
 
 //private:
     uint32_t x_[32]{};
     uint32_t pc_{0};
 	uint32_t get_pc() const;
+
+    BlockCache blocks_; // декодированные блоки, сбрасываются в начале run()
+    uint64_t max_steps_ = MAX_STEPS;
 };
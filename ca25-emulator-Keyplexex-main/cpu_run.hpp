@@ -0,0 +1,317 @@
+#pragma once
+// Основной цикл CPU (шаблон по набору хуков), подключается там, где он инстанцируется.
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "cpu.hpp"
+
+namespace cpu_detail {
+
+// sign-extend 'bits' LSBs of x into 32-bit signed value, returned as uint32_t bitpattern
+inline uint32_t sext(uint32_t x, int bits) {
+    uint32_t m = 1u << (bits - 1);
+    return (x ^ m) - m;
+}
+
+inline void write_rd(uint32_t* x, int rd, uint32_t val) {
+    if (rd != 0) x[rd] = val;
+}
+
+}
+
+// Исполнение идёт по декодированным блокам (block_cache.hpp) с диспетчеризацией
+// через таблицу меток (GCC/Clang, "labels as values"); иначе — через switch.
+// Кэши по-прежнему видят каждую выборку инструкции, а останов по ra, max_steps_
+// и x0 == 0 ведут себя так же, как при покомандном исполнении.
+#if defined(__GNUC__)
+#define RV_THREADED_DISPATCH 1
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+template <class Hooks>
+ExecResult CPU::run_impl(Memory& mem, Hooks& hooks, uint32_t start_ra)
+{
+    using namespace cpu_detail;
+
+    ExecResult r;
+    r.ok = true;
+    r.halted = false;
+    r.final_pc = pc_;
+
+    const uint64_t MAX_STEPS = max_steps_;
+    uint64_t steps = 0;
+
+    // Обращения сначала идут в модели кэша (статистика), потом в память.
+    // Любой из хуков fetch/load/store может отсутствовать.
+    auto do_fetch32 = [&](uint32_t addr) {
+        if constexpr (requires { hooks.fetch(addr); }) hooks.fetch(addr);
+    };
+
+    // инструкция выполнена, дальше исполнение идёт с next_pc (модели конвейера, предсказателей)
+    auto do_retire = [&](const DecodedInsn& d, uint32_t next_pc) {
+        if constexpr (requires { hooks.retire(d, next_pc); }) hooks.retire(d, next_pc);
+    };
+
+    // блок с адресом start_pc пройден, выполнено n его инструкций (векторы базовых блоков)
+    auto do_block = [&](uint32_t start_pc, uint64_t n) {
+        if constexpr (requires { hooks.block(start_pc, n); }) hooks.block(start_pc, n);
+    };
+
+    auto do_load = [&](uint32_t addr, int size, uint32_t &out)->bool {
+        if constexpr (requires { hooks.load(addr, std::size_t{}); }) hooks.load(addr, size);
+        switch (size) {
+            case 1: { uint8_t v; if (!mem.read_u8(addr, v)) return false; out = v; return true; }
+            case 2: { uint16_t v; if (!mem.read_u16(addr, v)) return false; out = v; return true; }
+            case 4: { uint32_t v; if (!mem.read_u32(addr, v)) return false; out = v; return true; }
+            default: return false;
+        }
+    };
+
+    auto do_store = [&](uint32_t addr, int size, uint32_t val)->bool {
+        if constexpr (requires { hooks.store(addr, std::size_t{}); }) hooks.store(addr, size);
+        switch (size) {
+            case 1: return mem.write_u8(addr, static_cast<uint8_t>(val));
+            case 2: return mem.write_u16(addr, static_cast<uint16_t>(val));
+            case 4: return mem.write_u32(addr, val);
+            default: return false;
+        }
+    };
+
+#ifdef RV_THREADED_DISPATCH
+    static const void* const handlers[] = {
+#define RV_OP_LABEL(name) &&op_##name,
+        RV_OPS(RV_OP_LABEL)
+#undef RV_OP_LABEL
+        &&op_BLOCK_END,
+        &&op_STEP_LIMIT,
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<std::size_t>(Op::COUNT));
+    blocks_.set_handlers(handlers);
+#else
+    blocks_.set_handlers(nullptr);
+#endif
+    if (blocks_.stop_pc() != start_ra) blocks_.reset(start_ra);
+
+    uint32_t* const x = x_;
+    uint32_t pc = pc_;                    // адрес следующего блока
+    uint64_t base = 0;                    // steps на входе в текущий блок
+    uint32_t block_pc = 0;                // pc начала блока: STORE может освободить его insns
+    const DecodedInsn* begin = nullptr;
+    const DecodedInsn* ip = nullptr;
+    std::vector<DecodedInsn> tail;        // начало блока, обрезанное по MAX_STEPS
+
+#ifdef RV_THREADED_DISPATCH
+#define DISPATCH() goto *ip->handler
+#else
+#define DISPATCH() goto dispatch
+#endif
+#define NEXT() do { do_retire(*ip, ip->pc + 4); ++ip; DISPATCH(); } while (0)
+#define OP(name) op_##name: do_fetch32(ip->pc);
+    // текущая инструкция выполнена, дальше исполнение идёт с target
+#define JUMP(target) do { pc = (target); do_retire(*ip, pc); steps = base + (ip - begin) + 1; goto block_exit; } while (0)
+#define FAIL() do { pc_ = ip->pc; steps = base + (ip - begin) + 1; r.ok = false; r.steps = steps; return r; } while (0)
+#define LOAD(size, expr) { \
+        uint32_t addr = x[ip->rs1] + ip->imm, tmp = 0; \
+        if (!do_load(addr, size, tmp)) FAIL(); \
+        write_rd(x, ip->rd, expr); \
+        NEXT(); }
+    // запись в декодированный код: блоки страницы выбрасываются, исполнение продолжается с новым декодом
+#define STORE(size) { \
+        uint32_t addr = x[ip->rs1] + ip->imm; \
+        if (!do_store(addr, size, x[ip->rs2])) FAIL(); \
+        if (blocks_.is_code(addr, size)) { \
+            pc = ip->pc + 4; \
+            do_retire(*ip, pc); \
+            steps = base + (ip - begin) + 1; \
+            blocks_.invalidate(addr, size); \
+            goto block_exit; \
+        } \
+        NEXT(); }
+#define ALU(expr) { write_rd(x, ip->rd, expr); NEXT(); }
+#define BRANCH(cond) JUMP((cond) ? ip->imm : ip->pc + 4)
+
+next_block:
+    if (steps >= MAX_STEPS) { pc_ = pc; r.ok = false; r.step_limit = true; r.steps = steps; return r; } // exceeded MAX_STEPS
+    {
+        const Block* b = blocks_.get(pc, mem);
+        if (!b) { // инструкцию по pc не прочитать
+            ++steps;
+            do_fetch32(pc);
+            pc_ = pc;
+            r.ok = false;
+            r.steps = steps;
+            return r;
+        }
+
+        base = steps;
+        begin = b->insns.data();
+        if (MAX_STEPS - steps < b->size()) {
+            // блок не помещается в остаток шагов: исполняем его начало
+            const std::size_t n = static_cast<std::size_t>(MAX_STEPS - steps);
+            tail.assign(b->insns.begin(), b->insns.begin() + n + 1);
+            tail.back().op = Op::STEP_LIMIT;
+#ifdef RV_THREADED_DISPATCH
+            tail.back().handler = handlers[static_cast<std::size_t>(Op::STEP_LIMIT)];
+#endif
+            begin = tail.data();
+        }
+        block_pc = begin->pc;
+        ip = begin;
+        DISPATCH();
+    }
+
+block_exit:
+    do_block(block_pc, steps - base);
+    pc_ = pc;
+    if (pc == start_ra) {
+        r.halted = true;
+        r.final_pc = pc;
+        r.steps = steps;
+        return r;
+    }
+    goto next_block;
+
+#ifndef RV_THREADED_DISPATCH
+dispatch:
+    switch (ip->op) {
+#define RV_OP_CASE(name) case Op::name: goto op_##name;
+        RV_OPS(RV_OP_CASE)
+#undef RV_OP_CASE
+        case Op::BLOCK_END:  goto op_BLOCK_END;
+        case Op::STEP_LIMIT: goto op_STEP_LIMIT;
+        default:             goto op_ILLEGAL;
+    }
+#endif
+
+    // ---- обработчики ----
+OP(LUI)   ALU(ip->imm)
+OP(AUIPC) ALU(ip->pc + ip->imm)
+
+OP(JAL) {
+    write_rd(x, ip->rd, ip->pc + 4);
+    JUMP(ip->imm);
+}
+OP(JALR) {
+    uint32_t target = (x[ip->rs1] + ip->imm) & ~1u;
+    write_rd(x, ip->rd, ip->pc + 4);
+    JUMP(target);
+}
+
+OP(BEQ)  BRANCH(x[ip->rs1] == x[ip->rs2]);
+OP(BNE)  BRANCH(x[ip->rs1] != x[ip->rs2]);
+OP(BLT)  BRANCH(static_cast<int32_t>(x[ip->rs1]) <  static_cast<int32_t>(x[ip->rs2]));
+OP(BGE)  BRANCH(static_cast<int32_t>(x[ip->rs1]) >= static_cast<int32_t>(x[ip->rs2]));
+OP(BLTU) BRANCH(x[ip->rs1] <  x[ip->rs2]);
+OP(BGEU) BRANCH(x[ip->rs1] >= x[ip->rs2]);
+
+OP(LB)  LOAD(1, sext(tmp, 8))
+OP(LH)  LOAD(2, sext(tmp, 16))
+OP(LW)  LOAD(4, tmp)
+OP(LBU) LOAD(1, tmp & 0xFFu)
+OP(LHU) LOAD(2, tmp & 0xFFFFu)
+
+OP(SB) STORE(1)
+OP(SH) STORE(2)
+OP(SW) STORE(4)
+
+OP(ADDI)  ALU(x[ip->rs1] + ip->imm)
+OP(SLTI)  ALU((int32_t)x[ip->rs1] < (int32_t)ip->imm)
+OP(SLTIU) ALU(x[ip->rs1] < ip->imm)
+OP(XORI)  ALU(x[ip->rs1] ^ ip->imm)
+OP(ORI)   ALU(x[ip->rs1] | ip->imm)
+OP(ANDI)  ALU(x[ip->rs1] & ip->imm)
+OP(SLLI)  ALU(x[ip->rs1] << ip->imm)
+OP(SRLI)  ALU(x[ip->rs1] >> ip->imm)
+OP(SRAI)  ALU(static_cast<uint32_t>(static_cast<int32_t>(x[ip->rs1]) >> ip->imm))
+
+OP(ADD)  ALU(x[ip->rs1] + x[ip->rs2])
+OP(SUB)  ALU(x[ip->rs1] - x[ip->rs2])
+OP(SLL)  ALU(x[ip->rs1] << (x[ip->rs2] & 31))
+OP(SLT)  ALU((int32_t)x[ip->rs1] < (int32_t)x[ip->rs2])
+OP(SLTU) ALU(x[ip->rs1] < x[ip->rs2])
+OP(XOR)  ALU(x[ip->rs1] ^ x[ip->rs2])
+OP(SRL)  ALU(x[ip->rs1] >> (x[ip->rs2] & 31))
+OP(SRA)  ALU(static_cast<uint32_t>(static_cast<int32_t>(x[ip->rs1]) >> (x[ip->rs2] & 31)))
+OP(OR)   ALU(x[ip->rs1] | x[ip->rs2])
+OP(AND)  ALU(x[ip->rs1] & x[ip->rs2])
+
+OP(MUL) {
+    int64_t prod = (int64_t)(int32_t)x[ip->rs1] * (int64_t)(int32_t)x[ip->rs2];
+    ALU(static_cast<uint32_t>(prod & 0xFFFFFFFFu))
+}
+OP(MULH) {
+    int64_t prod = (int64_t)(int32_t)x[ip->rs1] * (int64_t)(int32_t)x[ip->rs2];
+    ALU(static_cast<uint32_t>((prod >> 32) & 0xFFFFFFFFu))
+}
+OP(MULHSU) {
+    int64_t prod = (int64_t)(int32_t)x[ip->rs1] * (uint64_t)x[ip->rs2];
+    ALU(static_cast<uint32_t>((prod >> 32) & 0xFFFFFFFFu))
+}
+OP(MULHU) {
+    uint64_t prod = (uint64_t)x[ip->rs1] * (uint64_t)x[ip->rs2];
+    ALU(static_cast<uint32_t>((prod >> 32) & 0xFFFFFFFFu))
+}
+OP(DIV) {
+    int32_t a = static_cast<int32_t>(x[ip->rs1]);
+    int32_t b = static_cast<int32_t>(x[ip->rs2]);
+    if (b == 0) ALU(0xFFFFFFFFu)
+    if (a == INT32_MIN && b == -1) ALU(static_cast<uint32_t>(INT32_MIN))
+    ALU(static_cast<uint32_t>(a / b))
+}
+OP(DIVU) {
+    uint32_t a = x[ip->rs1], b = x[ip->rs2];
+    ALU(b == 0 ? 0xFFFFFFFFu : a / b)
+}
+OP(REM) {
+    int32_t a = static_cast<int32_t>(x[ip->rs1]);
+    int32_t b = static_cast<int32_t>(x[ip->rs2]);
+    if (b == 0) ALU(static_cast<uint32_t>(a))
+    if (a == INT32_MIN && b == -1) ALU(0u)
+    ALU(static_cast<uint32_t>(a % b))
+}
+OP(REMU) {
+    uint32_t a = x[ip->rs1], b = x[ip->rs2];
+    ALU(b == 0 ? a : a % b)
+}
+
+OP(HALT) { // ecall / ebreak
+    do_retire(*ip, ip->pc);
+    pc_ = ip->pc;
+    steps = base + (ip - begin) + 1;
+    do_block(block_pc, steps - base);
+    r.halted = true;
+    r.final_pc = pc_;
+    r.steps = steps;
+    return r;
+}
+
+OP(ILLEGAL) FAIL();
+
+op_BLOCK_END: // блок кончился без перехода
+    pc = ip->pc;
+    steps = base + (ip - begin);
+    goto block_exit;
+
+op_STEP_LIMIT: // exceeded MAX_STEPS
+    pc_ = ip->pc;
+    r.ok = false;
+    r.step_limit = true;
+    r.steps = base + (ip - begin);
+    do_block(block_pc, r.steps - base);
+    return r;
+
+#undef DISPATCH
+#undef NEXT
+#undef OP
+#undef JUMP
+#undef FAIL
+#undef LOAD
+#undef STORE
+#undef ALU
+#undef BRANCH
+}
+
+#ifdef RV_THREADED_DISPATCH
+#pragma GCC diagnostic pop
+#endif
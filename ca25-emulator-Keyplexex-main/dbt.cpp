@@ -0,0 +1,529 @@
+#include "dbt.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include "cpu_run.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define RV_DBT_X64 1
+#endif
+
+#ifdef RV_DBT_X64
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// почему машинный код вернулся в диспетчер
+enum Exit : uint32_t {
+    EXIT_JUMP,      // переход на ctx.pc (в т.ч. на адрес останова)
+    EXIT_CHAIN,     // то же, ctx.patch — jmp, который можно направить на код ctx.pc
+    EXIT_INDIRECT,  // JALR на адрес, которого нет в таблице
+    EXIT_BUDGET,    // блок ctx.pc не помещается в остаток MAX_STEPS
+    EXIT_FAULT,     // обращение за пределы памяти на инструкции ctx.pc
+    EXIT_SMC,       // запись в декодированный код, дальше — ctx.pc
+};
+
+// деление по правилам RV32M (как в cpu_run.hpp)
+uint32_t rv_div(uint32_t ua, uint32_t ub) {
+    const int32_t a = static_cast<int32_t>(ua), b = static_cast<int32_t>(ub);
+    if (b == 0) return 0xFFFFFFFFu;
+    if (a == INT32_MIN && b == -1) return static_cast<uint32_t>(INT32_MIN);
+    return static_cast<uint32_t>(a / b);
+}
+uint32_t rv_divu(uint32_t a, uint32_t b) { return b == 0 ? 0xFFFFFFFFu : a / b; }
+uint32_t rv_rem(uint32_t ua, uint32_t ub) {
+    const int32_t a = static_cast<int32_t>(ua), b = static_cast<int32_t>(ub);
+    if (b == 0) return ua;
+    if (a == INT32_MIN && b == -1) return 0u;
+    return static_cast<uint32_t>(a % b);
+}
+uint32_t rv_remu(uint32_t a, uint32_t b) { return b == 0 ? a : a % b; }
+
+using CacheHooks = CacheList<LRUCache, BpLRUCache>;
+void hook_fetch(void* h, uint32_t pc) { static_cast<CacheHooks*>(h)->fetch(pc); }
+void hook_load (void* h, uint32_t addr, uint32_t size) { static_cast<CacheHooks*>(h)->load(addr, size); }
+void hook_store(void* h, uint32_t addr, uint32_t size) { static_cast<CacheHooks*>(h)->store(addr, size); }
+
+// ---- кодировщик нужного подмножества x86-64 ----
+enum Reg : unsigned { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+// [base + index * 2^scale + disp]; index < 0 — без индекса
+struct Mem { unsigned base; int32_t disp = 0; int index = -1; unsigned scale = 0; };
+
+enum Cond : uint8_t { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_A = 0x7, CC_L = 0xC, CC_GE = 0xD };
+
+// Пишет через отображение RW, а все адреса (pos, переходы) — в отображении RX
+class Emitter {
+public:
+    Emitter(uint8_t* p, uint8_t* exec) : p_(p), delta_(exec - p) {}
+    uint8_t* pos() const { return p_ + delta_; }
+
+    void byte(uint8_t b) { *p_++ = b; }
+    void u32(uint32_t v) { std::memcpy(p_, &v, 4); p_ += 4; }
+    void u64(uint64_t v) { std::memcpy(p_, &v, 8); p_ += 8; }
+
+    // opcode reg, r/m (память)
+    void rm(bool w, std::initializer_list<uint8_t> opc, unsigned reg, const Mem& m, bool opsize16 = false) {
+        if (opsize16) byte(0x66);
+        rex(w, reg, m.index >= 0 ? static_cast<unsigned>(m.index) : 0, m.base);
+        for (uint8_t b : opc) byte(b);
+        const bool sib = m.index >= 0 || (m.base & 7) == RSP;
+        const unsigned mod = (m.disp == 0 && (m.base & 7) != RBP) ? 0 : (m.disp >= -128 && m.disp <= 127) ? 1 : 2;
+        byte(static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | (sib ? 4 : (m.base & 7))));
+        if (sib) byte(static_cast<uint8_t>(m.scale << 6 | ((m.index >= 0 ? static_cast<unsigned>(m.index) : unsigned{RSP}) & 7) << 3 | (m.base & 7)));
+        if (mod == 1) byte(static_cast<uint8_t>(m.disp));
+        if (mod == 2) u32(static_cast<uint32_t>(m.disp));
+    }
+    // opcode reg, r/m (регистр)
+    void rr(bool w, std::initializer_list<uint8_t> opc, unsigned reg, unsigned rm_reg) {
+        rex(w, reg, 0, rm_reg);
+        for (uint8_t b : opc) byte(b);
+        byte(static_cast<uint8_t>(0xC0 | (reg & 7) << 3 | (rm_reg & 7)));
+    }
+
+    void mov_imm32(unsigned r, uint32_t v) { rex(false, 0, 0, r); byte(static_cast<uint8_t>(0xB8 + (r & 7))); u32(v); }
+    void mov_imm64(unsigned r, uint64_t v) { rex(true, 0, 0, r); byte(static_cast<uint8_t>(0xB8 + (r & 7))); u64(v); }
+
+    // jmp/jcc rel32; возвращает место rel32 для patch()
+    uint8_t* jmp() { byte(0xE9); return hole(); }
+    uint8_t* jcc(Cond c) { byte(0x0F); byte(static_cast<uint8_t>(0x80 | c)); return hole(); }
+    void jmp_to(const uint8_t* target) { patch(jmp(), target); }
+    void patch(uint8_t* site, const uint8_t* target) { patch(site - delta_, site, target); }
+
+    // rel32 по адресу site (RX), записанный по адресу write (RW)
+    static void patch(uint8_t* write, const uint8_t* site, const uint8_t* target) {
+        const int32_t rel = static_cast<int32_t>(target - (site + 4));
+        std::memcpy(write, &rel, 4);
+    }
+
+private:
+    void rex(bool w, unsigned reg, unsigned index, unsigned base) {
+        const uint8_t b = static_cast<uint8_t>(0x40 | w << 3 | (reg >> 3) << 2 | (index >> 3) << 1 | (base >> 3));
+        if (b != 0x40) byte(b);
+    }
+    uint8_t* hole() { uint8_t* s = pos(); u32(0); return s; }
+
+    uint8_t* p_;
+    std::ptrdiff_t delta_;
+};
+
+constexpr int32_t off(std::size_t o) { return static_cast<int32_t>(o); }
+using Ctx = DbtEngine::Context;
+
+// Регистры машинного кода: rbx — CPU::x_, r12 — память, r13 — Context, r14 — карта страниц кода,
+// r15 — адрес текущего обращения (переживает вызов модели кэша)
+Mem guest(unsigned i) { return {RBX, static_cast<int32_t>(4 * i)}; }
+Mem field(std::size_t o) { return {R13, off(o)}; }
+
+}
+
+// W^X: одна и та же память (memfd) отображена дважды — для записи (RW) и для
+// исполнения (RX), страниц, доступных и на запись, и на исполнение, нет
+DbtEngine::DbtEngine() : table_(TABLE_SIZE) {
+    const int fd = memfd_create("riscv-dbt", MFD_CLOEXEC);
+    if (fd < 0) return; // остаётся интерпретатор
+    void* w = MAP_FAILED;
+    void* x = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(CODE_SIZE)) == 0) {
+        w = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        x = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (w == MAP_FAILED || x == MAP_FAILED) {
+        if (w != MAP_FAILED) munmap(w, CODE_SIZE);
+        if (x != MAP_FAILED) munmap(x, CODE_SIZE);
+        return;
+    }
+    wcode_ = static_cast<uint8_t*>(w);
+    code_ = static_cast<uint8_t*>(x);
+    emit_trampoline();
+    flush();
+    flushes_ = 0;
+}
+
+DbtEngine::~DbtEngine() {
+    if (code_) munmap(code_, CODE_SIZE);
+    if (wcode_) munmap(wcode_, CODE_SIZE);
+}
+
+uint8_t* DbtEngine::writable(const uint8_t* p) const { return wcode_ + (p - code_); }
+
+// enter(ctx, code): сохранить регистры, загрузить базовые и прыгнуть в блок.
+// Блоки выходят прыжком на эпилог с причиной в eax. Стек выровнен на 16 для вызовов.
+void DbtEngine::emit_trampoline() {
+    Emitter e(wcode_, code_);
+    for (unsigned r : {RBX, RBP, R12, R13, R14, R15}) { if (r >= R8) e.byte(0x41); e.byte(static_cast<uint8_t>(0x50 + (r & 7))); }
+    e.byte(0x48); e.byte(0x83); e.byte(0xEC); e.byte(0x08);               // sub rsp, 8
+    e.rr(true, {0x89}, RDI, R13);                                         // mov r13, rdi
+    e.rm(true, {0x8B}, RBX, field(offsetof(Ctx, x)));
+    e.rm(true, {0x8B}, R12, field(offsetof(Ctx, mem)));
+    e.rm(true, {0x8B}, R14, field(offsetof(Ctx, code_pages)));
+    e.rr(false, {0xFF}, 4, RSI);                                          // jmp rsi
+
+    epilogue_ = e.pos();
+    e.byte(0x48); e.byte(0x83); e.byte(0xC4); e.byte(0x08);               // add rsp, 8
+    for (unsigned r : {R15, R14, R13, R12, RBP, RBX}) { if (r >= R8) e.byte(0x41); e.byte(static_cast<uint8_t>(0x58 + (r & 7))); }
+    e.byte(0xC3);
+
+    enter_ = reinterpret_cast<uint32_t (*)(Context*, const uint8_t*)>(code_);
+    code_end_ = e.pos();
+}
+
+void DbtEngine::flush() {
+    native_.clear();
+    for (auto& t : table_) t = {1, 0, nullptr}; // нечётный pc — JALR туда не прыгает
+    emit_ = code_end_;
+    ++flushes_;
+}
+
+// Блок в машинный код; nullptr — блок остаётся интерпретатору
+const uint8_t* DbtEngine::translate(const Block& b, uint32_t start_ra, uint32_t mem_size) {
+    for (std::size_t i = 0; i < b.size(); ++i)
+        if (b.insns[i].op == Op::HALT || b.insns[i].op == Op::ILLEGAL) return nullptr;
+    if (static_cast<std::size_t>(code_ + CODE_SIZE - emit_) < BLOCK_MAX_CODE) flush();
+
+    Emitter e(writable(emit_), emit_);
+    const uint8_t* entry = e.pos();
+    const uint32_t len = static_cast<uint32_t>(b.size());
+
+    // выходы, вынесенные за тело блока
+    struct Stub { uint8_t* site; Exit kind; uint32_t pc; uint32_t refund; uint32_t size; };
+    std::vector<Stub> stubs;
+
+    auto exit_to_epilogue = [&](Exit why) { e.mov_imm32(RAX, why); e.jmp_to(epilogue_); };
+    auto set_pc = [&](uint32_t pc) { e.rm(false, {0xC7}, 0, field(offsetof(Ctx, pc))); e.u32(pc); };
+    // выход на известный адрес: сцепляемый jmp, пока не сцеплен — в диспетчер
+    auto direct_exit = [&](uint32_t target) {
+        if (target == start_ra) { set_pc(target); exit_to_epilogue(EXIT_JUMP); return; }
+        uint8_t* site = e.jmp();
+        e.patch(site, e.pos());
+        set_pc(target);
+        e.mov_imm64(RAX, reinterpret_cast<uint64_t>(site));
+        e.rm(true, {0x89}, RAX, field(offsetof(Ctx, patch)));
+        exit_to_epilogue(EXIT_CHAIN);
+    };
+    auto call_hook = [&](std::size_t fn, uint32_t size) {
+        e.rm(true, {0x8B}, RDI, field(offsetof(Ctx, hooks)));
+        if (fn == offsetof(Ctx, fetch)) e.mov_imm32(RSI, size);          // для fetch size — это pc
+        else { e.rr(false, {0x89}, R15, RSI); e.mov_imm32(RDX, size); }
+        e.rm(false, {0xFF}, 2, field(fn));
+    };
+    auto load_guest = [&](unsigned r, unsigned i) {
+        if (i == 0) e.rr(false, {0x31}, r, r);
+        else e.rm(false, {0x8B}, r, guest(i));
+    };
+    auto store_guest = [&](unsigned i, unsigned r) { if (i) e.rm(false, {0x89}, r, guest(i)); };
+    auto store_imm = [&](unsigned i, uint32_t v) { if (i) { e.rm(false, {0xC7}, 0, guest(i)); e.u32(v); } };
+    auto alu_imm = [&](unsigned ext, uint32_t v) { e.rr(false, {0x81}, ext, RAX); e.u32(v); };
+    auto setcc = [&](Cond c) { e.byte(0x0F); e.byte(static_cast<uint8_t>(0x90 | c)); e.byte(0xC0); e.rr(false, {0x0F, 0xB6}, RAX, RAX); };
+    auto call_fn = [&](uint32_t (*fn)(uint32_t, uint32_t)) { e.mov_imm64(RAX, reinterpret_cast<uint64_t>(fn)); e.rr(false, {0xFF}, 2, RAX); };
+    // r15d = x[rs1] + imm; со статистикой — модель кэша; проверка границ
+    auto address = [&](const DecodedInsn& d, uint32_t size, std::size_t hook, uint32_t idx) {
+        load_guest(R15, d.rs1);
+        if (d.imm) { e.rr(false, {0x81}, 0, R15); e.u32(d.imm); }
+        if (stats_) call_hook(hook, size);
+        e.rr(false, {0x81}, 7, R15); e.u32(mem_size - size);               // cmp r15d, size - N
+        stubs.push_back({e.jcc(CC_A), EXIT_FAULT, d.pc, len - idx - 1, 0});
+    };
+    const Mem host{R12, 0, R15, 0};
+
+    // хватает ли остатка MAX_STEPS на весь блок
+    e.rm(true, {0x81}, 7, field(offsetof(Ctx, left))); e.u32(len);
+    stubs.push_back({e.jcc(CC_B), EXIT_BUDGET, b.start_pc, 0, 0});
+    e.rm(true, {0x81}, 5, field(offsetof(Ctx, left))); e.u32(len);
+
+    bool ended = false;
+    for (uint32_t idx = 0; idx < len; ++idx) {
+        const DecodedInsn& d = b.insns[idx];
+        if (stats_) call_hook(offsetof(Ctx, fetch), d.pc);
+        const unsigned rd = d.rd;
+
+        switch (d.op) {
+        case Op::LUI:   store_imm(rd, d.imm); break;
+        case Op::AUIPC: store_imm(rd, d.pc + d.imm); break;
+
+        case Op::ADDI: case Op::XORI: case Op::ORI: case Op::ANDI:
+            if (!rd) break;
+            load_guest(RAX, d.rs1);
+            alu_imm(d.op == Op::ADDI ? 0 : d.op == Op::XORI ? 6 : d.op == Op::ORI ? 1 : 4, d.imm);
+            store_guest(rd, RAX);
+            break;
+        case Op::SLTI: case Op::SLTIU:
+            if (!rd) break;
+            load_guest(RAX, d.rs1);
+            alu_imm(7, d.imm);
+            setcc(d.op == Op::SLTI ? CC_L : CC_B);
+            store_guest(rd, RAX);
+            break;
+        case Op::SLLI: case Op::SRLI: case Op::SRAI:
+            if (!rd) break;
+            load_guest(RAX, d.rs1);
+            e.rr(false, {0xC1}, d.op == Op::SLLI ? 4 : d.op == Op::SRLI ? 5 : 7, RAX); e.byte(static_cast<uint8_t>(d.imm & 31));
+            store_guest(rd, RAX);
+            break;
+
+        case Op::ADD: case Op::SUB: case Op::XOR: case Op::OR: case Op::AND: {
+            if (!rd) break;
+            const uint8_t opc = d.op == Op::ADD ? 0x03 : d.op == Op::SUB ? 0x2B : d.op == Op::XOR ? 0x33 : d.op == Op::OR ? 0x0B : 0x23;
+            load_guest(RAX, d.rs1);
+            e.rm(false, {opc}, RAX, guest(d.rs2));
+            store_guest(rd, RAX);
+            break;
+        }
+        case Op::SLT: case Op::SLTU:
+            if (!rd) break;
+            load_guest(RAX, d.rs1);
+            e.rm(false, {0x3B}, RAX, guest(d.rs2));
+            setcc(d.op == Op::SLT ? CC_L : CC_B);
+            store_guest(rd, RAX);
+            break;
+        case Op::SLL: case Op::SRL: case Op::SRA:
+            if (!rd) break;
+            load_guest(RAX, d.rs1);
+            load_guest(RCX, d.rs2);
+            e.rr(false, {0xD3}, d.op == Op::SLL ? 4 : d.op == Op::SRL ? 5 : 7, RAX); // сдвиг на cl & 31
+            store_guest(rd, RAX);
+            break;
+
+        case Op::MUL:
+            if (!rd) break;
+            load_guest(RAX, d.rs1);
+            e.rm(false, {0x0F, 0xAF}, RAX, guest(d.rs2));
+            store_guest(rd, RAX);
+            break;
+        case Op::MULH: case Op::MULHSU: case Op::MULHU:
+            // 64-битное произведение знако-/нуль-расширенных операндов, старшая половина
+            if (!rd) break;
+            if (d.op == Op::MULHU) load_guest(RAX, d.rs1); else e.rm(true, {0x63}, RAX, guest(d.rs1));
+            if (d.op == Op::MULH) e.rm(true, {0x63}, RCX, guest(d.rs2)); else load_guest(RCX, d.rs2);
+            e.rr(true, {0x0F, 0xAF}, RAX, RCX);
+            e.rr(true, {0xC1}, 5, RAX); e.byte(32);
+            store_guest(rd, RAX);
+            break;
+        case Op::DIV: case Op::DIVU: case Op::REM: case Op::REMU:
+            if (!rd) break;
+            load_guest(RDI, d.rs1);
+            load_guest(RSI, d.rs2);
+            call_fn(d.op == Op::DIV ? rv_div : d.op == Op::DIVU ? rv_divu : d.op == Op::REM ? rv_rem : rv_remu);
+            store_guest(rd, RAX);
+            break;
+
+        case Op::LB: case Op::LH: case Op::LW: case Op::LBU: case Op::LHU: {
+            const uint32_t size = d.op == Op::LW ? 4 : (d.op == Op::LH || d.op == Op::LHU) ? 2 : 1;
+            address(d, size, offsetof(Ctx, load), idx);
+            switch (d.op) {
+                case Op::LB:  e.rm(false, {0x0F, 0xBE}, RAX, host); break;
+                case Op::LBU: e.rm(false, {0x0F, 0xB6}, RAX, host); break;
+                case Op::LH:  e.rm(false, {0x0F, 0xBF}, RAX, host); break;
+                case Op::LHU: e.rm(false, {0x0F, 0xB7}, RAX, host); break;
+                default:      e.rm(false, {0x8B}, RAX, host); break;
+            }
+            store_guest(rd, RAX);
+            break;
+        }
+        case Op::SB: case Op::SH: case Op::SW: {
+            const uint32_t size = d.op == Op::SW ? 4 : d.op == Op::SH ? 2 : 1;
+            address(d, size, offsetof(Ctx, store), idx);
+            load_guest(RAX, d.rs2);
+            if (size == 1) e.rm(false, {0x88}, RAX, host);
+            else e.rm(false, {0x89}, RAX, host, size == 2);
+            // задета страница с декодированным кодом (первый и последний байт) — выход
+            for (uint32_t edge : {0u, size - 1}) {
+                if (edge) e.rm(false, {0x8D}, RDX, {R15, static_cast<int32_t>(edge)});  // lea edx, [r15 + edge]
+                else e.rr(false, {0x89}, R15, RDX);                                    // mov edx, r15d
+                e.rr(false, {0xC1}, 5, RDX); e.byte(12);                               // страница
+                e.rr(false, {0x89}, RDX, RCX);
+                e.rr(false, {0xC1}, 5, RCX); e.byte(6);                                // слово карты
+                e.rm(true, {0x8B}, RCX, {R14, 0, RCX, 3});
+                e.rr(true, {0x0F, 0xA3}, RDX, RCX);                                    // bt rcx, rdx
+                stubs.push_back({e.jcc(CC_B), EXIT_SMC, d.pc + 4, len - idx - 1, size});
+                if (size == 1) break;
+            }
+            break;
+        }
+
+        case Op::JAL:
+            store_imm(rd, d.pc + 4);
+            direct_exit(d.imm);
+            ended = true;
+            break;
+        case Op::JALR: {
+            load_guest(RAX, d.rs1);
+            if (d.imm) alu_imm(0, d.imm);
+            alu_imm(4, ~1u);
+            store_imm(rd, d.pc + 4);
+            // таблица: [(pc >> 2) & (TABLE_SIZE - 1)] -> {pc, код}
+            e.rr(false, {0x89}, RAX, RDX);
+            e.rr(false, {0xC1}, 5, RDX); e.byte(2);
+            e.rr(false, {0x81}, 4, RDX); e.u32(TABLE_SIZE - 1);
+            e.rr(false, {0xC1}, 4, RDX); e.byte(4);
+            e.rm(true, {0x03}, RDX, field(offsetof(Ctx, table)));                     // add rdx, [table]
+            e.rm(false, {0x3B}, RAX, {RDX, 0});
+            uint8_t* miss = e.jcc(CC_NE);
+            e.rm(false, {0xFF}, 4, {RDX, 8});                                          // jmp [rdx + 8]
+            e.patch(miss, e.pos());
+            e.rm(false, {0x89}, RAX, field(offsetof(Ctx, pc)));
+            exit_to_epilogue(EXIT_INDIRECT);
+            ended = true;
+            break;
+        }
+        case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGE: case Op::BLTU: case Op::BGEU: {
+            const Cond c = d.op == Op::BEQ ? CC_E : d.op == Op::BNE ? CC_NE : d.op == Op::BLT ? CC_L
+                         : d.op == Op::BGE ? CC_GE : d.op == Op::BLTU ? CC_B : CC_AE;
+            load_guest(RAX, d.rs1);
+            e.rm(false, {0x3B}, RAX, guest(d.rs2));
+            uint8_t* taken = e.jcc(c);
+            direct_exit(d.pc + 4);
+            e.patch(taken, e.pos());
+            direct_exit(d.imm);
+            ended = true;
+            break;
+        }
+        default:
+            break; // HALT/ILLEGAL отсеяны выше
+        }
+    }
+    if (!ended) direct_exit(b.end_pc); // блок кончился без перехода
+
+    for (const Stub& s : stubs) {
+        e.patch(s.site, e.pos());
+        if (s.kind == EXIT_SMC) {
+            e.rm(false, {0x89}, R15, field(offsetof(Ctx, smc_addr)));
+            e.rm(false, {0xC7}, 0, field(offsetof(Ctx, smc_size))); e.u32(s.size);
+        }
+        // не выполненные инструкции блока возвращаются в остаток
+        if (s.refund) { e.rm(true, {0x81}, 0, field(offsetof(Ctx, left))); e.u32(s.refund); }
+        set_pc(s.pc);
+        exit_to_epilogue(s.kind);
+    }
+
+    emit_ = e.pos();
+    ++translated_;
+    if (b.start_pc != start_ra) { // адрес останова всегда проходит через диспетчер
+        auto& t = table_[(b.start_pc >> 2) & (TABLE_SIZE - 1)];
+        t = {b.start_pc, 0, entry};
+    }
+    return entry;
+}
+
+template <class Hooks>
+ExecResult DbtEngine::dispatch(CPU& cpu, Memory& mem, Hooks& hooks, uint32_t start_ra) {
+    const uint64_t max_steps = cpu.max_steps_;
+    const uint32_t mem_size = static_cast<uint32_t>(mem.size());
+    ctx_.x = cpu.x_;
+    ctx_.mem = mem.raw().data();
+    ctx_.code_pages = cpu.blocks_.code_page_bits();
+    ctx_.left = max_steps;
+    ctx_.hooks = &hooks;
+    ctx_.fetch = hook_fetch;
+    ctx_.load = hook_load;
+    ctx_.store = hook_store;
+    ctx_.table = table_.data();
+
+    ExecResult r;
+    r.final_pc = cpu.pc_;
+    uint32_t pc = cpu.pc_;
+    uint64_t generation = cpu.blocks_.generation();
+
+    // интерпретатором не больше n инструкций с pc
+    auto interpret = [&](uint64_t n) {
+        cpu.pc_ = pc;
+        cpu.max_steps_ = n;
+        ExecResult rr = cpu.run_impl(mem, hooks, start_ra);
+        cpu.max_steps_ = max_steps;
+        ctx_.left -= rr.steps;
+        pc = cpu.pc_;
+        return rr;
+    };
+    // итог как у одного прогона CPU::run_impl
+    auto finish = [&](ExecResult rr) {
+        rr.steps = max_steps - ctx_.left;
+        if (!rr.halted) rr.final_pc = r.final_pc;
+        return rr;
+    };
+    auto halted = [&] {
+        cpu.pc_ = pc;
+        ExecResult rr;
+        rr.halted = true;
+        rr.final_pc = pc;
+        return finish(rr);
+    };
+
+    for (;;) {
+        // страница кода выброшена (запись в код) — машинный код мог устареть
+        if (cpu.blocks_.generation() != generation) { flush(); generation = cpu.blocks_.generation(); }
+
+        const uint8_t* native = nullptr;
+        if (auto it = native_.find(pc); it != native_.end()) native = it->second;
+        else if (++heat_[pc] >= HOT_THRESHOLD) {
+            const Block* b = cpu.blocks_.get(pc, mem);
+            native = b ? translate(*b, start_ra, mem_size) : nullptr;
+            native_[pc] = native;
+        }
+
+        if (!native) { // холодный или непереводимый блок
+            const Block* b = cpu.blocks_.get(pc, mem);
+            const uint64_t n = b ? std::min<uint64_t>(ctx_.left, b->size()) : ctx_.left;
+            ExecResult rr = interpret(n);
+            if (!rr.step_limit || ctx_.left == 0) return finish(rr);
+            continue;
+        }
+
+        const uint32_t why = enter_(&ctx_, native);
+        pc = ctx_.pc;
+        switch (why) {
+            case EXIT_CHAIN:
+                if (auto it = native_.find(pc); it != native_.end() && it->second)
+                    Emitter::patch(writable(ctx_.patch), ctx_.patch, it->second);
+                [[fallthrough]];
+            case EXIT_JUMP:
+            case EXIT_INDIRECT:
+                if (pc == start_ra) return halted();
+                break;
+            case EXIT_SMC:
+                cpu.blocks_.invalidate(ctx_.smc_addr, ctx_.smc_size);
+                if (pc == start_ra) return halted();
+                break;
+            case EXIT_BUDGET: // блок не помещается: остаток прогона — интерпретатору
+                return finish(interpret(ctx_.left));
+            default: { // EXIT_FAULT
+                cpu.pc_ = pc;
+                ExecResult rr;
+                rr.ok = false;
+                return finish(rr);
+            }
+        }
+    }
+}
+
+ExecResult DbtEngine::run(CPU& cpu, Memory& mem, LRUCache* lru, BpLRUCache* bplru, uint32_t start_ra) {
+    if (!available() || mem.layout() != Memory::Layout::Flat) {
+        if (lru) return cpu.run(mem, *lru, *bplru, /*enable_bplru=*/true, start_ra);
+        return cpu.run(mem, start_ra);
+    }
+    cpu.blocks_.reset(start_ra);
+    heat_.clear();
+    stats_ = lru != nullptr;
+    flush(); // машинный код зависит от stats_ и адреса останова
+    if (stats_) {
+        CacheHooks hooks(*lru, *bplru);
+        return dispatch(cpu, mem, hooks, start_ra);
+    }
+    CacheList<> hooks;
+    return dispatch(cpu, mem, hooks, start_ra);
+}
+
+#else // нет x86-64: только интерпретатор
+
+DbtEngine::DbtEngine() {}
+DbtEngine::~DbtEngine() {}
+
+ExecResult DbtEngine::run(CPU& cpu, Memory& mem, LRUCache* lru, BpLRUCache* bplru, uint32_t start_ra) {
+    if (lru) return cpu.run(mem, *lru, *bplru, /*enable_bplru=*/true, start_ra);
+    return cpu.run(mem, start_ra);
+}
+
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "cache.hpp"
+#include "cpu.hpp"
+#include "memory.hpp"
+
+// Динамическая трансляция в x86-64 (только x86-64 Linux, Flat-память).
+// Буфер кода W^X: пишется через отдельное RW-отображение, исполняется из RX.
+//
+// Исполнение идёт по блокам BlockCache. Блок, исполненный HOT_THRESHOLD раз,
+// переводится в машинный код:
+//   - регистры RISC-V остаются в CPU::x_ и читаются/пишутся прямо из машинного кода;
+//   - переходы с известным адресом сцепляются: после первого выхода jmp в конце
+//     блока перенаправляется прямо на код следующего блока;
+//   - JALR ищет код адреса перехода в маленькой таблице, промах — выход в диспетчер;
+//   - со статистикой каждая выборка и обращение к данным вызывают модели кэша
+//     (CacheList<LRUCache, BpLRUCache>), без неё — только сама память.
+// Всё, что интерпретатор делает нетривиально, остаётся ему: холодные блоки,
+// блоки с ecall/ebreak и нелегальными инструкциями, хвост по MAX_STEPS, блок по
+// нечитаемому адресу. Запись в страницу с декодированным кодом выходит из блока,
+// выбрасывает страницу в BlockCache и весь машинный код. Результат (регистры,
+// память, счётчики кэшей, число инструкций) совпадает с CPU::run до бита.
+class DbtEngine {
+public:
+    static constexpr unsigned HOT_THRESHOLD = 16;
+
+    DbtEngine();
+    ~DbtEngine();
+    DbtEngine(const DbtEngine&) = delete;
+    DbtEngine& operator=(const DbtEngine&) = delete;
+
+    // Есть ли трансляция на этом хосте (x86-64 и удалось выделить исполняемую память)
+    bool available() const { return code_ != nullptr; }
+
+    // Как CPU::run; lru/bplru == nullptr — без моделей кэша. Без трансляции — просто CPU::run.
+    ExecResult run(CPU& cpu, Memory& mem, LRUCache* lru, BpLRUCache* bplru, uint32_t start_ra);
+
+    uint64_t translated_blocks() const { return translated_; }
+    uint64_t flushes() const { return flushes_; }
+
+    // Состояние, которое видит машинный код (смещения полей зашиты в него)
+    struct IndirectEntry { uint32_t pc; uint32_t pad; const uint8_t* code; };
+    struct Context {
+        uint32_t*       x;           // CPU::x_
+        uint8_t*        mem;         // Flat-память
+        const uint64_t* code_pages;  // BlockCache::code_page_bits()
+        uint64_t        left;        // сколько ещё инструкций можно выполнить
+        uint32_t        pc;          // pc на выходе в диспетчер
+        uint32_t        smc_addr;    // запись в код: адрес и размер
+        uint32_t        smc_size;
+        uint32_t        pad;
+        uint8_t*        patch;       // rel32 перехода, который можно сцепить
+        void*           hooks;       // CacheList<LRUCache, BpLRUCache>
+        void (*fetch)(void*, uint32_t);
+        void (*load)(void*, uint32_t, uint32_t);
+        void (*store)(void*, uint32_t, uint32_t);
+        IndirectEntry*  table;
+    };
+
+private:
+    static constexpr std::size_t CODE_SIZE  = std::size_t{32} << 20;
+    static constexpr std::size_t BLOCK_MAX_CODE = std::size_t{32} << 10; // с запасом на блок из 64 инструкций
+    static constexpr std::size_t TABLE_SIZE = 4096;
+
+    template <class Hooks>
+    ExecResult dispatch(CPU& cpu, Memory& mem, Hooks& hooks, uint32_t start_ra);
+
+    void flush();
+    const uint8_t* translate(const Block& b, uint32_t start_ra, uint32_t mem_size);
+    void emit_trampoline();
+    uint8_t* writable(const uint8_t* p) const; // адрес RX -> тот же байт в RW
+
+    uint8_t* code_ = nullptr;        // исполняемое отображение (RX)
+    uint8_t* wcode_ = nullptr;       // то же для записи (RW)
+    uint8_t* code_end_ = nullptr;    // после трамплина
+    uint8_t* emit_ = nullptr;        // куда пишется следующий блок
+    const uint8_t* epilogue_ = nullptr;
+    uint32_t (*enter_)(Context*, const uint8_t*) = nullptr;
+
+    bool stats_ = false;             // с вызовами моделей кэша
+    Context ctx_{};
+    std::vector<IndirectEntry> table_;
+    std::unordered_map<uint32_t, const uint8_t*> native_; // start_pc -> код (nullptr — не переводится)
+    std::unordered_map<uint32_t, unsigned> heat_;
+    uint64_t translated_ = 0, flushes_ = 0;
+};
@@ -0,0 +1,146 @@
+#include "decode.hpp"
+
+// ---- helpers (те же, что были в cpu.cpp) ----
+static inline uint32_t get_bits(uint32_t x, int hi, int lo) {
+    return (x >> lo) & ((1u << (hi - lo + 1)) - 1);
+}
+
+static inline uint32_t sext(uint32_t x, int bits) {
+    uint32_t m = 1u << (bits - 1);
+    return (x ^ m) - m;
+}
+
+static inline uint32_t imm_i(uint32_t insn) { return sext(get_bits(insn,31,20), 12); }
+static inline uint32_t imm_s(uint32_t insn) {
+    uint32_t v = (get_bits(insn,31,25) << 5) | get_bits(insn,11,7);
+    return sext(v, 12);
+}
+static inline uint32_t imm_b(uint32_t insn) {
+    uint32_t v = (get_bits(insn,31,31) << 12)
+               | (get_bits(insn,7,7)   << 11)
+               | (get_bits(insn,30,25) << 5)
+               | (get_bits(insn,11,8)  << 1);
+    return sext(v, 13);
+}
+static inline uint32_t imm_u(uint32_t insn) { return insn & 0xFFFFF000u; }
+static inline uint32_t imm_j(uint32_t insn) {
+    uint32_t v = (get_bits(insn,31,31) << 20)
+               | (get_bits(insn,19,12) << 12)
+               | (get_bits(insn,20,20) << 11)
+               | (get_bits(insn,30,21) << 1);
+    return sext(v, 21);
+}
+
+DecodedInsn decode(uint32_t instr, uint32_t pc) {
+    DecodedInsn d;
+    d.pc  = pc;
+    d.rd  = static_cast<uint8_t>(get_bits(instr, 11, 7));
+    d.rs1 = static_cast<uint8_t>(get_bits(instr, 19, 15));
+    d.rs2 = static_cast<uint8_t>(get_bits(instr, 24, 20));
+
+    const uint32_t opcode = get_bits(instr, 6, 0);
+    const uint32_t funct3 = get_bits(instr, 14, 12);
+    const uint32_t funct7 = get_bits(instr, 31, 25);
+
+    auto set = [&](Op op, uint32_t imm) { d.op = op; d.imm = imm; return d; };
+
+    switch (opcode) {
+        case 0x37: return set(Op::LUI, imm_u(instr));
+        case 0x17: return set(Op::AUIPC, imm_u(instr));
+        case 0x6F: return set(Op::JAL, pc + imm_j(instr));
+        case 0x67: return set(Op::JALR, imm_i(instr)); // funct3 не проверяется, как и раньше
+
+        case 0x63: { // BRANCH
+            uint32_t target = pc + imm_b(instr);
+            switch (funct3) {
+                case 0b000: return set(Op::BEQ,  target);
+                case 0b001: return set(Op::BNE,  target);
+                case 0b100: return set(Op::BLT,  target);
+                case 0b101: return set(Op::BGE,  target);
+                case 0b110: return set(Op::BLTU, target);
+                case 0b111: return set(Op::BGEU, target);
+                default: break;
+            }
+            break;
+        }
+
+        case 0x03: { // LOAD
+            uint32_t imm = imm_i(instr);
+            switch (funct3) {
+                case 0b000: return set(Op::LB,  imm);
+                case 0b001: return set(Op::LH,  imm);
+                case 0b010: return set(Op::LW,  imm);
+                case 0b100: return set(Op::LBU, imm);
+                case 0b101: return set(Op::LHU, imm);
+                default: break;
+            }
+            break;
+        }
+
+        case 0x23: { // STORE
+            uint32_t imm = imm_s(instr);
+            switch (funct3) {
+                case 0b000: return set(Op::SB, imm);
+                case 0b001: return set(Op::SH, imm);
+                case 0b010: return set(Op::SW, imm);
+                default: break;
+            }
+            break;
+        }
+
+        case 0x13: { // I-type ALU
+            uint32_t imm = imm_i(instr);
+            switch (funct3) {
+                case 0b000: return set(Op::ADDI,  imm);
+                case 0b010: return set(Op::SLTI,  imm);
+                case 0b011: return set(Op::SLTIU, imm);
+                case 0b100: return set(Op::XORI,  imm);
+                case 0b110: return set(Op::ORI,   imm);
+                case 0b111: return set(Op::ANDI,  imm);
+                case 0b001:
+                    if (funct7 == 0) return set(Op::SLLI, d.rs2); // shamt = bits 24..20
+                    break;
+                case 0b101:
+                    if (funct7 == 0b0000000) return set(Op::SRLI, d.rs2);
+                    if (funct7 == 0b0100000) return set(Op::SRAI, d.rs2);
+                    break;
+                default: break;
+            }
+            break;
+        }
+
+        case 0x33: { // R-type ALU / RV32M
+            if (funct7 == 0b0000001) {
+                static constexpr Op m_ops[8] = {
+                    Op::MUL, Op::MULH, Op::MULHSU, Op::MULHU, Op::DIV, Op::DIVU, Op::REM, Op::REMU
+                };
+                return set(m_ops[funct3], 0);
+            }
+            switch ((funct7 << 3) | funct3) {
+                case (0b0000000 << 3) | 0b000: return set(Op::ADD,  0);
+                case (0b0100000 << 3) | 0b000: return set(Op::SUB,  0);
+                case (0b0000000 << 3) | 0b111: return set(Op::AND,  0);
+                case (0b0000000 << 3) | 0b110: return set(Op::OR,   0);
+                case (0b0000000 << 3) | 0b100: return set(Op::XOR,  0);
+                case (0b0000000 << 3) | 0b001: return set(Op::SLL,  0);
+                case (0b0000000 << 3) | 0b101: return set(Op::SRL,  0);
+                case (0b0100000 << 3) | 0b101: return set(Op::SRA,  0);
+                case (0b0000000 << 3) | 0b010: return set(Op::SLT,  0);
+                case (0b0000000 << 3) | 0b011: return set(Op::SLTU, 0);
+                default: break;
+            }
+            break;
+        }
+
+        case 0x73: { // SYSTEM (ecall / ebreak)
+            uint32_t csr_imm = get_bits(instr, 31, 20);
+            if (funct3 == 0 && (csr_imm == 0 || csr_imm == 1)) return set(Op::HALT, 0);
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return set(Op::ILLEGAL, 0);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+
+// Список операций RV32IM после декодирования.
+// HALT — ecall/ebreak, ILLEGAL — всё, на чём CPU::run должен завершиться с ошибкой.
+#define RV_OPS(X) \
+    X(LUI)   X(AUIPC) X(JAL)   X(JALR)                                  \
+    X(BEQ)   X(BNE)   X(BLT)   X(BGE)   X(BLTU)  X(BGEU)                \
+    X(LB)    X(LH)    X(LW)    X(LBU)   X(LHU)                          \
+    X(SB)    X(SH)    X(SW)                                             \
+    X(ADDI)  X(SLTI)  X(SLTIU) X(XORI)  X(ORI)   X(ANDI)                \
+    X(SLLI)  X(SRLI)  X(SRAI)                                           \
+    X(ADD)   X(SUB)   X(SLL)   X(SLT)   X(SLTU)  X(XOR)                 \
+    X(SRL)   X(SRA)   X(OR)    X(AND)                                   \
+    X(MUL)   X(MULH)  X(MULHSU) X(MULHU) X(DIV)  X(DIVU)  X(REM) X(REMU) \
+    X(HALT)  X(ILLEGAL)
+
+enum class Op : uint8_t {
+#define RV_OP_ENUM(name) name,
+    RV_OPS(RV_OP_ENUM)
+#undef RV_OP_ENUM
+    // служебные: конец блока и исчерпание MAX_STEPS внутри блока
+    BLOCK_END,
+    STEP_LIMIT,
+    COUNT
+};
+
+// Инструкция с уже извлечёнными полями.
+// imm — знакорасширенный immediate; для JAL и ветвлений — сразу адрес перехода,
+// для сдвигов с immediate — shamt.
+struct DecodedInsn {
+    const void* handler = nullptr; // метка обработчика (threaded dispatch), см. cpu.cpp
+    uint32_t pc  = 0;
+    uint32_t imm = 0;
+    Op      op  = Op::ILLEGAL;
+    uint8_t rd  = 0;
+    uint8_t rs1 = 0;
+    uint8_t rs2 = 0;
+};
+
+DecodedInsn decode(uint32_t instr, uint32_t pc);
+
+// Передаёт ли инструкция управление (после неё блок заканчивается)
+inline bool ends_block(Op op) {
+    switch (op) {
+        case Op::JAL: case Op::JALR:
+        case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGE: case Op::BLTU: case Op::BGEU:
+        case Op::HALT: case Op::ILLEGAL:
+            return true;
+        default:
+            return false;
+    }
+}
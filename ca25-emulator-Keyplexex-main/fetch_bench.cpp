@@ -0,0 +1,85 @@
+// fetch_bench.cpp — микробенчмарк выборки инструкций из Memory.
+// Сравнивает побайтную сборку слова (как было), read_u32 и чтение через host_span
+// для обеих раскладок памяти. Печатает миллионы 32-битных выборок в секунду.
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include "memory.hpp"
+
+namespace {
+
+constexpr uint32_t    CODE_BASE  = 0x1000;
+constexpr std::size_t CODE_BYTES = 64 * 1024;   // «программа», которую выбираем по кругу
+constexpr std::size_t FETCHES    = 200'000'000;
+
+// старая реализация read_u32: проверка и сборка по байтам
+bool read_u32_bytewise(const std::vector<uint8_t>& ram, uint32_t addr, uint32_t& v) {
+    if (addr+3 >= ram.size()) return false;
+    v =  static_cast<uint32_t>(ram[addr])
+       | (static_cast<uint32_t>(ram[addr+1])<<8)
+       | (static_cast<uint32_t>(ram[addr+2])<<16)
+       | (static_cast<uint32_t>(ram[addr+3])<<24);
+    return true;
+}
+
+constexpr std::size_t BLOCK_LEN = 64;           // как BlockCache::MAX_BLOCK_LEN
+
+// fetch_block(pc) выбирает BLOCK_LEN слов подряд с pc и возвращает их сумму
+template <class F>
+void bench(const char* name, F&& fetch_block) {
+    const auto t0 = std::chrono::steady_clock::now();
+    uint32_t acc = 0;
+    for (std::size_t i = 0; i < FETCHES; i += BLOCK_LEN) {
+        const uint32_t pc = CODE_BASE + static_cast<uint32_t>((i * 4) % CODE_BYTES);
+        acc += fetch_block(pc);
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    const double sec = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("%-22s\t%8.1f Mfetch/s\t(checksum %08x)\n", name, FETCHES / sec / 1e6, acc);
+}
+
+// по слову через функцию чтения
+template <class Read>
+auto per_word(Read&& read) {
+    return [read](uint32_t pc) {
+        uint32_t sum = 0;
+        for (std::size_t k = 0; k < BLOCK_LEN; ++k) { uint32_t v = 0; read(pc + 4 * k, v); sum += v; }
+        return sum;
+    };
+}
+
+}
+
+int main() {
+    std::vector<uint8_t> code(CODE_BYTES);
+    for (std::size_t i = 0; i < code.size(); ++i) code[i] = static_cast<uint8_t>(i * 37 + 11);
+
+    Memory flat(Memory::Layout::Flat);
+    Memory paged(Memory::Layout::Paged);
+    flat.load_frag(CODE_BASE, code);
+    paged.load_frag(CODE_BASE, code);
+
+    std::vector<uint8_t> ram(flat.raw().begin(), flat.raw().end());
+    bench("flat bytewise (old)", per_word([&](uint32_t pc, uint32_t& v) { read_u32_bytewise(ram, pc, v); }));
+    bench("flat read_u32",       per_word([&](uint32_t pc, uint32_t& v) { flat.read_u32(pc, v); }));
+    bench("paged read_u32",      per_word([&](uint32_t pc, uint32_t& v) { paged.read_u32(pc, v); }));
+
+    // как BlockCache::build: одна проверка на блок, дальше чтение по указателю хоста
+    auto span_block = [](const Memory& mem) {
+        return [&mem](uint32_t pc) {
+            const auto code = mem.host_span(pc, BLOCK_LEN * 4);
+            uint32_t sum = 0;
+            for (std::size_t k = 0; k < BLOCK_LEN; ++k) {
+                uint32_t v = 0;
+                if (4 * k + 4 <= code.size()) v = load_le<uint32_t>(code.data() + 4 * k);
+                else mem.read_u32(pc + static_cast<uint32_t>(4 * k), v);
+                sum += v;
+            }
+            return sum;
+        };
+    };
+    bench("flat host_span",  span_block(flat));
+    bench("paged host_span", span_block(paged));
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "hierarchy.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+std::size_t kind_index(AccessKind k) { return k == AccessKind::Inst ? 0 : 1; }
+
+}
+
+CacheHierarchy::CacheHierarchy(const Config& c)
+    : l1i_(c.l1i), l1d_(c.l1d), l2_(c.l2), dram_latency_(c.dram_latency) {}
+
+CacheHierarchy::Lookup CacheHierarchy::lookup(Level& lv, uint32_t addr, bool is_write, AccessKind k) {
+    return std::visit([&](auto& cache) {
+        const bool hit = is_write ? cache.write(addr, 1, k) : cache.read(addr, 1, k);
+        return Lookup{hit, hit ? CacheModel<DynamicGeometry>::Eviction{} : cache.last_eviction()};
+    }, lv.cache);
+}
+
+bool CacheHierarchy::access(uint32_t addr, AccessKind k, bool is_write) {
+    Level& l1 = k == AccessKind::Inst ? l1i_ : l1d_;
+    const uint32_t base = addr & ~(l1.line() - 1);
+
+    uint64_t cycles = l1.cfg.latency;
+    const Lookup r = lookup(l1, addr, is_write, k);
+    l1.accesses++;
+    if (r.hit) {
+        l1.hits++;
+    } else {
+        l1.fill_bytes += l1.line();
+        cycles += l2_access(base, l1.line(), /*is_writeback=*/false, k);
+        if (r.evicted.dirty) {
+            l1.writeback_bytes += l1.line();
+            l2_access(r.evicted.addr, l1.line(), /*is_writeback=*/true, AccessKind::Data);
+        }
+    }
+
+    const std::size_t ki = kind_index(k);
+    accesses_[ki]++;
+    cycles_[ki] += cycles;
+    last_cycles_[ki] = cycles;
+    return r.hit;
+}
+
+uint64_t CacheHierarchy::l2_access(uint32_t line_addr, uint32_t size, bool is_writeback, AccessKind k) {
+    // линия L1 может занимать несколько линий L2 (и наоборот); части идут параллельно
+    uint64_t worst = 0;
+    const uint32_t step = std::min(size, l2_.line());
+    for (uint32_t off = 0; off < size; off += step) {
+        uint64_t cycles = l2_.cfg.latency;
+        const Lookup r = lookup(l2_, line_addr + off, is_writeback, k);
+        if (is_writeback) l2_.writebacks_in++;
+        else { l2_.accesses++; if (r.hit) l2_.hits++; }
+
+        if (!r.hit) {
+            // write-allocate: и при write-back линия сначала читается из DRAM
+            l2_.fill_bytes += l2_.line();
+            dram_read_bytes_ += l2_.line();
+            cycles += dram_latency_;
+            if (r.evicted.dirty) {
+                l2_.writeback_bytes += l2_.line();
+                dram_write_bytes_ += l2_.line();
+            }
+        }
+        worst = std::max(worst, cycles);
+    }
+    return is_writeback ? 0 : worst;
+}
+
+double CacheHierarchy::amat(AccessKind k) const {
+    const std::size_t ki = kind_index(k);
+    return accesses_[ki] ? static_cast<double>(cycles_[ki]) / accesses_[ki]
+                         : std::numeric_limits<double>::quiet_NaN();
+}
+
+double CacheHierarchy::amat() const {
+    const uint64_t n = accesses_[0] + accesses_[1];
+    return n ? static_cast<double>(cycles_[0] + cycles_[1]) / n : std::numeric_limits<double>::quiet_NaN();
+}
+
+uint64_t CacheHierarchy::stall_cycles(AccessKind k) const {
+    const std::size_t ki = kind_index(k);
+    const Level& l1 = k == AccessKind::Inst ? l1i_ : l1d_;
+    return cycles_[ki] - accesses_[ki] * l1.cfg.latency;
+}
+
+void CacheHierarchy::report(std::FILE* out) const {
+    std::fprintf(out, "\ncache hierarchy\n");
+    std::fprintf(out, "level\treplacement\tsets\tways\tline\tlatency\taccesses\thit rate\tfill bytes\twriteback bytes\n");
+
+    auto level = [&](const char* name, const Level& lv) {
+        std::fprintf(out, "%5s\t%11s\t%zu\t%zu\t%zu\t%u\t%llu\t", name, policy_name(lv.cfg.policy),
+                     lv.cfg.sets, lv.cfg.ways, lv.cfg.line, lv.cfg.latency,
+                     static_cast<unsigned long long>(lv.accesses));
+        if (lv.accesses == 0) std::fprintf(out, "nan%%");
+        else std::fprintf(out, "%3.5f%%", 100.0 * lv.hits / lv.accesses);
+        std::fprintf(out, "\t%llu\t%llu\n", static_cast<unsigned long long>(lv.fill_bytes),
+                     static_cast<unsigned long long>(lv.writeback_bytes));
+    };
+    level("L1I", l1i_);
+    level("L1D", l1d_);
+    level("L2", l2_);
+    std::fprintf(out, "%5s\t%11s\t-\t-\t-\t%u\t-\t-\t%llu\t%llu\n", "DRAM", "-", dram_latency_,
+                 static_cast<unsigned long long>(dram_read_bytes_),
+                 static_cast<unsigned long long>(dram_write_bytes_));
+    std::fprintf(out, "L2 writebacks received\t%llu\n", static_cast<unsigned long long>(l2_.writebacks_in));
+
+    const uint64_t si = stall_cycles(AccessKind::Inst), sd = stall_cycles(AccessKind::Data);
+    std::fprintf(out, "memory stall cycles\t%llu\t(inst %llu, data %llu)\n",
+                 static_cast<unsigned long long>(si + sd),
+                 static_cast<unsigned long long>(si), static_cast<unsigned long long>(sd));
+    std::fprintf(out, "AMAT\t%.4f\t(inst %.4f, data %.4f) cycles\n",
+                 amat(), amat(AccessKind::Inst), amat(AccessKind::Data));
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include "cache.hpp"
+#include "cache_config.hpp"
+
+// Двухуровневая иерархия: раздельные L1I/L1D, общий L2, за ним DRAM.
+// Все уровни write-back + write-allocate, L2 не инклюзивный. Задержки простые:
+// обращение стоит latency L1, промах добавляет latency L2, промах L2 — ещё DRAM.
+// Write-back грязных линий уходит в буфер записи и такты не добавляет, но
+// трафик между уровнями (заполнения и write-back) считается в байтах.
+//
+// Подключается как ещё одна модель в CacheList.
+class CacheHierarchy {
+public:
+    struct Config {
+        CacheConfig l1i{Policy::LRU, CACHE_SET_COUNT, CACHE_WAY, CACHE_LINE_SIZE, 1};
+        CacheConfig l1d{Policy::LRU, CACHE_SET_COUNT, CACHE_WAY, CACHE_LINE_SIZE, 1};
+        CacheConfig l2 {Policy::LRU, 256, 8, 64, 10};
+        unsigned dram_latency = 100;
+    };
+
+    explicit CacheHierarchy(const Config& c);
+
+    bool read (uint32_t addr, std::size_t /*size*/, AccessKind k) { return access(addr, k, false); }
+    bool write(uint32_t addr, std::size_t /*size*/, AccessKind k) { return access(addr, k, true); }
+
+    // такты на все обращения / обращения — по виду
+    double amat(AccessKind k) const;
+    double amat() const;
+    // такты сверх попадания в L1
+    uint64_t stall_cycles(AccessKind k) const;
+
+    // такты последнего обращения данного вида и задержка попадания в L1 (для конвейера)
+    uint64_t last_cycles(AccessKind k) const { return last_cycles_[k == AccessKind::Inst ? 0 : 1]; }
+    unsigned l1_latency(AccessKind k) const { return (k == AccessKind::Inst ? l1i_ : l1d_).cfg.latency; }
+
+    void report(std::FILE* out) const;
+
+private:
+    struct Level {
+        CacheConfig  cfg;
+        DynamicCache cache;
+        uint64_t accesses = 0, hits = 0; // обращения по требованию
+        uint64_t writebacks_in = 0;      // линии, принятые сверху при write-back
+        uint64_t fill_bytes = 0;         // пришло снизу при промахах
+        uint64_t writeback_bytes = 0;    // ушло вниз при вытеснении грязных линий
+
+        explicit Level(const CacheConfig& c) : cfg(c), cache(make_cache(c)) {}
+        uint32_t line() const { return static_cast<uint32_t>(cfg.line); }
+    };
+
+    struct Lookup { bool hit; CacheModel<DynamicGeometry>::Eviction evicted; };
+    static Lookup lookup(Level& lv, uint32_t addr, bool is_write, AccessKind k);
+
+    bool access(uint32_t addr, AccessKind k, bool is_write);
+    // обращение к L2 за линией L1 (или write-back её в L2); возвращает такты
+    uint64_t l2_access(uint32_t line_addr, uint32_t size, bool is_writeback, AccessKind k);
+
+    Level l1i_, l1d_, l2_;
+    unsigned dram_latency_;
+    uint64_t dram_read_bytes_ = 0, dram_write_bytes_ = 0;
+
+    uint64_t accesses_[2] = {0, 0};
+    uint64_t cycles_[2]   = {0, 0};
+    uint64_t last_cycles_[2] = {0, 0};
+};
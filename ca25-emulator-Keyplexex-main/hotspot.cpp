@@ -0,0 +1,172 @@
+#include "hotspot.hpp"
+#include <algorithm>
+
+namespace {
+
+// классы инструкций для гистограммы
+enum class OpClass { Alu, AluImm, Upper, Load, Store, Branch, Jump, Mul, Div, System, COUNT };
+
+OpClass op_class(Op op) {
+    switch (op) {
+        case Op::LUI: case Op::AUIPC: return OpClass::Upper;
+        case Op::JAL: case Op::JALR: return OpClass::Jump;
+        case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGE: case Op::BLTU: case Op::BGEU:
+            return OpClass::Branch;
+        case Op::LB: case Op::LH: case Op::LW: case Op::LBU: case Op::LHU: return OpClass::Load;
+        case Op::SB: case Op::SH: case Op::SW: return OpClass::Store;
+        case Op::ADDI: case Op::SLTI: case Op::SLTIU: case Op::XORI: case Op::ORI: case Op::ANDI:
+        case Op::SLLI: case Op::SRLI: case Op::SRAI:
+            return OpClass::AluImm;
+        case Op::MUL: case Op::MULH: case Op::MULHSU: case Op::MULHU: return OpClass::Mul;
+        case Op::DIV: case Op::DIVU: case Op::REM: case Op::REMU: return OpClass::Div;
+        case Op::HALT: case Op::ILLEGAL: case Op::BLOCK_END: case Op::STEP_LIMIT: case Op::COUNT:
+            return OpClass::System;
+        default:
+            return OpClass::Alu;
+    }
+}
+
+const char* class_name(OpClass c) {
+    static const char* names[] = {"alu", "alu-imm", "lui/auipc", "load", "store", "branch", "jump", "mul", "div", "system"};
+    return names[static_cast<std::size_t>(c)];
+}
+
+}
+
+HotspotProfiler::HotspotProfiler(const LRUCache& lru, const BpLRUCache& bplru, uint32_t entry_pc)
+    : lru_(lru), bplru_(bplru) {
+    // модели могли уже что-то насчитать (продолжение со снимка)
+    seen_imiss_[LRU] = lru.stats().misses_inst;   seen_dmiss_[LRU] = lru.stats().misses_data;
+    seen_imiss_[BPLRU] = bplru.stats().misses_inst; seen_dmiss_[BPLRU] = bplru.stats().misses_data;
+    nodes_.push_back({0, entry_pc});
+    stack_.push_back(0);
+}
+
+HotspotProfiler::PcStats& HotspotProfiler::stats_for(uint32_t pc) {
+    const uint32_t key = pc >> CHUNK_SHIFT;
+    if (!last_chunk_ || key != last_chunk_key_) {
+        auto& c = chunks_[key];
+        if (!c) c = std::make_unique<Chunk>();
+        last_chunk_ = c.get();
+        last_chunk_key_ = key;
+    }
+    return last_chunk_->pcs[(pc & ((1u << CHUNK_SHIFT) - 1)) >> 2];
+}
+
+void HotspotProfiler::access(uint32_t addr, std::size_t /*size*/, AccessKind k) {
+    const CacheStats& a = lru_.stats();
+    const CacheStats& b = bplru_.stats();
+    if (k == AccessKind::Inst) {
+        cur_ = &stats_for(addr);
+        cur_->imiss[LRU]   += a.misses_inst - seen_imiss_[LRU];
+        cur_->imiss[BPLRU] += b.misses_inst - seen_imiss_[BPLRU];
+        seen_imiss_[LRU] = a.misses_inst;
+        seen_imiss_[BPLRU] = b.misses_inst;
+    } else if (cur_) {
+        cur_->dmiss[LRU]   += a.misses_data - seen_dmiss_[LRU];
+        cur_->dmiss[BPLRU] += b.misses_data - seen_dmiss_[BPLRU];
+        seen_dmiss_[LRU] = a.misses_data;
+        seen_dmiss_[BPLRU] = b.misses_data;
+    }
+}
+
+uint32_t HotspotProfiler::child(uint32_t node, uint32_t func) {
+    const uint64_t key = (static_cast<uint64_t>(node) << 32) | func;
+    auto it = children_.find(key);
+    if (it != children_.end()) return it->second;
+    const uint32_t id = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back({node, func});
+    children_.emplace(key, id);
+    return id;
+}
+
+void HotspotProfiler::retire(const DecodedInsn& d, uint32_t next_pc) {
+    PcStats& s = cur_ ? *cur_ : stats_for(d.pc);
+    s.insns++;
+    s.func = nodes_[node_].func;
+    nodes_[node_].insns++;
+    mix_[static_cast<std::size_t>(d.op)]++;
+
+    switch (d.op) {
+        case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGE: case Op::BLTU: case Op::BGEU:
+            if (next_pc != d.pc + 4) s.taken++;
+            break;
+        case Op::JAL:
+        case Op::JALR:
+            s.taken++;
+            if (d.rd == 1) {                                      // вызов
+                node_ = child(node_, next_pc);
+                stack_.push_back(node_);
+            } else if (d.op == Op::JALR && d.rd == 0 && d.rs1 == 1 && stack_.size() > 1) { // возврат
+                stack_.pop_back();
+                node_ = stack_.back();
+            }
+            break;
+        default:
+            break;
+    }
+    cur_ = nullptr;
+}
+
+void HotspotProfiler::report(std::FILE* out, std::size_t top) const {
+    struct Row { uint32_t pc; const PcStats* s; };
+    std::vector<Row> rows;
+    uint64_t total = 0;
+    for (const auto& [key, chunk] : chunks_) {
+        for (uint32_t i = 0; i < (1u << (CHUNK_SHIFT - 2)); ++i) {
+            const PcStats& s = chunk->pcs[i];
+            if (s.insns == 0 && s.imiss[LRU] == 0 && s.imiss[BPLRU] == 0) continue;
+            rows.push_back({(key << CHUNK_SHIFT) | (i << 2), &s});
+            total += s.insns;
+        }
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+        if (a.s->insns != b.s->insns) return a.s->insns > b.s->insns;
+        return a.pc < b.pc;
+    });
+
+    std::fprintf(out, "\nhot spots (top %zu of %zu instructions)\n", std::min(top, rows.size()), rows.size());
+    std::fprintf(out, "pc\tfunction\tcount\tshare\timiss LRU\timiss bpLRU\tdmiss LRU\tdmiss bpLRU\ttaken\n");
+    for (std::size_t i = 0; i < rows.size() && i < top; ++i) {
+        const PcStats& s = *rows[i].s;
+        std::fprintf(out, "0x%08x\t0x%08x\t%llu\t%3.5f%%\t%llu\t%llu\t%llu\t%llu\t%llu\n",
+                     rows[i].pc, s.func, static_cast<unsigned long long>(s.insns),
+                     total ? 100.0 * s.insns / total : 0.0,
+                     static_cast<unsigned long long>(s.imiss[LRU]), static_cast<unsigned long long>(s.imiss[BPLRU]),
+                     static_cast<unsigned long long>(s.dmiss[LRU]), static_cast<unsigned long long>(s.dmiss[BPLRU]),
+                     static_cast<unsigned long long>(s.taken));
+    }
+
+    uint64_t mix[static_cast<std::size_t>(OpClass::COUNT)] = {};
+    for (std::size_t op = 0; op < static_cast<std::size_t>(Op::COUNT); ++op)
+        mix[static_cast<std::size_t>(op_class(static_cast<Op>(op)))] += mix_[op];
+
+    std::fprintf(out, "\ninstruction mix\n");
+    std::fprintf(out, "class\tcount\tshare\n");
+    for (std::size_t c = 0; c < static_cast<std::size_t>(OpClass::COUNT); ++c) {
+        if (mix[c] == 0) continue;
+        std::fprintf(out, "%s\t%llu\t%3.5f%%\n", class_name(static_cast<OpClass>(c)),
+                     static_cast<unsigned long long>(mix[c]), total ? 100.0 * mix[c] / total : 0.0);
+    }
+}
+
+bool HotspotProfiler::write_collapsed(const std::string& path, std::string& err) const {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) { err = "cannot open " + path; return false; }
+
+    std::vector<uint32_t> path_funcs;
+    for (uint32_t id = 0; id < nodes_.size(); ++id) {
+        if (nodes_[id].insns == 0) continue;
+        path_funcs.clear();
+        for (uint32_t n = id; ; n = nodes_[n].parent) {
+            path_funcs.push_back(nodes_[n].func);
+            if (n == 0) break;
+        }
+        for (std::size_t i = path_funcs.size(); i-- > 0; )
+            std::fprintf(f, i + 1 == path_funcs.size() ? "0x%08x" : ";0x%08x", path_funcs[i]);
+        std::fprintf(f, " %llu\n", static_cast<unsigned long long>(nodes_[id].insns));
+    }
+
+    if (std::fclose(f) != 0) { err = "error writing " + path; return false; }
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cache.hpp"
+#include "decode.hpp"
+
+// Профиль по адресам инструкций: сколько раз выполнена, промахи I/D-кэша в LRU и
+// bpLRU, взятые переходы. Промахи берутся из основных моделей (смотрим на прирост
+// их счётчиков), поэтому в CacheList профилировщик должен идти после них.
+// JAL/JALR с rd == ra ведут теневой стек вызовов (функция = адрес входа), по нему
+// собираются свёрнутые стеки для flamegraph.pl и подобных.
+class HotspotProfiler {
+public:
+    HotspotProfiler(const LRUCache& lru, const BpLRUCache& bplru, uint32_t entry_pc);
+
+    bool read (uint32_t addr, std::size_t size, AccessKind k) { access(addr, size, k); return true; }
+    bool write(uint32_t addr, std::size_t size, AccessKind k) { access(addr, size, k); return true; }
+    void retire(const DecodedInsn& d, uint32_t next_pc);
+
+    // top самых частых инструкций и гистограмма классов инструкций
+    void report(std::FILE* out, std::size_t top) const;
+    // "f1;f2;f3 count" — по строке на стек
+    bool write_collapsed(const std::string& path, std::string& err) const;
+
+private:
+    enum Policy { LRU, BPLRU, POLICIES };
+
+    struct PcStats {
+        uint64_t insns = 0;
+        uint64_t imiss[POLICIES] = {};
+        uint64_t dmiss[POLICIES] = {};
+        uint64_t taken = 0;
+        uint32_t func = 0;   // функция, в которой инструкция выполнялась последний раз
+    };
+
+    // счётчики по pc лежат кусками по 1024 инструкции (4 КиБ кода)
+    static constexpr unsigned CHUNK_SHIFT = 12;
+    struct Chunk { PcStats pcs[1u << (CHUNK_SHIFT - 2)]; };
+    PcStats& stats_for(uint32_t pc);
+
+    void access(uint32_t addr, std::size_t size, AccessKind k);
+
+    // узел дерева стеков: (родитель, функция)
+    struct StackNode { uint32_t parent; uint32_t func; uint64_t insns = 0; };
+    uint32_t child(uint32_t node, uint32_t func);
+
+    const LRUCache& lru_;
+    const BpLRUCache& bplru_;
+    uint64_t seen_imiss_[POLICIES] = {}, seen_dmiss_[POLICIES] = {};
+
+    std::unordered_map<uint32_t, std::unique_ptr<Chunk>> chunks_;
+    uint32_t last_chunk_key_ = 0;
+    Chunk*   last_chunk_ = nullptr;
+    PcStats* cur_ = nullptr;   // инструкция, которая сейчас выполняется (по последней выборке)
+
+    std::vector<StackNode> nodes_;                       // 0 — корень (точка входа)
+    std::unordered_map<uint64_t, uint32_t> children_;    // (узел << 32 | функция) -> узел
+    std::vector<uint32_t> stack_;                        // путь от корня, узлы
+    uint32_t node_ = 0;
+
+    uint64_t mix_[static_cast<std::size_t>(Op::COUNT)] = {};
+};
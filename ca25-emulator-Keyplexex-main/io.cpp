@@ -1,50 +1,120 @@
 #include "io.hpp"
+#include <algorithm>
+#include <climits>
 #include <cstdio>
 #include <cstring>
-#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "memory.hpp"
 
-static bool read_exact(FILE* f, void* buf, size_t n) {
-    return std::fread(buf, 1, n, f) == n;
+InputImage::~InputImage() {
+    if (map_) munmap(const_cast<uint8_t*>(map_), map_size_);
 }
-static bool write_exact(FILE* f, const void* buf, size_t n) {
-    return std::fwrite(buf, 1, n, f) == n;
+
+InputImage::InputImage(InputImage&& o) noexcept
+    : frags(std::move(o.frags)), map_(o.map_), map_size_(o.map_size_), owned_(std::move(o.owned_)) {
+    std::memcpy(regs, o.regs, sizeof(regs));
+    o.map_ = nullptr;
+    o.map_size_ = 0;
+}
+
+static bool read_all(int fd, std::vector<uint8_t>& out) {
+    uint8_t buf[1 << 16];
+    for (;;) {
+        const ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n < 0) return false;
+        if (n == 0) return true;
+        out.insert(out.end(), buf, buf + n);
+    }
 }
 
 std::optional<InputImage> read_input_file(const std::string& path, std::string& err) {
-    InputImage img{};
-    FILE* f = std::fopen(path.c_str(), "rb");
-    if (!f) { err = "failed to open input file"; return std::nullopt; }
-
-    if (!read_exact(f, img.regs, 32u*4u)) { err = "truncated header"; std::fclose(f); return std::nullopt; }
-
-    // Читаем фрагменты: [addr:4][size:4][data:N] пока не EOF
-    while (true) {
-        uint32_t addr=0, size=0;
-        size_t read1 = std::fread(&addr, 1, 4, f);
-        if (read1 == 0) break;
-        if (read1 != 4) { err = "truncated fragment header"; std::fclose(f); return std::nullopt; }
-        if (!read_exact(f, &size, 4)) { err = "truncated fragment header"; std::fclose(f); return std::nullopt; }
-        InputImage::Frag fr; fr.addr = addr; fr.data.resize(size);
-        if (!read_exact(f, fr.data.data(), size)) { err = "truncated fragment data"; std::fclose(f); return std::nullopt; }
-        img.frags.push_back(std::move(fr));
+    InputImage img;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { err = "failed to open input file"; return std::nullopt; }
+
+    // обычный непустой файл — mmap, иначе читаем целиком
+    struct stat st{};
+    const uint8_t* p = nullptr;
+    std::size_t n = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* m = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            img.map_ = static_cast<const uint8_t*>(m);
+            img.map_size_ = static_cast<std::size_t>(st.st_size);
+            madvise(m, img.map_size_, MADV_SEQUENTIAL);
+            p = img.map_; n = img.map_size_;
+        }
+    }
+    if (!p) {
+        if (!read_all(fd, img.owned_)) { ::close(fd); err = "failed to read input file"; return std::nullopt; }
+        p = img.owned_.data(); n = img.owned_.size();
     }
+    ::close(fd);
+
+    if (n < 32u*4u) { err = "truncated header"; return std::nullopt; }
+    for (int i = 0; i < 32; ++i) img.regs[i] = load_le<uint32_t>(p + 4 * i);
 
-    std::fclose(f);
+    // Фрагменты: [addr:4][size:4][data:N] до конца файла
+    std::size_t pos = 32u*4u;
+    while (pos < n) {
+        if (n - pos < 8) { err = "truncated fragment header"; return std::nullopt; }
+        const uint32_t addr = load_le<uint32_t>(p + pos);
+        const uint32_t size = load_le<uint32_t>(p + pos + 4);
+        pos += 8;
+        if (n - pos < size) { err = "truncated fragment data"; return std::nullopt; }
+        img.frags.push_back({addr, {p + pos, size}});
+        pos += size;
+    }
     return img;
 }
 
-bool write_output_file(const std::string& path, const OutputImage& out, std::string& err) {
-    FILE* f = std::fopen(path.c_str(), "wb");
-    if (!f) { err = "failed to open output file"; return false; }
+// writev до конца, с учётом частичной записи и лимита IOV_MAX
+static bool write_all(int fd, std::vector<iovec>& iov) {
+    std::size_t i = 0;
+    while (i < iov.size()) {
+        const int cnt = static_cast<int>(std::min<std::size_t>(iov.size() - i, IOV_MAX));
+        ssize_t n = ::writev(fd, &iov[i], cnt);
+        if (n < 0) return false;
+        while (n > 0 && i < iov.size()) {
+            const std::size_t step = std::min<std::size_t>(static_cast<std::size_t>(n), iov[i].iov_len);
+            iov[i].iov_base = static_cast<uint8_t*>(iov[i].iov_base) + step;
+            iov[i].iov_len -= step;
+            n -= static_cast<ssize_t>(step);
+            if (iov[i].iov_len == 0) ++i;
+        }
+        while (i < iov.size() && iov[i].iov_len == 0) ++i;
+    }
+    return true;
+}
+
+bool write_output_file(const std::string& path, const uint32_t regs[32],
+                       const Memory& mem, uint32_t start, uint32_t size, std::string& err) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) { err = "failed to open output file"; return false; }
 
-    if (!write_exact(f, out.regs, 32u*4u)) { err = "failed to write header"; std::fclose(f); return false; }
+    uint8_t header[32u*4u + 8];
+    for (int i = 0; i < 32; ++i) store_le<uint32_t>(header + 4 * i, regs[i]);
+    store_le<uint32_t>(header + 128, start);
+    store_le<uint32_t>(header + 132, size);
 
-    uint32_t addr = out.start_addr;
-    uint32_t size = static_cast<uint32_t>(out.mem.size());
-    if (!write_exact(f, &addr, 4) || !write_exact(f, &size, 4)) { err = "failed to write fragment header"; std::fclose(f); return false; }
-    if (size && !write_exact(f, out.mem.data(), size)) { err = "failed to write fragment data"; std::fclose(f); return false; }
+    // куски памяти как есть; невыделенные страницы (Paged) — из общей нулевой страницы
+    static const uint8_t zero_page[Memory::PAGE_SIZE] = {};
+    std::vector<iovec> iov{{header, sizeof(header)}};
+    for (uint64_t addr = start, left = size; left > 0; ) {
+        std::span<const uint8_t> s = mem.host_span(static_cast<uint32_t>(addr), static_cast<std::size_t>(left));
+        if (s.empty())
+            s = {zero_page, std::min<std::size_t>(left, Memory::PAGE_SIZE - (addr & (Memory::PAGE_SIZE - 1)))};
+        iov.push_back({const_cast<uint8_t*>(s.data()), s.size()});
+        addr += s.size();
+        left -= s.size();
+    }
 
-    std::fclose(f);
+    const bool ok = write_all(fd, iov);
+    if (::close(fd) != 0 || !ok) { err = "failed to write output file"; return false; }
     return true;
 }
 
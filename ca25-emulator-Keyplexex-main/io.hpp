@@ -1,22 +1,41 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <optional>
+#include <span>
 
-struct InputImage {
-    uint32_t regs[32]; 
-    struct Frag { uint32_t addr; std::vector<uint8_t> data; };
+class Memory;
+
+// Входной образ. Файл отображается в память (mmap), фрагменты смотрят прямо в него
+// и копируются в Memory один раз (load_frag). Живёт, пока нужны фрагменты.
+class InputImage {
+public:
+    struct Frag { uint32_t addr; std::span<const uint8_t> data; };
+
+    uint32_t regs[32]{};
     std::vector<Frag> frags;
-};
 
-struct OutputImage {
-    uint32_t regs[32];
-    uint32_t start_addr = 0;
-    std::vector<uint8_t> mem;
+    InputImage() = default;
+    ~InputImage();
+    InputImage(InputImage&& o) noexcept;
+    InputImage& operator=(InputImage&&) = delete;
+    InputImage(const InputImage&) = delete;
+
+private:
+    friend std::optional<InputImage> read_input_file(const std::string& path, std::string& err);
+
+    const uint8_t* map_ = nullptr;   // mmap файла
+    std::size_t map_size_ = 0;
+    std::vector<uint8_t> owned_;     // если mmap не вышел (канал и т.п.) — файл прочитан сюда
 };
 
 std::optional<InputImage> read_input_file(const std::string& path, std::string& err);
-bool write_output_file(const std::string& path, const OutputImage& out, std::string& err);
+
+// Регистры и срез памяти [start, start+size): данные пишутся прямо из Memory
+// (writev по её кускам), без промежуточного буфера. Диапазон уже проверен вызывающим.
+bool write_output_file(const std::string& path, const uint32_t regs[32],
+                       const Memory& mem, uint32_t start, uint32_t size, std::string& err);
 
 bool parse_u32(const char* s, uint32_t& out);
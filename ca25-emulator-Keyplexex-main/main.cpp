@@ -12,12 +12,43 @@
 #include "memory.hpp"
 #include "cache.hpp"
 #include "cpu.hpp"
+#include "cpu_run.hpp"
+#include "stack_distance.hpp"
+#include "trace.hpp"
+#include "hierarchy.hpp"
+#include "cache_config.hpp"
+#include "pipeline.hpp"
+#include "bpred.hpp"
+#include "hotspot.hpp"
+#include "checkpoint.hpp"
+#include "sampling.hpp"
+#include "dbt.hpp"
 
 struct Args {
     std::string in_path;
     std::optional<std::string> out_path;
     std::optional<uint32_t> out_addr;
     std::optional<uint32_t> out_size;
+    bool no_stats = false; // --no-stats: только функциональное исполнение
+    bool stack_distance = false; // --stack-distance: hit rate для всех геометрий LRU за один прогон
+    std::optional<std::string> trace_path; // --trace <file>: трасса обращений для riscv-replay
+    bool paged = false; // --paged: всё 32-битное пространство, страницы по требованию
+    bool hierarchy = false; // --hierarchy: L1I/L1D/L2 + DRAM, трафик, такты простоя, AMAT
+    CacheHierarchy::Config hier; // --l1i/--l1d/--l2 policy:sets:ways:line[:latency], --dram-latency N
+    bool pipeline = false; // --pipeline: такты и CPI 5-стадийного конвейера (задержки памяти — из иерархии)
+    PipelineModel::Config pipe; // --branch-penalty N, --mul-latency N, --div-latency N
+    std::vector<std::string> bpred; // --bpred static,bimodal:12,gshare:14,tage:10 | all
+    BranchUnit::Config branch;      // --btb N (степень двойки), --ras N
+    bool profile = false;           // --profile: горячие инструкции по pc и гистограмма классов
+    std::size_t profile_top = 20;   // --profile-top N
+    std::optional<std::string> flamegraph; // --flamegraph <file>: свёрнутые стеки вызовов
+    std::optional<uint64_t> checkpoint_at;  // --checkpoint-at N <file>: снимок после N инструкций
+    std::string checkpoint_path;
+    std::optional<std::string> restore_path; // --restore <file>: продолжить со снимка вместо -i
+    bool sample = false;            // --sample: выборочная симуляция с оценкой hit rate
+    SampledRun::Config sampling;    // --sample-ff N, --sample-warmup N, --sample-detail N, --simpoints K
+    std::optional<std::string> bbv_path; // --bbv <file>: векторы базовых блоков по интервалам
+    bool dbt = false;               // --dbt: горячие блоки — в машинный код x86-64
 };
 
 bool parse_u32_safe(const char* s, uint32_t& out) {
@@ -43,12 +74,115 @@ static std::optional<Args> parse_args(int argc, char** argv, std::string& err) {
             if (!parse_u32_safe(argv[++i], size)) { err = "invalid output size"; return std::nullopt; }
             a.out_addr = addr;
             a.out_size = size;
+        } else if (s == "--no-stats") {
+            a.no_stats = true;
+        } else if (s == "--stack-distance") {
+            a.stack_distance = true;
+        } else if (s == "--hierarchy") {
+            a.hierarchy = true;
+        } else if (s == "--l1i" || s == "--l1d" || s == "--l2") {
+            if (i + 1 >= argc) { err = "missing argument after " + s; return std::nullopt; }
+            CacheConfig& c = s == "--l1i" ? a.hier.l1i : s == "--l1d" ? a.hier.l1d : a.hier.l2;
+            if (!parse_cache_config(argv[++i], c, err)) return std::nullopt;
+            a.hierarchy = true;
+        } else if (s == "--dram-latency") {
+            if (i + 1 >= argc) { err = "missing argument after --dram-latency"; return std::nullopt; }
+            uint32_t lat;
+            if (!parse_u32_safe(argv[++i], lat)) { err = "invalid DRAM latency"; return std::nullopt; }
+            a.hier.dram_latency = lat;
+            a.hierarchy = true;
+        } else if (s == "--pipeline") {
+            a.pipeline = true;
+        } else if (s == "--branch-penalty" || s == "--mul-latency" || s == "--div-latency") {
+            if (i + 1 >= argc) { err = "missing argument after " + s; return std::nullopt; }
+            uint32_t v;
+            if (!parse_u32_safe(argv[++i], v)) { err = "invalid value for " + s; return std::nullopt; }
+            if (s != "--branch-penalty" && v == 0) { err = "latency must be positive: " + s; return std::nullopt; }
+            (s == "--branch-penalty" ? a.pipe.branch_penalty : s == "--mul-latency" ? a.pipe.mul_latency : a.pipe.div_latency) = v;
+            a.pipeline = true;
+        } else if (s == "--bpred") {
+            if (i + 1 >= argc) { err = "missing argument after --bpred"; return std::nullopt; }
+            std::string list = argv[++i];
+            if (list == "all") list = "static,bimodal,gshare,tage";
+            for (std::size_t pos = 0; pos <= list.size(); ) {
+                std::size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                a.bpred.push_back(list.substr(pos, comma - pos));
+                pos = comma + 1;
+            }
+        } else if (s == "--btb" || s == "--ras") {
+            if (i + 1 >= argc) { err = "missing argument after " + s; return std::nullopt; }
+            uint32_t v;
+            if (!parse_u32_safe(argv[++i], v) || v == 0 || v > (1u << 20)) { err = "invalid value for " + s; return std::nullopt; }
+            if (s == "--btb" && (v & (v - 1))) { err = "BTB size must be a power of two"; return std::nullopt; }
+            (s == "--btb" ? a.branch.btb_entries : a.branch.ras_depth) = v;
+        } else if (s == "--profile") {
+            a.profile = true;
+        } else if (s == "--profile-top") {
+            if (i + 1 >= argc) { err = "missing argument after --profile-top"; return std::nullopt; }
+            uint32_t v;
+            if (!parse_u32_safe(argv[++i], v)) { err = "invalid value for --profile-top"; return std::nullopt; }
+            a.profile_top = v;
+            a.profile = true;
+        } else if (s == "--flamegraph") {
+            if (i + 1 >= argc) { err = "missing argument after --flamegraph"; return std::nullopt; }
+            a.flamegraph = argv[++i];
+            a.profile = true;
+        } else if (s == "--checkpoint-at") {
+            if (i + 2 >= argc) { err = "missing arguments after --checkpoint-at"; return std::nullopt; }
+            char* end = nullptr;
+            const unsigned long long n = strtoull(argv[++i], &end, 0);
+            if (*end != '\0' || n == 0) { err = "invalid checkpoint instruction count"; return std::nullopt; }
+            a.checkpoint_at = n;
+            a.checkpoint_path = argv[++i];
+        } else if (s == "--restore") {
+            if (i + 1 >= argc) { err = "missing argument after --restore"; return std::nullopt; }
+            a.restore_path = argv[++i];
+        } else if (s == "--sample") {
+            a.sample = true;
+        } else if (s == "--sample-ff" || s == "--sample-warmup" || s == "--sample-detail") {
+            if (i + 1 >= argc) { err = "missing argument after " + s; return std::nullopt; }
+            char* end = nullptr;
+            const unsigned long long n = strtoull(argv[++i], &end, 0);
+            if (*end != '\0') { err = "invalid value for " + s; return std::nullopt; }
+            (s == "--sample-ff" ? a.sampling.fast_forward : s == "--sample-warmup" ? a.sampling.warmup : a.sampling.detail) = n;
+            a.sample = true;
+        } else if (s == "--simpoints") {
+            if (i + 1 >= argc) { err = "missing argument after --simpoints"; return std::nullopt; }
+            uint32_t k;
+            if (!parse_u32_safe(argv[++i], k)) { err = "invalid value for --simpoints"; return std::nullopt; }
+            a.sampling.simpoints = k;
+            a.sample = true;
+        } else if (s == "--bbv") {
+            if (i + 1 >= argc) { err = "missing argument after --bbv"; return std::nullopt; }
+            a.bbv_path = argv[++i];
+            a.sample = true;
+        } else if (s == "--dbt") {
+            a.dbt = true;
+        } else if (s == "--paged") {
+            a.paged = true;
+        } else if (s == "--trace") {
+            if (i + 1 >= argc) { err = "missing argument after --trace"; return std::nullopt; }
+            a.trace_path = argv[++i];
         } else {
             err = "unknown argument: " + s;
             return std::nullopt;
         }
     }
-    if (a.in_path.empty()) { err = "input file is required (-i <file>)"; return std::nullopt; }
+    if (a.in_path.empty() && !a.restore_path) { err = "input file is required (-i <file>)"; return std::nullopt; }
+    if (a.sample) {
+        // остальные модели и снимки считают весь прогон, с выборкой их не совместить
+        if (a.no_stats || a.checkpoint_at || a.trace_path || a.stack_distance || a.hierarchy || a.pipeline
+            || !a.bpred.empty() || a.profile) {
+            err = "--sample can only be combined with -i, -o, --restore and --paged"; return std::nullopt;
+        }
+        if (a.sampling.detail == 0) { err = "detail window must not be empty"; return std::nullopt; }
+    }
+    if (a.dbt && (a.sample || a.trace_path || a.stack_distance || a.hierarchy || a.pipeline
+                  || !a.bpred.empty() || a.profile)) {
+        // машинный код вызывает только LRU/bpLRU
+        err = "--dbt supports only the LRU/bpLRU statistics (or --no-stats)"; return std::nullopt;
+    }
     return a;
 }
 
@@ -77,43 +211,148 @@ int main(int argc, char** argv) {
     auto args = parse_args(argc, argv, err);
     if (!args) { std::fprintf(stderr, "Error parsing arguments: %s\n", err.c_str()); return 1; }
 
-    auto img = read_input_file(args->in_path, err);
-    if (!img) { std::fprintf(stderr, "Error reading input file: %s\n", err.c_str()); return 2; }
-
-    // Load fragments into memory
-    Memory mem;
-    for (auto& f : img->frags) {
-        if (static_cast<uint64_t>(f.addr) + f.data.size() > MEMORY_SIZE) {
-            std::fprintf(stderr, "Fragment out of memory bounds\n"); return 3;
-        }
-        mem.load_frag(f.addr, f.data);
+    // Предсказатели переходов
+    std::vector<std::unique_ptr<DirectionPredictor>> predictors;
+    for (const auto& spec : args->bpred) {
+        std::unique_ptr<DirectionPredictor> p;
+        if (!make_predictor(spec, p, err)) { std::fprintf(stderr, "Error parsing arguments: %s\n", err.c_str()); return 1; }
+        predictors.push_back(std::move(p));
     }
 
-    // Initialize CPU registers from image
+    Memory mem(args->paged ? Memory::Layout::Paged : Memory::Layout::Flat);
     CPU cpu;
     uint32_t start_ra = 0;
-    cpu.reset_from_regs(img->regs, start_ra);
+    uint64_t steps_done = 0; // выполнено до снимка, с которого продолжаем
 
     // Create caches
-    std::unique_ptr<Cache> lru(make_lru_cache());
-    std::unique_ptr<Cache> bplru(make_bplru_cache());
+    LRUCache lru;
+    BpLRUCache bplru;
+
+    if (args->restore_path) {
+        // всё состояние (память, регистры, кэши) — из снимка
+        CheckpointState st;
+        if (!load_checkpoint(*args->restore_path, cpu, st, mem, lru, bplru, err)) {
+            std::fprintf(stderr, "Error reading checkpoint: %s\n", err.c_str()); return 2;
+        }
+        start_ra = st.start_ra;
+        steps_done = st.steps;
+    } else {
+        auto img = read_input_file(args->in_path, err);
+        if (!img) { std::fprintf(stderr, "Error reading input file: %s\n", err.c_str()); return 2; }
+
+        // Load fragments into memory
+        for (auto& f : img->frags) {
+            if (static_cast<uint64_t>(f.addr) + f.data.size() > mem.size()) {
+                std::fprintf(stderr, "Fragment out of memory bounds\n"); return 3;
+            }
+            mem.load_frag(f.addr, f.data);
+        }
+
+        // Initialize CPU registers from image
+        cpu.reset_from_regs(img->regs, start_ra);
+    }
+
+    // MAX_STEPS — на весь прогон, включая часть до снимка
+    uint64_t budget = steps_done < CPU::MAX_STEPS ? CPU::MAX_STEPS - steps_done : 0;
+    const bool checkpoint_limited = args->checkpoint_at && *args->checkpoint_at < budget;
+    if (checkpoint_limited) budget = *args->checkpoint_at;
+    cpu.set_max_steps(budget);
+
+    TraceWriter trace;
+    if (args->trace_path && !trace.open(*args->trace_path, err)) {
+        std::fprintf(stderr, "Error writing trace: %s\n", err.c_str()); return 7;
+    }
 
-    // If bplru not provided by implementation, we'll print "unsupported" for it later
-    bool bplru_unsupported = (bplru == nullptr);
+    // Run CPU: both caches see every access; --no-stats runs without cache models
+    std::unique_ptr<StackDistanceProfiler> profiler;
+    std::unique_ptr<CacheHierarchy> hierarchy;
+    std::unique_ptr<PipelineModel> pipeline;
+    std::unique_ptr<BranchUnit> branch;
+    std::unique_ptr<HotspotProfiler> hotspots;
+    if (!args->no_stats) {
+        if (args->profile) hotspots = std::make_unique<HotspotProfiler>(lru, bplru, cpu.get_pc());
+        if (!predictors.empty()) branch = std::make_unique<BranchUnit>(args->branch, std::move(predictors));
+        if (args->stack_distance) profiler = std::make_unique<StackDistanceProfiler>();
+        if (args->hierarchy || args->pipeline) hierarchy = std::make_unique<CacheHierarchy>(args->hier);
+        if (args->pipeline) pipeline = std::make_unique<PipelineModel>(args->pipe, *hierarchy);
+    }
+
+    // дополнительные модели, выбранные флагами
+    DynamicModels extra;
+    if (profiler) extra.add(*profiler);
+    if (hierarchy) extra.add(*hierarchy);
+    if (pipeline) extra.add(*pipeline);
+    if (branch) extra.add(*branch);
+    if (hotspots) extra.add(*hotspots); // после lru/bplru: смотрит на их счётчики
+    if (args->trace_path) extra.add(trace);
 
-    // Run CPU: caches will be used inside CPU::run (we pass both caches)
-    ExecResult r = cpu.run(mem, *lru, (bplru ? *bplru : *lru), /*enable_bplru=*/!bplru_unsupported, start_ra);
-    if (!r.ok) { std::fprintf(stderr, "Execution failed\n"); return 4; }
+    ExecResult r;
+    std::unique_ptr<SampledRun> sampled;
+    if (args->sample) {
+        sampled = std::make_unique<SampledRun>(args->sampling);
+        r = sampled->run(cpu, mem, lru, bplru, start_ra, budget);
+    } else if (args->dbt) {
+        // без x86-64 или с --paged — тот же интерпретатор
+        DbtEngine dbt;
+        if (!dbt.available() || args->paged)
+            std::fprintf(stderr, "--dbt: translation unavailable (needs x86-64 Linux and flat memory), using the interpreter\n");
+        r = args->no_stats ? dbt.run(cpu, mem, nullptr, nullptr, start_ra) : dbt.run(cpu, mem, &lru, &bplru, start_ra);
+    } else if (args->no_stats) {
+        if (!extra.empty()) {
+            CacheList<DynamicModels> caches(extra);
+            r = cpu.run_with(mem, caches, start_ra);
+        } else {
+            r = cpu.run(mem, start_ra);
+        }
+    } else if (!extra.empty()) {
+        CacheList<LRUCache, BpLRUCache, DynamicModels> caches(lru, bplru, extra);
+        r = cpu.run_with(mem, caches, start_ra);
+    } else {
+        r = cpu.run(mem, lru, bplru, /*enable_bplru=*/true, start_ra);
+    }
+    if (args->trace_path && !trace.close(err)) {
+        std::fprintf(stderr, "Error writing trace: %s\n", err.c_str()); return 7;
+    }
+    if (checkpoint_limited && r.step_limit) {
+        CheckpointState st;
+        st.steps = steps_done + r.steps;
+        st.start_ra = start_ra;
+        if (!save_checkpoint(args->checkpoint_path, cpu, st, mem, lru, bplru, err)) {
+            std::fprintf(stderr, "Error writing checkpoint: %s\n", err.c_str()); return 9;
+        }
+        std::fprintf(stderr, "Checkpoint written to %s after %llu instructions\n",
+                     args->checkpoint_path.c_str(), static_cast<unsigned long long>(st.steps));
+    } else {
+        if (args->checkpoint_at) std::fprintf(stderr, "Program stopped before the checkpoint, none written\n");
+        if (!r.ok) { std::fprintf(stderr, "Execution failed\n"); return 4; }
+    }
 
-    // Print cache stats
-    std::printf("replacement\thit rate\thit rate (inst)\thit rate (data)\n");
-    print_line_percent_or_unsupported("        LRU",   lru->stats(), false);
-    print_line_percent_or_unsupported("      bpLRU", bplru_unsupported ? CacheStats{} : bplru->stats(), bplru_unsupported);
+    // Print cache stats (при выборке — оценки по окнам)
+    if (sampled) {
+        sampled->report(stdout);
+        if (args->bbv_path && !sampled->write_bbv(*args->bbv_path, err)) {
+            std::fprintf(stderr, "Error writing BBV file: %s\n", err.c_str()); return 10;
+        }
+    } else if (!args->no_stats) {
+        std::printf("replacement\thit rate\thit rate (inst)\thit rate (data)\n");
+        print_line_percent_or_unsupported("        LRU",   lru.stats(), false);
+        print_line_percent_or_unsupported("      bpLRU", bplru.stats(), false);
+    }
+    if (branch) branch->report(stdout);
+    if (profiler) profiler->report(stdout);
+    if (hotspots) {
+        hotspots->report(stdout, args->profile_top);
+        if (args->flamegraph && !hotspots->write_collapsed(*args->flamegraph, err)) {
+            std::fprintf(stderr, "Error writing flamegraph: %s\n", err.c_str()); return 8;
+        }
+    }
+    if (hierarchy) hierarchy->report(stdout);
+    if (pipeline) pipeline->report(stdout);
 
     // If output requested, write registers+memory fragment as specified
     if (args->out_path) {
-        OutputImage out{};
-        cpu.export_regs(out.regs);
+        uint32_t regs[32];
+        cpu.export_regs(regs);
 
         // Получаем адрес и размер как 64-битные
         int64_t start_addr_signed = args->out_addr.value();
@@ -129,20 +368,14 @@ int main(int argc, char** argv) {
         uint64_t size  = static_cast<uint64_t>(size_signed);
 
         // Проверка на переполнение
-        if (start > MEMORY_SIZE || size > MEMORY_SIZE || start + size > MEMORY_SIZE) {
+        if (start > mem.size() || size > mem.size() || start + size > mem.size()) {
             std::fprintf(stderr, "Output range out of memory bounds\n");
             return 5;
         }
 
-        out.start_addr = start;
-
-        // Безопасно копируем срез памяти
-        auto &raw_mem = mem.raw(); // важно: должна быть ссылка!
-        out.mem.assign(raw_mem.begin() + start,
-                    raw_mem.begin() + start + size);
-
-        // Пишем в файл
-        if (!write_output_file(args->out_path.value(), out, err)) {
+        // Пишем в файл прямо из памяти (в Paged невыделенные страницы — нули)
+        if (!write_output_file(args->out_path.value(), regs, mem, static_cast<uint32_t>(start),
+                               static_cast<uint32_t>(size), err)) {
             std::fprintf(stderr, "Error writing output file: %s\n", err.c_str());
             return 6;
         }
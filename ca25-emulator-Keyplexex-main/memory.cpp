@@ -1,45 +1,47 @@
 #include "memory.hpp"
+#include <algorithm>
 #include <cstring>
-#include <iostream>
 
-Memory::Memory() : ram_(MEMORY_SIZE, 0) {}
-
-void Memory::load_frag(uint32_t addr, const std::vector<uint8_t>& data) {
-    if (addr + data.size() > ram_.size()) return;
-    std::memcpy(&ram_[addr], data.data(), data.size());
+Memory::Memory(Layout layout) : paged_(layout == Layout::Paged) {
+    if (paged_) dir_.resize(TABLE_SIZE);
+    else ram_.assign(MEMORY_SIZE, 0);
 }
 
-bool Memory::read_u8(uint32_t addr, uint8_t& v) const {
-    if (addr >= ram_.size()) return false; v = ram_[addr]; return true;
-}
-bool Memory::read_u16(uint32_t addr, uint16_t& v) const {
-    if (addr+1 >= ram_.size()) return false;
-    v = static_cast<uint16_t>(ram_[addr]) | (static_cast<uint16_t>(ram_[addr+1])<<8);
-    return true;
-}
-bool Memory::read_u32(uint32_t addr, uint32_t& v) const {
-    if (addr+3 >= ram_.size()) return false;
-    v =  static_cast<uint32_t>(ram_[addr])
-       | (static_cast<uint32_t>(ram_[addr+1])<<8)
-       | (static_cast<uint32_t>(ram_[addr+2])<<16)
-       | (static_cast<uint32_t>(ram_[addr+3])<<24);
-    return true;
+void Memory::load_frag(uint32_t addr, std::span<const uint8_t> data) {
+    if (addr + data.size() > size()) return;
+    write_bytes(addr, data.data(), data.size());
 }
 
-bool Memory::write_u8(uint32_t addr, uint8_t val) {
-    if (addr >= ram_.size()) return false; ram_[addr]=val; return true;
+uint8_t* Memory::touch_page(uint32_t addr) {
+    auto& t = dir_[dir_index(addr)];
+    if (!t) t = std::make_unique<Table>();
+    auto& p = t->pages[page_index(addr)];
+    if (!p) { p = std::make_unique<Page>(); ++resident_pages_; }
+    return p->bytes;
 }
-bool Memory::write_u16(uint32_t addr, uint16_t v) {
-    if (addr+1 >= ram_.size()) return false;
-    ram_[addr]   = static_cast<uint8_t>(v & 0xFF);
-    ram_[addr+1] = static_cast<uint8_t>((v>>8) & 0xFF);
+
+bool Memory::read_bytes(uint32_t addr, uint8_t* dst, std::size_t n) const {
+    if (static_cast<uint64_t>(addr) + n > size()) return false;
+    if (!paged_) { if (n) std::memcpy(dst, &ram_[addr], n); return true; }
+
+    // по страницам; невыделенные читаются нулями
+    while (n) {
+        const std::size_t chunk = std::min(n, PAGE_SIZE - page_offset(addr));
+        if (const uint8_t* p = find_page(addr)) std::memcpy(dst, p + page_offset(addr), chunk);
+        else std::memset(dst, 0, chunk);
+        addr += static_cast<uint32_t>(chunk); dst += chunk; n -= chunk;
+    }
     return true;
 }
-bool Memory::write_u32(uint32_t addr, uint32_t v) {
-    if (addr+3 >= ram_.size()) return false;
-    ram_[addr]   = static_cast<uint8_t>(v & 0xFF);
-    ram_[addr+1] = static_cast<uint8_t>((v>>8) & 0xFF);
-    ram_[addr+2] = static_cast<uint8_t>((v>>16)& 0xFF);
-    ram_[addr+3] = static_cast<uint8_t>((v>>24)& 0xFF);
+
+bool Memory::write_bytes(uint32_t addr, const uint8_t* src, std::size_t n) {
+    if (static_cast<uint64_t>(addr) + n > size()) return false;
+    if (!paged_) { if (n) std::memcpy(&ram_[addr], src, n); return true; }
+
+    while (n) {
+        const std::size_t chunk = std::min(n, PAGE_SIZE - page_offset(addr));
+        std::memcpy(touch_page(addr) + page_offset(addr), src, chunk);
+        addr += static_cast<uint32_t>(chunk); src += chunk; n -= chunk;
+    }
     return true;
 }
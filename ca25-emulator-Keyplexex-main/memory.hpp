@@ -1,25 +1,154 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <span>
 #include <vector>
 #include "config.hpp"
 
+// Чтение/запись little-endian значения по невыровненному адресу хоста.
+// memcpy компилятор сводит к одной инструкции; на big-endian хосте — ещё byteswap.
+template <class T>
+inline T load_le(const uint8_t* p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) v = std::byteswap(v);
+    return v;
+}
+
+template <class T>
+inline void store_le(uint8_t* p, T v) {
+    if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) v = std::byteswap(v);
+    std::memcpy(p, &v, sizeof(T));
+}
+
+// Память эмулятора.
+//  Flat  — как по заданию: MEMORY_SIZE байт одним массивом, всё за его пределами — ошибка.
+//  Paged — всё 32-битное пространство: двухуровневая таблица страниц по 4 КиБ,
+//          страница выделяется при первой записи, нетронутая читается нулями.
 class Memory {
 public:
-    Memory(); 
-    void load_frag(uint32_t addr, const std::vector<uint8_t>& data);
+    enum class Layout { Flat, Paged };
+
+    static constexpr unsigned    PAGE_SHIFT = 12;
+    static constexpr std::size_t PAGE_SIZE  = std::size_t{1} << PAGE_SHIFT;
+
+    explicit Memory(Layout layout = Layout::Flat);
+    void load_frag(uint32_t addr, std::span<const uint8_t> data);
+
+    Layout layout() const { return paged_ ? Layout::Paged : Layout::Flat; }
+    // размер адресуемого пространства
+    uint64_t size() const { return paged_ ? (uint64_t{1} << 32) : ram_.size(); }
+    // сколько страниц выделено (Paged)
+    std::size_t resident_pages() const { return resident_pages_; }
+
+    // Низкоуровневые чтения/записи (little-endian, одна проверка диапазона)
+    bool read_u8 (uint32_t addr, uint8_t&  v) const { return read(addr, v); }
+    bool read_u16(uint32_t addr, uint16_t& v) const { return read(addr, v); }
+    bool read_u32(uint32_t addr, uint32_t& v) const { return read(addr, v); }
+
+    bool write_u8 (uint32_t addr, uint8_t  v) { return write(addr, v); }
+    bool write_u16(uint32_t addr, uint16_t v) { return write(addr, v); }
+    bool write_u32(uint32_t addr, uint32_t v) { return write(addr, v); }
 
-    // Низкоуровневые чтения/записи
-    bool read_u8 (uint32_t addr, uint8_t&  v) const;
-    bool read_u16(uint32_t addr, uint16_t& v) const;
-    bool read_u32(uint32_t addr, uint32_t& v) const;
+    // Непрерывный кусок памяти хоста с addr длиной до max байт (меньше — у конца
+    // памяти или страницы). Пустой — если addr вне памяти или страница не выделена.
+    // Указатель живёт, пока живёт Memory; запись через него мимо write_* не видит BlockCache.
+    std::span<const uint8_t> host_span(uint32_t addr, std::size_t max) const {
+        if (!paged_) {
+            if (addr >= ram_.size()) return {};
+            return {ram_.data() + addr, std::min<std::size_t>(max, ram_.size() - addr)};
+        }
+        const uint8_t* p = find_page(addr);
+        if (!p) return {};
+        return {p + page_offset(addr), std::min<std::size_t>(max, PAGE_SIZE - page_offset(addr))};
+    }
 
-    bool write_u8 (uint32_t addr, uint8_t  v);
-    bool write_u16(uint32_t addr, uint16_t v);
-    bool write_u32(uint32_t addr, uint32_t v);
+    // Копирование диапазона [addr, addr+n) наружу/внутрь; false — выход за пределы
+    bool read_bytes (uint32_t addr, uint8_t* dst, std::size_t n) const;
+    bool write_bytes(uint32_t addr, const uint8_t* src, std::size_t n);
 
-    const std::vector<uint8_t>& raw() const { return ram_; }
-          std::vector<uint8_t>& raw()       { return ram_; }
+    // f(addr, bytes) для каждой страницы PAGE_SIZE: Flat — вся память по кускам,
+    // Paged — только выделенные страницы, по возрастанию адреса
+    template <class F>
+    void for_each_page(F&& f) const {
+        if (!paged_) {
+            for (std::size_t a = 0; a < ram_.size(); a += PAGE_SIZE) f(static_cast<uint32_t>(a), ram_.data() + a);
+            return;
+        }
+        for (std::size_t t = 0; t < TABLE_SIZE; ++t) {
+            if (!dir_[t]) continue;
+            for (std::size_t p = 0; p < TABLE_SIZE; ++p) {
+                if (const Page* pg = dir_[t]->pages[p].get())
+                    f(static_cast<uint32_t>(((t << TABLE_BITS) | p) << PAGE_SHIFT), pg->bytes);
+            }
+        }
+    }
+
+    // Только для Flat: вся память одним куском
+    std::span<const uint8_t> raw() const { return ram_; }
+    std::span<uint8_t>       raw()       { return ram_; }
 
 private:
-    std::vector<uint8_t> ram_;
+    static constexpr unsigned    TABLE_BITS = 10;  // 10 + 10 + 12 = 32
+    static constexpr std::size_t TABLE_SIZE = std::size_t{1} << TABLE_BITS;
+
+    struct Page  { uint8_t bytes[PAGE_SIZE]{}; };
+    struct Table { std::unique_ptr<Page> pages[TABLE_SIZE]; };
+
+    static std::size_t dir_index (uint32_t addr) { return addr >> (PAGE_SHIFT + TABLE_BITS); }
+    static std::size_t page_index(uint32_t addr) { return (addr >> PAGE_SHIFT) & (TABLE_SIZE - 1); }
+    static std::size_t page_offset(uint32_t addr) { return addr & (PAGE_SIZE - 1); }
+
+    // nullptr — страница ещё не выделена
+    const uint8_t* find_page(uint32_t addr) const {
+        const Table* t = dir_[dir_index(addr)].get();
+        if (!t) return nullptr;
+        const Page* p = t->pages[page_index(addr)].get();
+        return p ? p->bytes : nullptr;
+    }
+    uint8_t* touch_page(uint32_t addr);
+
+    template <class T>
+    bool read(uint32_t addr, T& v) const {
+        if (!paged_) {
+            if (addr > ram_.size() - sizeof(T)) return false;
+            v = load_le<T>(ram_.data() + addr);
+            return true;
+        }
+        // быстрый путь — обращение целиком внутри страницы
+        if (page_offset(addr) <= PAGE_SIZE - sizeof(T)) {
+            const uint8_t* p = find_page(addr);
+            v = p ? load_le<T>(p + page_offset(addr)) : T{0};
+            return true;
+        }
+        uint8_t b[sizeof(T)];
+        if (!read_bytes(addr, b, sizeof(T))) return false; // через конец адресного пространства
+        v = load_le<T>(b);
+        return true;
+    }
+
+    template <class T>
+    bool write(uint32_t addr, T v) {
+        if (!paged_) {
+            if (addr > ram_.size() - sizeof(T)) return false;
+            store_le<T>(ram_.data() + addr, v);
+            return true;
+        }
+        if (page_offset(addr) <= PAGE_SIZE - sizeof(T)) {
+            store_le<T>(touch_page(addr) + page_offset(addr), v);
+            return true;
+        }
+        uint8_t b[sizeof(T)];
+        store_le<T>(b, v);
+        return write_bytes(addr, b, sizeof(T));
+    }
+
+    bool paged_ = false;
+    std::vector<uint8_t> ram_;                  // Flat
+    std::vector<std::unique_ptr<Table>> dir_;   // Paged: верхний уровень, 1024 таблицы
+    std::size_t resident_pages_ = 0;
 };
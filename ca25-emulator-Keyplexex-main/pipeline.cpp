@@ -0,0 +1,94 @@
+#include "pipeline.hpp"
+#include <limits>
+
+namespace {
+
+// какие регистры-источники читает инструкция в EX
+struct Sources { bool rs1, rs2; };
+
+Sources sources(Op op) {
+    switch (op) {
+        case Op::LUI: case Op::AUIPC: case Op::JAL: case Op::HALT: case Op::ILLEGAL:
+            return {false, false};
+        case Op::JALR:
+        case Op::LB: case Op::LH: case Op::LW: case Op::LBU: case Op::LHU:
+        case Op::ADDI: case Op::SLTI: case Op::SLTIU: case Op::XORI: case Op::ORI: case Op::ANDI:
+        case Op::SLLI: case Op::SRLI: case Op::SRAI:
+            return {true, false};
+        // данные сохранения байпасятся прямо в MEM
+        case Op::SB: case Op::SH: case Op::SW:
+            return {true, false};
+        default:
+            return {true, true};
+    }
+}
+
+bool is_load(Op op) {
+    return op == Op::LB || op == Op::LH || op == Op::LW || op == Op::LBU || op == Op::LHU;
+}
+
+bool is_store(Op op) { return op == Op::SB || op == Op::SH || op == Op::SW; }
+
+}
+
+void PipelineModel::retire(const DecodedInsn& d, uint32_t next_pc) {
+    ++instret_;
+
+    // промах выборки
+    stalls_[ICache] += mem_.last_cycles(AccessKind::Inst) - mem_.l1_latency(AccessKind::Inst);
+
+    if (load_rd_) {
+        const Sources s = sources(d.op);
+        if ((s.rs1 && d.rs1 == load_rd_) || (s.rs2 && d.rs2 == load_rd_)) stalls_[LoadUse]++;
+    }
+    load_rd_ = is_load(d.op) ? d.rd : 0;
+
+    switch (d.op) {
+        case Op::JAL:
+            stalls_[Branch] += cfg_.jal_penalty;
+            break;
+        case Op::JALR:
+            stalls_[Branch] += cfg_.branch_penalty;
+            break;
+        case Op::BEQ: case Op::BNE: case Op::BLT: case Op::BGE: case Op::BLTU: case Op::BGEU:
+            if (next_pc != d.pc + 4) stalls_[Branch] += cfg_.branch_penalty;
+            break;
+        case Op::MUL: case Op::MULH: case Op::MULHSU: case Op::MULHU:
+            stalls_[MulDiv] += cfg_.mul_latency - 1;
+            break;
+        case Op::DIV: case Op::DIVU: case Op::REM: case Op::REMU:
+            stalls_[MulDiv] += cfg_.div_latency - 1;
+            break;
+        default:
+            if (is_load(d.op) || is_store(d.op))
+                stalls_[DCache] += mem_.last_cycles(AccessKind::Data) - mem_.l1_latency(AccessKind::Data);
+            break;
+    }
+}
+
+uint64_t PipelineModel::cycles() const {
+    if (instret_ == 0) return 0;
+    uint64_t c = instret_ + (STAGES - 1);
+    for (uint64_t s : stalls_) c += s;
+    return c;
+}
+
+double PipelineModel::cpi() const {
+    return instret_ ? static_cast<double>(cycles()) / instret_ : std::numeric_limits<double>::quiet_NaN();
+}
+
+void PipelineModel::report(std::FILE* out) const {
+    static const char* names[STALL_KINDS] = {"load-use", "branch", "mul/div", "icache miss", "dcache miss"};
+
+    const uint64_t total = cycles();
+    std::fprintf(out, "\npipeline (5-stage in-order)\n");
+    std::fprintf(out, "instructions\t%llu\n", static_cast<unsigned long long>(instret_));
+    std::fprintf(out, "cycles\t%llu\n", static_cast<unsigned long long>(total));
+    std::fprintf(out, "CPI\t%.4f\n", cpi());
+    std::fprintf(out, "stall\tcycles\tshare\n");
+    for (std::size_t i = 0; i < STALL_KINDS; ++i) {
+        std::fprintf(out, "%s\t%llu\t", names[i], static_cast<unsigned long long>(stalls_[i]));
+        if (total == 0) std::fprintf(out, "nan%%\n");
+        else std::fprintf(out, "%3.5f%%\n", 100.0 * stalls_[i] / total);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include "decode.hpp"
+#include "hierarchy.hpp"
+
+// Временная модель классического 5-стадийного конвейера (IF ID EX MEM WB), in-order,
+// с полным байпасом. Функционально ничего не меняет: считает такты по выполненным
+// инструкциям (хук retire), задержки памяти берёт из иерархии кэшей.
+//  - load-use: инструкция сразу после загрузки, читающая её rd, ждёт такт;
+//  - переходы: предсказание «не перейдёт», ветвление решается в EX, JAL — в ID;
+//  - MUL/DIV занимают EX на mul_latency / div_latency тактов;
+//  - промах в L1I/L1D останавливает конвейер на такты сверх попадания.
+class PipelineModel {
+public:
+    struct Config {
+        unsigned branch_penalty = 2; // взятое ветвление и JALR
+        unsigned jal_penalty    = 1;
+        unsigned mul_latency    = 3;
+        unsigned div_latency    = 34;
+    };
+
+    enum Stall : std::size_t { LoadUse, Branch, MulDiv, ICache, DCache, STALL_KINDS };
+
+    PipelineModel(const Config& c, const CacheHierarchy& mem) : cfg_(c), mem_(mem) {}
+
+    void retire(const DecodedInsn& d, uint32_t next_pc);
+
+    uint64_t instructions() const { return instret_; }
+    // + заполнение конвейера в начале
+    uint64_t cycles() const;
+    double cpi() const;
+
+    void report(std::FILE* out) const;
+
+private:
+    static constexpr unsigned STAGES = 5;
+
+    Config cfg_;
+    const CacheHierarchy& mem_;
+
+    uint64_t instret_ = 0;
+    uint64_t stalls_[STALL_KINDS] = {};
+    uint8_t  load_rd_ = 0;   // rd загрузки в предыдущей инструкции (0 — не загрузка)
+};
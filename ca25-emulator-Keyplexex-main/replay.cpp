@@ -0,0 +1,125 @@
+// replay.cpp — офлайн-прогон трассы (riscv-sim --trace) через набор конфигураций кэша.
+// Каждый поток читает трассу сам (mmap, страницы общие) и гонит её через свою группу моделей.
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cache.hpp"
+#include "cache_config.hpp"
+#include "trace.hpp"
+
+namespace {
+
+using Config = CacheConfig;
+
+struct Args {
+    std::string trace_path;
+    std::vector<Config> configs;
+    unsigned jobs = 0; // 0 — по числу ядер
+};
+
+constexpr std::size_t CHUNK_RECORDS = std::size_t{1} << 16;
+
+// по умолчанию: обе политики, 1..1024 наборов, 1..16 путей, линии CACHE_LINE_SIZE
+std::vector<Config> default_sweep() {
+    std::vector<Config> v;
+    for (Policy p : {Policy::LRU, Policy::BpLRU})
+        for (std::size_t sets = 1; sets <= 1024; sets *= 2)
+            for (std::size_t ways = 1; ways <= 16; ways *= 2)
+                v.push_back({p, sets, ways, CACHE_LINE_SIZE, 1});
+    return v;
+}
+
+bool parse_args(int argc, char** argv, Args& a, std::string& err) {
+    for (int i = 1; i < argc; ++i) {
+        std::string s = argv[i];
+        if (s == "-t") {
+            if (i + 1 >= argc) { err = "missing argument after -t"; return false; }
+            a.trace_path = argv[++i];
+        } else if (s == "-c") {
+            if (i + 1 >= argc) { err = "missing argument after -c"; return false; }
+            Config c;
+            if (!parse_cache_config(argv[++i], c, err)) return false;
+            a.configs.push_back(c);
+        } else if (s == "-j") {
+            if (i + 1 >= argc) { err = "missing argument after -j"; return false; }
+            a.jobs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+        } else {
+            err = "unknown argument: " + s;
+            return false;
+        }
+    }
+    if (a.trace_path.empty()) { err = "trace file is required (-t <file>)"; return false; }
+    if (a.configs.empty()) a.configs = default_sweep();
+    return true;
+}
+
+void print_rate(uint64_t hits, uint64_t misses) {
+    const uint64_t total = hits + misses;
+    if (total == 0) std::printf("nan%%");
+    else std::printf("%3.5f%%", 100.0 * hits / total);
+}
+
+}
+
+int main(int argc, char** argv) {
+    Args args;
+    std::string err;
+    if (!parse_args(argc, argv, args, err)) { std::fprintf(stderr, "Error parsing arguments: %s\n", err.c_str()); return 1; }
+
+    TraceReader reader;
+    if (!reader.open(args.trace_path, err)) { std::fprintf(stderr, "Error reading trace: %s\n", err.c_str()); return 2; }
+
+    std::vector<DynamicCache> models;
+    models.reserve(args.configs.size());
+    for (const auto& c : args.configs) models.push_back(make_cache(c));
+
+    unsigned jobs = args.jobs ? args.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<std::size_t>(jobs, models.size()));
+
+    // Группа i — модели i, i+jobs, ...; каждая группа раскодирует трассу один раз
+    // и прогоняет каждую порцию через все свои модели.
+    std::atomic<unsigned> next_group{0};
+    std::atomic<bool> corrupt{false};
+    auto worker = [&] {
+        std::vector<TraceRecord> chunk;
+        chunk.reserve(CHUNK_RECORDS);
+        for (unsigned g; (g = next_group.fetch_add(1)) < jobs; ) {
+            TraceReader::Cursor cur;
+            for (;;) {
+                if (!reader.decode(cur, chunk, CHUNK_RECORDS)) { corrupt = true; break; }
+                if (chunk.empty()) break;
+                for (std::size_t m = g; m < models.size(); m += jobs) {
+                    std::visit([&](auto& model) {
+                        for (const auto& r : chunk) {
+                            if (r.is_write) model.write(r.addr, r.size, r.kind);
+                            else            model.read (r.addr, r.size, r.kind);
+                        }
+                    }, models[m]);
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < jobs; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    if (corrupt) { std::fprintf(stderr, "Error reading trace: corrupted trace file\n"); return 3; }
+
+    std::printf("replacement\tsets\tways\tline\thit rate\thit rate (inst)\thit rate (data)\n");
+    for (std::size_t i = 0; i < models.size(); ++i) {
+        const Config& c = args.configs[i];
+        const CacheStats st = std::visit([](const auto& m) { return m.stats(); }, models[i]);
+        std::printf("%11s\t%zu\t%zu\t%zu\t", policy_name(c.policy), c.sets, c.ways, c.line);
+        print_rate(st.hits_total, st.misses_total); std::printf("\t");
+        print_rate(st.hits_inst , st.misses_inst ); std::printf("\t");
+        print_rate(st.hits_data , st.misses_data ); std::printf("\n");
+    }
+    return 0;
+}
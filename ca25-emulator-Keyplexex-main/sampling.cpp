@@ -0,0 +1,331 @@
+#include "sampling.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include "cpu_run.hpp"
+
+namespace {
+
+// fast-forward: кэши не видят обращений, копится только BBV
+struct FunctionalHooks {
+    SampledRun& s;
+    void block(uint32_t start_pc, uint64_t n) { s.block(start_pc, n); }
+};
+
+// warmup и detail: обращения идут в LRU и bpLRU
+struct CacheHooks {
+    CacheList<LRUCache, BpLRUCache> caches;
+    SampledRun& s;
+    void fetch(uint32_t addr) { caches.fetch(addr); }
+    void load (uint32_t addr, std::size_t size) { caches.load(addr, size); }
+    void store(uint32_t addr, std::size_t size) { caches.store(addr, size); }
+    void block(uint32_t start_pc, uint64_t n) { s.block(start_pc, n); }
+};
+
+CacheStats delta(const CacheStats& now, const CacheStats& was) {
+    CacheStats d;
+    d.hits_total  = now.hits_total  - was.hits_total;  d.misses_total = now.misses_total - was.misses_total;
+    d.hits_inst   = now.hits_inst   - was.hits_inst;   d.misses_inst  = now.misses_inst  - was.misses_inst;
+    d.hits_data   = now.hits_data   - was.hits_data;   d.misses_data  = now.misses_data  - was.misses_data;
+    return d;
+}
+
+// столбцы отчёта: всего / инструкции / данные
+constexpr int COLUMNS = 3;
+std::pair<uint64_t, uint64_t> column(const CacheStats& st, int c) {
+    switch (c) {
+        case 0:  return {st.hits_total, st.hits_total + st.misses_total};
+        case 1:  return {st.hits_inst,  st.hits_inst  + st.misses_inst};
+        default: return {st.hits_data,  st.hits_data  + st.misses_data};
+    }
+}
+
+// квантиль t-распределения Стьюдента для двустороннего 95% интервала
+double t95(std::size_t df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0) return std::numeric_limits<double>::quiet_NaN();
+    return df <= std::size(table) ? table[df - 1] : 1.96;
+}
+
+// Отношение sum(hits) / sum(accesses) по окнам и полуширина его 95% интервала
+// (дисперсия оценки отношения через остатки h_i - R * a_i)
+struct Estimate { double rate, half; };
+Estimate ratio_estimate(const std::vector<std::pair<uint64_t, uint64_t>>& windows) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    double h = 0, a = 0;
+    std::size_t n = 0;
+    for (auto [hits, acc] : windows) {
+        if (acc == 0) continue;
+        h += static_cast<double>(hits); a += static_cast<double>(acc); ++n;
+    }
+    if (n == 0) return {nan, nan};
+    const double r = h / a;
+    if (n < 2) return {r, nan};
+    double ss = 0;
+    for (auto [hits, acc] : windows) {
+        if (acc == 0) continue;
+        const double e = static_cast<double>(hits) - r * static_cast<double>(acc);
+        ss += e * e;
+    }
+    const double mean_a = a / static_cast<double>(n);
+    const double se = std::sqrt(ss / static_cast<double>(n - 1) / static_cast<double>(n)) / mean_a;
+    return {r, t95(n - 1) * se};
+}
+
+void print_estimate(std::FILE* out, Estimate e) {
+    if (std::isnan(e.rate)) { std::fprintf(out, "nan%%"); return; }
+    std::fprintf(out, "%3.5f%%", 100.0 * e.rate);
+    if (!std::isnan(e.half)) std::fprintf(out, " ±%.5f%%", 100.0 * e.half);
+}
+
+// Случайная проекция BBV: коэффициент в [-1, 1] для пары (блок, измерение), без хранения матрицы
+constexpr std::size_t PROJ_DIMS = 15;
+double projection(uint32_t block, std::size_t dim) {
+    uint64_t z = (uint64_t{block} << 8 | dim) + 0x9e3779b97f4a7c15ULL; // splitmix64
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) / static_cast<double>(uint64_t{1} << 52) - 1.0;
+}
+
+using Point = std::array<double, PROJ_DIMS>;
+double dist2(const Point& a, const Point& b) {
+    double d = 0;
+    for (std::size_t i = 0; i < PROJ_DIMS; ++i) d += (a[i] - b[i]) * (a[i] - b[i]);
+    return d;
+}
+
+}
+
+void SampledRun::block(uint32_t start_pc, uint64_t n) {
+    if (n == 0) return;
+    auto [it, fresh] = block_ids_.try_emplace(start_pc, static_cast<uint32_t>(block_ids_.size()));
+    if (fresh) counts_.push_back(0);
+    uint64_t& c = counts_[it->second];
+    if (c == 0) touched_.push_back(it->second);
+    c += n;
+}
+
+void SampledRun::close_interval(uint64_t insns) {
+    Interval& iv = intervals_.back();
+    iv.insns = insns;
+    std::sort(touched_.begin(), touched_.end());
+    iv.bbv.reserve(touched_.size());
+    for (uint32_t id : touched_) {
+        iv.bbv.emplace_back(id, counts_[id]);
+        counts_[id] = 0;
+    }
+    touched_.clear();
+    total_ += insns;
+}
+
+ExecResult SampledRun::run(CPU& cpu, Memory& mem, LRUCache& lru, BpLRUCache& bplru,
+                           uint32_t start_ra, uint64_t budget) {
+    FunctionalHooks fast{*this};
+    CacheHooks cached{CacheList<LRUCache, BpLRUCache>(lru, bplru), *this};
+
+    ExecResult last;
+    last.final_pc = cpu.get_pc();
+    uint64_t done = 0;
+
+    // Фаза длиной len; false — программа остановилась (или кончился бюджет)
+    auto phase = [&](auto& hooks, uint64_t len) -> bool {
+        if (len == 0) return true;
+        const uint64_t n = std::min(len, budget - done);
+        if (n == 0) { // бюджет исчерпан ровно на границе фазы
+            last = ExecResult{};
+            last.ok = false;
+            last.step_limit = true;
+            last.final_pc = cpu.get_pc();
+            return false;
+        }
+        cpu.set_max_steps(n);
+        last = cpu.run_impl(mem, hooks, start_ra);
+        done += last.steps;
+        return last.step_limit && n == len;
+    };
+
+    for (bool running = true; running; ) {
+        intervals_.emplace_back();
+        Interval& iv = intervals_.back();
+        iv.start = done;
+
+        running = phase(fast, cfg_.fast_forward) && phase(cached, cfg_.warmup);
+        if (running) {
+            const CacheStats lru0 = lru.stats(), bplru0 = bplru.stats();
+            const uint64_t detail0 = done;
+            running = phase(cached, cfg_.detail);
+            iv.detail = done - detail0;
+            iv.measured = iv.detail > 0;
+            iv.lru   = delta(lru.stats(), lru0);
+            iv.bplru = delta(bplru.stats(), bplru0);
+        }
+        if (done == iv.start) intervals_.pop_back(); // программа кончилась на границе
+        else close_interval(done - iv.start);
+    }
+
+    last.steps = done;
+    return last;
+}
+
+std::vector<std::pair<std::size_t, double>> SampledRun::pick_simpoints() const {
+    const std::size_t n = intervals_.size();
+    const std::size_t k = std::min<std::size_t>(cfg_.simpoints, n);
+    if (k == 0) return {};
+
+    // нормированные BBV в случайной проекции
+    std::vector<Point> pts(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        pts[i].fill(0.0);
+        for (auto [id, cnt] : intervals_[i].bbv) {
+            const double w = static_cast<double>(cnt) / static_cast<double>(intervals_[i].insns);
+            for (std::size_t d = 0; d < PROJ_DIMS; ++d) pts[i][d] += w * projection(id, d);
+        }
+    }
+
+    // k-means++ с фиксированным зерном — результат воспроизводим
+    std::mt19937_64 rng(0x51397017ULL);
+    auto uniform = [&] { return static_cast<double>(rng() >> 11) / static_cast<double>(uint64_t{1} << 53); };
+    std::vector<Point> centers{pts[rng() % n]};
+    // Новый центр заводится, только если какой-то интервал отличается от всех центров
+    // заметно (порядка 5% состава): иначе одинаковые фазы дробятся на шуме границ окон.
+    const double min_spread = static_cast<double>(PROJ_DIMS) * 0.05 * 0.05;
+    std::vector<double> nearest(n);
+    while (centers.size() < k) {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            nearest[i] = std::numeric_limits<double>::infinity();
+            for (const auto& c : centers) nearest[i] = std::min(nearest[i], dist2(pts[i], c));
+            sum += nearest[i];
+        }
+        if (*std::max_element(nearest.begin(), nearest.end()) < min_spread) break;
+        double x = uniform() * sum;
+        std::size_t pick = n - 1;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (x < nearest[i]) { pick = i; break; }
+            x -= nearest[i];
+        }
+        centers.push_back(pts[pick]);
+    }
+
+    // Ллойд
+    std::vector<std::size_t> cluster(n, 0);
+    for (int iter = 0; iter < 100; ++iter) {
+        bool changed = iter == 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t best = 0;
+            for (std::size_t c = 1; c < centers.size(); ++c)
+                if (dist2(pts[i], centers[c]) < dist2(pts[i], centers[best])) best = c;
+            if (best != cluster[i]) { cluster[i] = best; changed = true; }
+        }
+        if (!changed) break;
+        std::vector<Point> sum(centers.size());
+        std::vector<std::size_t> size(centers.size(), 0);
+        for (auto& s : sum) s.fill(0.0);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t d = 0; d < PROJ_DIMS; ++d) sum[cluster[i]][d] += pts[i][d];
+            ++size[cluster[i]];
+        }
+        for (std::size_t c = 0; c < centers.size(); ++c) {
+            if (size[c] == 0) continue; // пустой кластер остаётся на месте
+            for (std::size_t d = 0; d < PROJ_DIMS; ++d) centers[c][d] = sum[c][d] / static_cast<double>(size[c]);
+        }
+    }
+
+    // Представитель — ближайший к центру интервал с окном detail; вес — доля инструкций кластера.
+    // Кластеры без измеренных интервалов (хвост программы) выпадают, веса перенормируются.
+    std::vector<std::pair<std::size_t, double>> picks;
+    double covered = 0;
+    for (std::size_t c = 0; c < centers.size(); ++c) {
+        std::size_t rep = n;
+        double best = std::numeric_limits<double>::infinity();
+        uint64_t insns = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (cluster[i] != c) continue;
+            insns += intervals_[i].insns;
+            if (intervals_[i].measured && dist2(pts[i], centers[c]) < best) { best = dist2(pts[i], centers[c]); rep = i; }
+        }
+        if (rep == n) continue;
+        picks.emplace_back(rep, static_cast<double>(insns));
+        covered += static_cast<double>(insns);
+    }
+    for (auto& p : picks) p.second /= covered;
+    std::sort(picks.begin(), picks.end());
+    return picks;
+}
+
+void SampledRun::report(std::FILE* out) const {
+    std::size_t measured = 0;
+    uint64_t detail_insns = 0;
+    for (const auto& iv : intervals_) {
+        if (!iv.measured) continue;
+        ++measured;
+        detail_insns += iv.detail;
+    }
+    const uint64_t period = cfg_.fast_forward + cfg_.warmup + cfg_.detail;
+    std::fprintf(out, "sampling: %zu intervals of %llu instructions (fast-forward %llu, warm-up %llu, detail %llu)\n",
+                 intervals_.size(), static_cast<unsigned long long>(period),
+                 static_cast<unsigned long long>(cfg_.fast_forward), static_cast<unsigned long long>(cfg_.warmup),
+                 static_cast<unsigned long long>(cfg_.detail));
+    std::fprintf(out, "instructions: %llu total, %llu in %zu detail windows (%.2f%%)\n",
+                 static_cast<unsigned long long>(total_), static_cast<unsigned long long>(detail_insns), measured,
+                 total_ ? 100.0 * static_cast<double>(detail_insns) / static_cast<double>(total_) : 0.0);
+
+    // оценка по всем окнам, ± полуширина 95% интервала
+    std::fprintf(out, "replacement\thit rate\thit rate (inst)\thit rate (data)\n");
+    for (int p = 0; p < 2; ++p) {
+        std::fprintf(out, p == 0 ? "        LRU" : "      bpLRU");
+        for (int c = 0; c < COLUMNS; ++c) {
+            std::vector<std::pair<uint64_t, uint64_t>> windows;
+            for (const auto& iv : intervals_)
+                if (iv.measured) windows.push_back(column(p == 0 ? iv.lru : iv.bplru, c));
+            std::fprintf(out, "\t");
+            print_estimate(out, ratio_estimate(windows));
+        }
+        std::fprintf(out, "\n");
+    }
+
+    // SimPoint: по представителю на кластер
+    const auto picks = pick_simpoints();
+    if (picks.empty()) return;
+    std::fprintf(out, "simpoints: %zu of %zu intervals\n", picks.size(), intervals_.size());
+    std::fprintf(out, "interval\tstart\tweight\n");
+    for (auto [rep, w] : picks)
+        std::fprintf(out, "%8zu\t%llu\t%.5f\n", rep, static_cast<unsigned long long>(intervals_[rep].start), w);
+    std::fprintf(out, "replacement\thit rate\thit rate (inst)\thit rate (data)\n");
+    for (int p = 0; p < 2; ++p) {
+        std::fprintf(out, p == 0 ? "        LRU" : "      bpLRU");
+        for (int c = 0; c < COLUMNS; ++c) {
+            // представитель без обращений этого вида не участвует, веса перенормируются
+            double rate = 0, wsum = 0;
+            for (auto [rep, w] : picks) {
+                const Interval& iv = intervals_[rep];
+                auto [hits, acc] = column(p == 0 ? iv.lru : iv.bplru, c);
+                if (acc == 0) continue;
+                rate += w * static_cast<double>(hits) / static_cast<double>(acc);
+                wsum += w;
+            }
+            std::fprintf(out, "\t");
+            print_estimate(out, {wsum > 0 ? rate / wsum : std::numeric_limits<double>::quiet_NaN(),
+                                 std::numeric_limits<double>::quiet_NaN()});
+        }
+        std::fprintf(out, "\n");
+    }
+}
+
+bool SampledRun::write_bbv(const std::string& path, std::string& err) const {
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) { err = "cannot open " + path; return false; }
+    for (const auto& iv : intervals_) {
+        std::fputc('T', f);
+        for (auto [id, cnt] : iv.bbv) std::fprintf(f, ":%u:%llu ", id + 1, static_cast<unsigned long long>(cnt));
+        std::fputc('\n', f);
+    }
+    if (std::fclose(f) != 0) { err = "error writing " + path; return false; }
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "cache.hpp"
+#include "cpu.hpp"
+#include "memory.hpp"
+
+// Выборочная симуляция. Исполнение режется на интервалы по
+// fast_forward + warmup + detail инструкций:
+//   fast_forward — только функциональное исполнение, кэши не трогаются;
+//   warmup       — обращения идут в кэши, но не учитываются (догреваем состояние);
+//   detail       — измерение: прирост счётчиков LRU/bpLRU за окно.
+// По окнам считается оценка hit rate на весь прогон с 95% доверительным интервалом.
+// Для каждого интервала собирается вектор базовых блоков (BBV); интервалы
+// кластеризуются k-means по случайной проекции BBV (как в SimPoint), и оценка
+// повторяется по одному представителю на кластер с весом кластера.
+class SampledRun {
+public:
+    struct Config {
+        uint64_t fast_forward = 900'000;
+        uint64_t warmup       = 50'000;
+        uint64_t detail       = 50'000;
+        unsigned simpoints    = 10;    // максимум кластеров
+    };
+
+    explicit SampledRun(const Config& cfg) : cfg_(cfg) {}
+
+    // Исполнить не больше budget инструкций; кэши продолжают своё состояние
+    ExecResult run(CPU& cpu, Memory& mem, LRUCache& lru, BpLRUCache& bplru,
+                   uint32_t start_ra, uint64_t budget);
+
+    void report(std::FILE* out) const;
+    // BBV в формате SimPoint (.bb): "T:id:count :id:count ..." по строке на интервал
+    bool write_bbv(const std::string& path, std::string& err) const;
+
+    // обращения по вектору базовых блоков (хук CPU::run_impl)
+    void block(uint32_t start_pc, uint64_t n);
+
+private:
+    struct Interval {
+        uint64_t start = 0;          // номер первой инструкции
+        uint64_t insns = 0;
+        uint64_t detail = 0;         // из них в окне detail
+        bool     measured = false;
+        CacheStats lru, bplru;       // прирост за окно detail
+        std::vector<std::pair<uint32_t, uint64_t>> bbv; // id блока -> инструкций
+    };
+
+    void close_interval(uint64_t insns);
+    // (интервал-представитель, вес) по возрастанию номера интервала
+    std::vector<std::pair<std::size_t, double>> pick_simpoints() const;
+
+    Config cfg_;
+    std::vector<Interval> intervals_;
+
+    std::unordered_map<uint32_t, uint32_t> block_ids_; // start_pc -> id
+    std::vector<uint64_t> counts_;                     // по id, текущий интервал
+    std::vector<uint32_t> touched_;                    // id с ненулевым counts_
+    uint64_t total_ = 0;
+};
@@ -0,0 +1,166 @@
+#include "stack_distance.hpp"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace {
+
+// Сколько моментов времени помещается в дерево до пересчёта
+constexpr std::size_t REUSE_WINDOW = std::size_t{1} << 22;
+
+std::size_t kind_index(AccessKind k) { return k == AccessKind::Inst ? 0 : 1; }
+
+}
+
+StackDistanceProfiler::StackDistanceProfiler() : bit_(REUSE_WINDOW + 1, 0) {
+    for (unsigned bits = 0; bits <= MAX_SET_BITS; ++bits) {
+        Geometry g;
+        g.set_bits = bits;
+        g.stacks.assign((std::size_t{1} << bits) * MAX_WAYS, EMPTY);
+        geometries_.push_back(std::move(g));
+    }
+}
+
+void StackDistanceProfiler::access(uint32_t addr, AccessKind k) {
+    const uint32_t line = addr >> CACHE_OFFSET_LEN;
+    const std::size_t ki = kind_index(k);
+
+    for (auto& g : geometries_) {
+        const uint32_t set = line & ((1u << g.set_bits) - 1u);
+        uint32_t* stack = &g.stacks[std::size_t{set} * MAX_WAYS];
+
+        // ищем линию, по пути сдвигая стек на одну позицию вниз
+        std::size_t d = 0;
+        uint32_t carry = line;
+        for (; d < MAX_WAYS; ++d) {
+            uint32_t cur = stack[d];
+            stack[d] = carry;
+            if (cur == line) break;
+            if (cur == EMPTY) { d = MAX_WAYS; break; }
+            carry = cur;
+        }
+        g.hist[ki][d]++;
+    }
+
+    reuse_access(line, k);
+}
+
+void StackDistanceProfiler::reuse_access(uint32_t line, AccessKind k) {
+    if (now_ + 1 == bit_.size()) compact();
+
+    std::size_t bucket = REUSE_BUCKETS - 1; // cold
+    auto it = last_access_.find(line);
+    if (it != last_access_.end()) {
+        // различных линий между прошлым и текущим обращением
+        const uint64_t distance = static_cast<uint64_t>(bit_sum(now_) - bit_sum(it->second));
+        bucket = distance == 0 ? 0 : static_cast<std::size_t>(std::bit_width(distance));
+        bit_add(it->second, -1);
+        it->second = now_;
+    } else {
+        last_access_.emplace(line, now_);
+    }
+    bit_add(now_, +1);
+    ++now_;
+
+    reuse_[kind_index(k)][bucket]++;
+}
+
+void StackDistanceProfiler::bit_add(std::size_t i, int64_t v) {
+    for (++i; i < bit_.size(); i += i & (~i + 1)) bit_[i] += v;
+}
+
+int64_t StackDistanceProfiler::bit_sum(std::size_t i) const {
+    int64_t s = 0;
+    for (++i; i > 0; i -= i & (~i + 1)) s += bit_[i];
+    return s;
+}
+
+void StackDistanceProfiler::compact() {
+    // перенумеровываем последние обращения подряд, порядок сохраняется
+    std::vector<std::pair<uint32_t, uint32_t>> order; // (момент, линия)
+    order.reserve(last_access_.size());
+    for (const auto& [line, t] : last_access_) order.emplace_back(t, line);
+    std::sort(order.begin(), order.end());
+
+    // живых линий слишком много — дереву нужно больше места
+    std::size_t size = bit_.size();
+    while (order.size() * 2 > size) size *= 2;
+    bit_.assign(size, 0);
+
+    now_ = 0;
+    for (const auto& [t, line] : order) {
+        last_access_[line] = now_;
+        bit_add(now_, +1);
+        ++now_;
+    }
+}
+
+double StackDistanceProfiler::hit_rate(std::size_t sets, std::size_t ways, AccessKind k) const {
+    const auto& g = geometries_[std::countr_zero(sets)];
+    const std::size_t ki = kind_index(k);
+
+    uint64_t hits = 0, total = 0;
+    for (std::size_t d = 0; d <= MAX_WAYS; ++d) {
+        total += g.hist[ki][d];
+        if (d < ways) hits += g.hist[ki][d];
+    }
+    return total ? 100.0 * hits / total : std::numeric_limits<double>::quiet_NaN();
+}
+
+double StackDistanceProfiler::hit_rate(std::size_t sets, std::size_t ways) const {
+    const auto& g = geometries_[std::countr_zero(sets)];
+
+    uint64_t hits = 0, total = 0;
+    for (std::size_t ki = 0; ki < 2; ++ki) {
+        for (std::size_t d = 0; d <= MAX_WAYS; ++d) {
+            total += g.hist[ki][d];
+            if (d < ways) hits += g.hist[ki][d];
+        }
+    }
+    return total ? 100.0 * hits / total : std::numeric_limits<double>::quiet_NaN();
+}
+
+void StackDistanceProfiler::report(std::FILE* out) const {
+    static const char* titles[] = {"all accesses", "instructions", "data"};
+
+    for (int t = 0; t < 3; ++t) {
+        std::fprintf(out, "\nLRU hit rate by geometry (%zu-byte lines), %s\n", CACHE_LINE_SIZE, titles[t]);
+        std::fprintf(out, "   sets");
+        for (std::size_t ways = 1; ways <= MAX_WAYS; ways *= 2) std::fprintf(out, "\t%zu-way", ways);
+        std::fprintf(out, "\n");
+
+        for (unsigned bits = 0; bits <= MAX_SET_BITS; ++bits) {
+            const std::size_t sets = std::size_t{1} << bits;
+            std::fprintf(out, "%7zu", sets);
+            for (std::size_t ways = 1; ways <= MAX_WAYS; ways *= 2) {
+                double rate = t == 0 ? hit_rate(sets, ways)
+                                     : hit_rate(sets, ways, t == 1 ? AccessKind::Inst : AccessKind::Data);
+                std::fprintf(out, "\t%3.5f%%", rate);
+            }
+            std::fprintf(out, "\n");
+        }
+    }
+
+    uint64_t total = 0;
+    for (std::size_t ki = 0; ki < 2; ++ki)
+        for (std::size_t b = 0; b < REUSE_BUCKETS; ++b) total += reuse_[ki][b];
+
+    std::fprintf(out, "\nreuse distance (distinct %zu-byte lines, fully associative)\n", CACHE_LINE_SIZE);
+    std::fprintf(out, "distance\tinst\tdata\tcumulative\n");
+    uint64_t cumulative = 0;
+    for (std::size_t b = 0; b < REUSE_BUCKETS; ++b) {
+        const uint64_t inst = reuse_[0][b], data = reuse_[1][b];
+        if (inst == 0 && data == 0) continue;
+        cumulative += inst + data;
+
+        char range[32];
+        if (b == REUSE_BUCKETS - 1) std::snprintf(range, sizeof(range), "cold");
+        else if (b <= 1)            std::snprintf(range, sizeof(range), "%zu", b);
+        else std::snprintf(range, sizeof(range), "%llu-%llu",
+                           1ULL << (b - 1), (1ULL << b) - 1);
+
+        std::fprintf(out, "%s\t%llu\t%llu\t%3.5f%%\n", range,
+                     static_cast<unsigned long long>(inst), static_cast<unsigned long long>(data),
+                     total ? 100.0 * cumulative / total : 0.0);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+#include "cache.hpp"
+
+// Профиль LRU по стековым расстояниям (алгоритм Маттсона) за один прогон.
+//
+// Для каждого числа наборов 1, 2, 4 ... 2^MAX_SET_BITS храним LRU-стек каждого
+// набора глубиной MAX_WAYS (линии по CACHE_LINE_SIZE байт). Обращение на глубине d
+// — попадание в любом LRU-кэше с > d путями и тем же числом наборов, так что одна
+// гистограмма даёт hit rate сразу для всех ассоциативностей до MAX_WAYS.
+// Отдельно считается гистограмма reuse distance для полностью ассоциативного
+// кэша без ограничения глубины (дерево Фенвика по времени обращений).
+//
+// Подключается как ещё одна модель в CacheList: read/write ничего не меняют в исполнении.
+class StackDistanceProfiler {
+public:
+    static constexpr unsigned    MAX_SET_BITS = 10;  // до 1024 наборов
+    static constexpr std::size_t MAX_WAYS     = 32;
+
+    StackDistanceProfiler();
+
+    bool read (uint32_t addr, std::size_t /*size*/, AccessKind k) { access(addr, k); return true; }
+    bool write(uint32_t addr, std::size_t /*size*/, AccessKind k) { access(addr, k); return true; }
+
+    // hit rate LRU-кэша sets x ways (sets — степень двойки), по виду обращения
+    double hit_rate(std::size_t sets, std::size_t ways, AccessKind k) const;
+    double hit_rate(std::size_t sets, std::size_t ways) const;
+
+    void report(std::FILE* out) const;
+
+private:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+    static constexpr std::size_t REUSE_BUCKETS = 34; // 0, 1, [2,3], [4,7] ... + cold
+
+    struct Geometry {
+        unsigned set_bits = 0;
+        std::vector<uint32_t> stacks;                  // sets * MAX_WAYS, MRU первым
+        uint64_t hist[2][MAX_WAYS + 1] = {};           // [kind][глубина], MAX_WAYS — промах
+    };
+
+    void access(uint32_t addr, AccessKind k);
+    void reuse_access(uint32_t line, AccessKind k);
+
+    // дерево Фенвика по моментам последних обращений
+    void bit_add(std::size_t i, int64_t v);
+    int64_t bit_sum(std::size_t i) const; // сумма [0, i]
+    void compact();
+
+    std::vector<Geometry> geometries_;
+
+    std::unordered_map<uint32_t, uint32_t> last_access_; // линия -> момент
+    std::vector<int64_t> bit_;
+    uint32_t now_ = 0;
+    uint64_t reuse_[2][REUSE_BUCKETS] = {};
+};
@@ -0,0 +1,111 @@
+#include "trace.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace trace_detail;
+
+// ---------------- запись ----------------
+
+TraceWriter::~TraceWriter() {
+    std::string err;
+    close(err);
+}
+
+bool TraceWriter::open(const std::string& path, std::string& err) {
+    f_ = std::fopen(path.c_str(), "wb");
+    if (!f_) { err = "cannot open trace file: " + path; return false; }
+    buf_.reserve(BUFFER_SIZE);
+    buf_.insert(buf_.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    return true;
+}
+
+void TraceWriter::emit_pending() {
+    put(static_cast<uint8_t>(pending_tag_ | (pending_repeat_ << TAG_REPEAT_SHIFT)));
+    if (pending_tag_ & TAG_DELTA) {
+        // zigzag: маленькие смещения в обе стороны — короткий varint
+        const int32_t d = static_cast<int32_t>(pending_delta_);
+        uint32_t z = (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+        while (z >= 0x80) { put(static_cast<uint8_t>(z | 0x80)); z >>= 7; }
+        put(static_cast<uint8_t>(z));
+    }
+    pending_ = false;
+}
+
+void TraceWriter::flush_buffer() {
+    if (f_ && !buf_.empty() && std::fwrite(buf_.data(), 1, buf_.size(), f_) != buf_.size()) io_error_ = true;
+    buf_.clear();
+}
+
+bool TraceWriter::close(std::string& err) {
+    if (!f_) return true;
+    if (pending_) emit_pending();
+    flush_buffer();
+    if (std::fclose(f_) != 0) io_error_ = true;
+    f_ = nullptr;
+    if (io_error_) { err = "error writing trace file"; return false; }
+    return true;
+}
+
+// ---------------- чтение ----------------
+
+TraceReader::~TraceReader() {
+    if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+bool TraceReader::open(const std::string& path, std::string& err) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { err = "cannot open trace file: " + path; return false; }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) { ::close(fd); err = "cannot stat trace file: " + path; return false; }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ < sizeof(MAGIC)) { ::close(fd); err = "not a trace file: " + path; return false; }
+
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { err = "cannot mmap trace file: " + path; return false; }
+    data_ = static_cast<const uint8_t*>(p);
+    madvise(p, size_, MADV_SEQUENTIAL);
+
+    if (std::memcmp(data_, MAGIC, sizeof(MAGIC)) != 0) { err = "not a trace file: " + path; return false; }
+    return true;
+}
+
+bool TraceReader::decode(Cursor& c, std::vector<TraceRecord>& out, std::size_t max_records) const {
+    out.clear();
+    while (c.pos < size_ && out.size() + MAX_REPEAT + 1 <= max_records) {
+        const uint8_t tag = data_[c.pos++];
+        const unsigned ki = tag & TAG_DATA ? 1 : 0;
+
+        uint32_t delta = 0;
+        if (tag & TAG_DELTA) {
+            uint32_t z = 0;
+            unsigned shift = 0;
+            for (;;) {
+                if (c.pos >= size_ || shift > 28) return false;
+                const uint8_t b = data_[c.pos++];
+                z |= static_cast<uint32_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) break;
+                shift += 7;
+            }
+            delta = (z >> 1) ^ (0u - (z & 1u));
+        }
+
+        TraceRecord r;
+        r.kind     = ki ? AccessKind::Data : AccessKind::Inst;
+        r.is_write = tag & TAG_WRITE;
+        r.size     = static_cast<uint8_t>(1u << ((tag >> TAG_SIZE_SHIFT) & 3u));
+
+        uint32_t addr = c.next[ki] + delta;
+        for (unsigned n = 0; n <= (tag >> TAG_REPEAT_SHIFT); ++n) {
+            r.addr = addr;
+            out.push_back(r);
+            addr += r.size;
+        }
+        c.next[ki] = addr;
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "cache.hpp"
+
+// Бинарная трасса обращений к памяти: одна эмуляция, дальше сколько угодно
+// конфигураций кэша прогоняется по трассе офлайн (riscv-replay).
+//
+// Формат: 8 байт "RVTRACE1", затем записи. Каждая запись начинается с байта-тега:
+//   бит 0    — вид (0 — выборка инструкции, 1 — данные)
+//   бит 1    — запись
+//   биты 2-3 — log2(размер)
+//   бит 4    — дальше идёт varint (zigzag) смещения адреса от предсказанного
+//   биты 5-7 — сколько ещё таких же обращений подряд идёт по предсказанным адресам
+// Предсказанный адрес — конец предыдущего обращения того же вида, поэтому
+// линейный код занимает байт на восемь выборок.
+
+struct TraceRecord {
+    uint32_t   addr;
+    uint8_t    size;
+    AccessKind kind;
+    bool       is_write;
+};
+
+namespace trace_detail {
+
+inline constexpr char MAGIC[8] = {'R','V','T','R','A','C','E','1'};
+
+inline constexpr uint8_t TAG_DATA    = 1u << 0;
+inline constexpr uint8_t TAG_WRITE   = 1u << 1;
+inline constexpr unsigned TAG_SIZE_SHIFT = 2;
+inline constexpr uint8_t TAG_DELTA   = 1u << 4;
+inline constexpr unsigned TAG_REPEAT_SHIFT = 5;
+inline constexpr unsigned MAX_REPEAT = 7;
+
+}
+
+// Пишет трассу; подключается как ещё одна модель в CacheList
+class TraceWriter {
+public:
+    TraceWriter() = default;
+    ~TraceWriter();
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    bool open(const std::string& path, std::string& err);
+    // дописать хвост и закрыть файл
+    bool close(std::string& err);
+
+    bool read (uint32_t addr, std::size_t size, AccessKind k) { append(addr, size, k, false); return true; }
+    bool write(uint32_t addr, std::size_t size, AccessKind k) { append(addr, size, k, true);  return true; }
+
+    uint64_t records() const { return records_; }
+
+private:
+    static constexpr std::size_t BUFFER_SIZE = std::size_t{1} << 20;
+
+    void append(uint32_t addr, std::size_t size, AccessKind k, bool is_write) {
+        using namespace trace_detail;
+        ++records_;
+        const unsigned ki = k == AccessKind::Inst ? 0 : 1;
+        const uint8_t tag = static_cast<uint8_t>((ki ? TAG_DATA : 0) | (is_write ? TAG_WRITE : 0)
+                          | (std::countr_zero(static_cast<unsigned>(size)) << TAG_SIZE_SHIFT));
+
+        // продолжение текущей серии
+        if (pending_ && tag == (pending_tag_ & ~TAG_DELTA) && addr == next_[ki]
+            && pending_repeat_ < MAX_REPEAT) {
+            ++pending_repeat_;
+            next_[ki] = addr + static_cast<uint32_t>(size);
+            return;
+        }
+        if (pending_) emit_pending();
+
+        pending_ = true;
+        pending_tag_ = tag;
+        pending_repeat_ = 0;
+        pending_delta_ = addr - next_[ki];
+        if (pending_delta_ != 0) pending_tag_ |= TAG_DELTA;
+        next_[ki] = addr + static_cast<uint32_t>(size);
+    }
+
+    void emit_pending();
+    void put(uint8_t b) {
+        if (buf_.size() == BUFFER_SIZE) flush_buffer();
+        buf_.push_back(b);
+    }
+    void flush_buffer();
+
+    std::FILE* f_ = nullptr;
+    bool io_error_ = false;
+    std::vector<uint8_t> buf_;
+
+    uint32_t next_[2] = {0, 0};   // предсказанный адрес по виду обращения
+    bool     pending_ = false;
+    uint8_t  pending_tag_ = 0;
+    unsigned pending_repeat_ = 0;
+    uint32_t pending_delta_ = 0;
+    uint64_t records_ = 0;
+};
+
+// Читает трассу через mmap
+class TraceReader {
+public:
+    TraceReader() = default;
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    bool open(const std::string& path, std::string& err);
+
+    // Раскодировать записи в out порциями до max_records штук.
+    // Состояние — в Cursor, так что несколько потоков читают один файл независимо.
+    struct Cursor {
+        std::size_t pos = sizeof(trace_detail::MAGIC);
+        uint32_t next[2] = {0, 0};
+    };
+    // false — трасса повреждена; конец трассы — пустой out
+    bool decode(Cursor& c, std::vector<TraceRecord>& out, std::size_t max_records) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+};